@@ -8,9 +8,11 @@ solver for timeline optimization.
 
 import ctypes
 import os
+import array
 import json
 import logging
-from ctypes import Structure, c_int, c_bool, c_char, POINTER, byref
+import threading
+from ctypes import Structure, c_int, c_bool, c_char, c_char_p, c_int32, c_int64, c_uint64, c_size_t, c_void_p, POINTER, byref, CFUNCTYPE
 from pathlib import Path
 from typing import List, Dict, Any, Optional
 from dataclasses import dataclass
@@ -27,9 +29,13 @@ logger = logging.getLogger(__name__)
 
 MAX_TITLE_LEN = 200
 MAX_SUBJECT_LEN = 20
-SLOTS_PER_DAY = 48  # 30-minute slots per day
-WEEK_SLOTS = 336    # 7 days * 48 slots
-MAX_TASKS = 100
+SLOTS_PER_DAY = 48  # Default granularity: 30-minute slots per day
+WEEK_SLOTS = 336    # Default horizon: 7 days * 48 slots
+MINUTES_PER_DAY = 1440
+MAX_HORIZON_WEEKS = 4
+MAX_SLOTS_PER_DAY = 96  # 15-minute slots
+MAX_SLOTS = MAX_HORIZON_WEEKS * 7 * MAX_SLOTS_PER_DAY
+OCC_WORDS = (MAX_SLOTS + 63) // 64  # 64-bit words per slot bitmap (largest grid)
 
 
 # ============================================
@@ -53,6 +59,13 @@ class TaskCategory(IntEnum):
     LAB_WORK = 9         # Lab report work
 
 
+class SearchMode(IntEnum):
+    """Search strategy matching C SearchMode."""
+    GREEDY = 0             # Single greedy pass
+    BRANCH_AND_BOUND = 1   # Anytime branch-and-bound seeded by greedy
+    PORTFOLIO = 2          # Orders and searches raced on the engine threads
+
+
 # ============================================
 # CTYPES STRUCTURES
 # ============================================
@@ -128,6 +141,8 @@ class OptimizationConfig(Structure):
         ("deep_work_min_slots", c_int),
         ("micro_gap_max_slots", c_int),
         ("enable_heuristics", c_bool),
+        ("horizon_weeks", c_int),   # 1-MAX_HORIZON_WEEKS (0 = 1)
+        ("slot_minutes", c_int),    # 15, 30 or 60 (0 = 30)
     ]
     
     @classmethod
@@ -143,23 +158,109 @@ class OptimizationConfig(Structure):
         config.deep_work_min_slots = data.get('deep_work_min_slots', 3)
         config.micro_gap_max_slots = data.get('micro_gap_max_slots', 1)
         config.enable_heuristics = data.get('enable_heuristics', True)
+        config.horizon_weeks = data.get('horizon_weeks', 1)
+        config.slot_minutes = data.get('slot_minutes', MINUTES_PER_DAY // SLOTS_PER_DAY)
         return config
 
 
+class EngineProgress(Structure):
+    """Matches C EngineProgress struct (argument of a progress callback)."""
+    _fields_ = [
+        ("phase", c_int),           # EnginePhase: 0 greedy, 1 search, 2 local search, 3 batch
+        ("elapsed_us", c_int64),
+        ("work", c_int64),          # Tasks tried, search nodes, moves or solved users
+        ("placed", c_int),
+        ("task_count", c_int),      # Users for a batch
+    ]
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Convert to Python dictionary."""
+        return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+# int (*EngineProgressFn)(const EngineProgress*, void*): nonzero cancels
+PROGRESS_FN = CFUNCTYPE(c_int, POINTER(EngineProgress), c_void_p)
+
+
+class CancelToken:
+    """
+    Cancel flag polled by the engine while a solve runs. Pass it as
+    options["cancel"] and call cancel() from any other thread; the solve
+    returns its best result so far with status -2.
+    """
+    
+    def __init__(self):
+        self._flag = c_int32(0)
+    
+    def cancel(self):
+        self._flag.value = 1
+    
+    @property
+    def cancelled(self) -> bool:
+        return self._flag.value != 0
+    
+    def reset(self):
+        self._flag.value = 0
+    
+    @property
+    def pointer(self):
+        return ctypes.pointer(self._flag)
+
+
+class SolveOptions(Structure):
+    """
+    Matches C SolveOptions struct.
+    Selects the search mode and its budget.
+    """
+    _fields_ = [
+        ("search_mode", c_int),     # SearchMode enum value
+        ("time_limit_ms", c_int),   # Search wall-clock budget (0 = unlimited)
+        ("node_limit", c_int64),    # Max search nodes (0 = unlimited)
+        ("improve_iterations", c_int64),  # Local-search moves after the solve (0 = no limit)
+        ("improve_time_us", c_int64),     # Local-search budget in microseconds (0 = no limit)
+        ("deadline_us", c_int64),   # engine_clock_us() time to stop at (0 = none)
+        ("cancel", POINTER(c_int32)),     # Cancel flag (NULL = none)
+        ("progress", PROGRESS_FN),  # Progress callback (NULL = none)
+        ("progress_user", c_void_p),
+        ("progress_interval_ms", c_int),  # Min time between reports (0 = 100 ms)
+    ]
+    
+    @classmethod
+    def from_dict(cls, data: Dict[str, Any]) -> 'SolveOptions':
+        """Create from Python dictionary."""
+        options = cls()
+        options.search_mode = data.get('search_mode', SearchMode.GREEDY)
+        options.time_limit_ms = data.get(
+            'time_limit_ms', get_engine_config().search_time_limit_ms
+        )
+        options.node_limit = data.get('node_limit', 0)
+        options.improve_iterations = data.get('improve_iterations', 0)
+        options.improve_time_us = data.get('improve_time_us', 0)
+        options.deadline_us = data.get('deadline_us', 0)
+        options.progress_interval_ms = data.get('progress_interval_ms', 0)
+        return options
+
+
 class WeeklyTimeline(Structure):
     """
     Matches C WeeklyTimeline struct.
     Represents the optimized weekly schedule.
     """
     _fields_ = [
-        ("slots", c_int * WEEK_SLOTS),  # Task ID in each slot (-1 = empty)
-        ("slot_count", c_int),
+        ("slots", POINTER(c_int)),     # Task ID in each slot (-1 = empty), slot_count of them
+        ("slot_capacity", c_int),      # Ints of storage behind slots
+        ("slot_count", c_int),         # Slots in the horizon
+        ("slots_per_day", c_int),
+        ("occ_words", c_int),          # Words of each mask in use
         ("tasks", POINTER(TimelineTask)),
         ("task_count", c_int),
         ("optimization_status", c_int),  # 0=success, -1=unsolvable, -2=timeout
         ("error_code", c_int),
         ("total_gaps_filled", c_int),
         ("total_conflicts", c_int),
+        ("free_mask", c_uint64 * OCC_WORDS),   # Bit set = slot is empty
+        ("sleep_mask", c_uint64 * OCC_WORDS),  # Bit set = slot is in sleep window
+        ("solve_strategy", c_int),  # Portfolio strategy that won (-1 = not a portfolio solve)
     ]
 
 
@@ -174,10 +275,170 @@ class ScheduleGap(Structure):
     ]
 
 
+GAP_TYPES = ("micro", "standard", "deep_work")
+
+
+class ArenaStats(Structure):
+    """Matches C ArenaStats struct (engine context memory usage)."""
+    _fields_ = [
+        ("bytes_used", c_size_t),       # Allocated since the last reset
+        ("high_water", c_size_t),       # Largest bytes_used ever seen
+        ("bytes_reserved", c_size_t),   # Total size of all blocks held
+        ("block_count", c_size_t),
+        ("alloc_count", c_size_t),      # Allocations since the last reset
+        ("reset_count", c_size_t),
+    ]
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Convert to Python dictionary."""
+        return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+class EngineStats(Structure):
+    """Matches C EngineStats struct (solver counters and phase timings)."""
+    _fields_ = [
+        ("solves", c_int64),            # Solves, timeline_open, incremental edits and what-if calls
+        ("can_place_calls", c_int64),
+        ("slots_scanned", c_int64),     # Candidate start slots scored
+        ("placements", c_int64),
+        ("backtracks", c_int64),        # Branch-and-bound levels exhausted
+        ("cache_hits", c_int64),
+        ("cache_misses", c_int64),
+        ("arena_bytes", c_int64),       # Context arena in use after the solve
+        ("setup_us", c_int64),          # Cache lookup, task set and score tables
+        ("sleep_us", c_int64),          # Sleep blocking (or base copy)
+        ("locked_us", c_int64),         # Locked-task placement
+        ("search_us", c_int64),         # Feasibility check, search and local search
+        ("gap_scan_us", c_int64),       # find_gaps calls
+    ]
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Convert to Python dictionary."""
+        return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+class ConstraintViolation(Structure):
+    """Matches C ConstraintViolation struct (one validate_constraints_ex entry)."""
+    _fields_ = [
+        ("code", c_int),            # ViolationCode
+        ("task_id", c_int),
+        ("start_slot", c_int),      # Slot range [start_slot, end_slot)
+        ("end_slot", c_int),
+        ("other_id", c_int),        # Task or slot value involved (-1 = none)
+    ]
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to Python dictionary."""
+        return {
+            "type": VIOLATION_TYPES.get(self.code, f"unknown_{self.code}"),
+            "task_id": self.task_id,
+            "start_slot": self.start_slot,
+            "end_slot": self.end_slot,
+            "other_id": self.other_id,
+        }
+
+
+# ViolationCode names
+VIOLATION_TYPES = {
+    1: "overlap",
+    2: "deadline_violation",
+    3: "blocked_slot",
+    4: "locked_moved",
+    5: "out_of_bounds",
+    6: "slot_mismatch",
+}
+
+# Violations copied out of one validate_constraints_ex call
+MAX_VIOLATIONS = 256
+
+
+class WhatIfResult(Structure):
+    """Matches C WhatIfResult struct (one timeline_what_if candidate)."""
+    _fields_ = [
+        ("task_id", c_int),
+        ("best_slot", c_int),       # Slot the candidate would get (-1 = conflict)
+        ("score_delta", c_int),     # Change in placement score
+        ("conflicts", c_int),       # Change in conflicts (negative = one resolved)
+        ("moved", c_int),           # Placed tasks moved to make room
+    ]
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Convert to Python dictionary."""
+        return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+class FeasibilityReport(Structure):
+    """Matches C FeasibilityReport struct (capacity verdict before a solve)."""
+    _fields_ = [
+        ("feasible", c_int),            # 1 = passes (necessary, not sufficient)
+        ("demand_slots", c_int),        # Slots wanted by the tasks left to place
+        ("capacity_slots", c_int),      # Free slots outside sleep after locked tasks
+        ("shortfall_slots", c_int),     # Most any deadline is over capacity by
+        ("first_overflow_slot", c_int), # Earliest overflowing deadline (-1 = none)
+        ("drop_count", c_int),          # Fewest tasks to drop or move past their deadline
+    ]
+    
+    def to_dict(self) -> Dict[str, Any]:
+        """Convert to Python dictionary."""
+        data = {name: getattr(self, name) for name, _ in self._fields_}
+        data["feasible"] = bool(self.feasible)
+        return data
+
+
+class EngineCacheStats(Structure):
+    """Matches C EngineCacheStats struct (result cache counters)."""
+    _fields_ = [
+        ("hits", c_int64),
+        ("misses", c_int64),
+        ("evictions", c_int64),         # Entries replaced to make room
+        ("entries", c_int),             # Results held now
+        ("capacity", c_int),            # 0 = cache off
+    ]
+    
+    def to_dict(self) -> Dict[str, int]:
+        """Convert to Python dictionary."""
+        return {name: getattr(self, name) for name, _ in self._fields_}
+
+
+class ResultView(Structure):
+    """Matches C ResultView struct (flat result arrays in input order)."""
+    _fields_ = [
+        ("slots", POINTER(c_int)),      # The timeline's own slot grid
+        ("slot_count", c_int),
+        ("task_ids", POINTER(c_int)),
+        ("assigned", POINTER(c_int)),   # assigned_slot of each task
+        ("task_count", c_int),
+        ("conflicts", POINTER(c_int)),  # Ids of tasks left unplaced
+        ("conflict_count", c_int),
+        ("changed", POINTER(c_int)),    # Input indices whose assigned_slot changed
+        ("changed_count", c_int),
+    ]
+
+
+def _int_view(ptr, count: int) -> memoryview:
+    """Wrap count C ints at ptr as an 'i' memoryview without copying."""
+    if count <= 0 or not ptr:
+        return memoryview(b'').cast('i')
+    buffer = (c_int * count).from_address(ctypes.addressof(ptr.contents))
+    return memoryview(buffer).cast('B').cast('i')
+
+
 # ============================================
 # OPTIMIZATION RESULT
 # ============================================
 
+STATUS_MESSAGES = {
+    0: "Optimization successful",
+    -1: "Schedule unsolvable - too many tasks for available slots",
+    -2: "Optimization timeout",
+}
+
+# error_code of a status -2 solve stopped by its options (EngineError)
+STOP_MESSAGES = {
+    3: "Optimization cancelled",
+    4: "Optimization deadline reached",
+}
+
 @dataclass
 class OptimizationResult:
     """Result of timeline optimization."""
@@ -189,6 +450,8 @@ class OptimizationResult:
     gaps_filled: int
     conflicts: int
     execution_time_ms: float
+    strategy: Optional[str] = None  # Winning portfolio strategy
+    violations: Optional[List[Dict[str, Any]]] = None  # Set when solves are validated
     
     def to_dict(self) -> Dict[str, Any]:
         """Convert to dictionary."""
@@ -201,9 +464,182 @@ class OptimizationResult:
             "gaps_filled": self.gaps_filled,
             "conflicts": self.conflicts,
             "execution_time_ms": self.execution_time_ms,
+            "strategy": self.strategy,
+            "violations": self.violations,
         }
 
 
+@dataclass
+class SolveView:
+    """
+    Result of optimize_timeline_view.
+    
+    slots, task_ids, assigned and conflicts are int32 memoryviews (usable
+    with numpy.frombuffer). From the C engine they alias its memory and
+    are only valid until the next solve on the same thread; copy them
+    (e.g. with .tolist()) to keep them longer.
+    """
+    success: bool
+    status_code: int
+    status_message: str
+    slots: memoryview
+    task_ids: memoryview
+    assigned: memoryview            # assigned_slot per task, input order
+    conflicts: memoryview           # Ids of tasks left unplaced
+    changed: Dict[int, Dict[str, int]]  # task id -> fields that changed
+    gaps_filled: int
+    execution_time_ms: float
+
+
+# ============================================
+# INCREMENTAL TIMELINE SESSION
+# ============================================
+
+class TimelineSession:
+    """
+    A solved timeline kept open in the C engine for incremental edits.
+    
+    Inserting or removing one task repairs only the affected slots instead
+    of re-solving the whole week. Close the session (or use it as a
+    context manager) to release the engine-side handle.
+    
+    Usage:
+        with engine.open_timeline(tasks) as session:
+            slot = session.insert_task(new_task)
+            session.remove_task(old_id)
+            result = session.result()
+    """
+    
+    def __init__(self, lib: ctypes.CDLL, handle: int):
+        self._lib = lib
+        self._handle = handle
+    
+    def insert_task(self, task: Dict[str, Any]) -> int:
+        """
+        Add a task to the open timeline.
+        
+        Returns:
+            Assigned slot, or -1 if it could not be placed (kept as a conflict)
+            
+        Raises:
+            ValueError: if a task with the same id is already present
+            MemoryError: if the engine could not grow its task storage
+        """
+        c_task = TimelineTask.from_dict(task)
+        rc = self._lib.timeline_insert_task(self._require_handle(), byref(c_task))
+        if rc == -2:
+            raise ValueError(f"Task {c_task.id} is already in the timeline")
+        if rc == -3:
+            raise MemoryError("C engine could not grow the timeline")
+        return rc
+    
+    def remove_task(self, task_id: int) -> bool:
+        """Remove a task by id. Returns False if no such task exists."""
+        return self._lib.timeline_remove_task(self._require_handle(), task_id) == 0
+    
+    def what_if(self, candidates: List[Dict[str, Any]]) -> List[Dict[str, int]]:
+        """
+        Evaluate candidate edits without applying them.
+        
+        A candidate with the id of a task in the timeline replaces it;
+        any other id is inserted. All candidates run in one engine call,
+        in parallel.
+        
+        Returns:
+            One dict per candidate: task_id, best_slot (-1 = it would be a
+            conflict), score_delta, conflicts (change in unplaced tasks)
+            and moved (tasks moved to make room)
+        """
+        if not hasattr(self._lib, 'timeline_what_if'):
+            raise RuntimeError("C engine has no timeline_what_if")
+        
+        task_array = (TimelineTask * max(len(candidates), 1))()
+        for i, task in enumerate(candidates):
+            task_array[i] = TimelineTask.from_dict(task)
+        out = (WhatIfResult * max(len(candidates), 1))()
+        
+        if self._lib.timeline_what_if(self._require_handle(), task_array, len(candidates), out) != 0:
+            raise RuntimeError("timeline_what_if failed")
+        return [out[i].to_dict() for i in range(len(candidates))]
+    
+    def result(self) -> OptimizationResult:
+        """Snapshot of the current timeline."""
+        timeline = self._lib.timeline_get(self._require_handle()).contents
+        return OptimizationResult(
+            success=timeline.optimization_status == 0,
+            status_code=timeline.optimization_status,
+            status_message=STATUS_MESSAGES.get(
+                timeline.optimization_status,
+                f"Unknown status: {timeline.optimization_status}"
+            ),
+            slots=list(timeline.slots[:timeline.slot_count]),
+            tasks=[timeline.tasks[i].to_dict() for i in range(timeline.task_count)],
+            gaps_filled=timeline.total_gaps_filled,
+            conflicts=timeline.total_conflicts,
+            execution_time_ms=0.0
+        )
+    
+    def close(self):
+        """Release the engine-side timeline."""
+        if self._handle:
+            self._lib.timeline_close(self._handle)
+            self._handle = None
+    
+    def _require_handle(self) -> int:
+        if not self._handle:
+            raise RuntimeError("Timeline session is closed")
+        return self._handle
+    
+    def __enter__(self) -> 'TimelineSession':
+        return self
+    
+    def __exit__(self, *exc):
+        self.close()
+    
+    def __del__(self):
+        self.close()
+
+
+class TimelineBase:
+    """
+    A section's fixed classes and sleep window, built once in the C engine.
+    
+    Solves on a base start from its prepared timeline, so each user's task
+    list leaves the classes out. The base is read-only and may be shared
+    by any number of solves and threads; close it once they are done.
+    
+    Usage:
+        with engine.create_base(section_classes) as base:
+            results = engine.optimize_timeline_batch(users, bases=[base] * len(users))
+    """
+    
+    def __init__(self, lib: ctypes.CDLL, handle: int):
+        self._lib = lib
+        self._handle = handle
+    
+    @property
+    def handle(self) -> int:
+        """Engine-side pointer, for solve calls."""
+        if not self._handle:
+            raise RuntimeError("Timeline base is closed")
+        return self._handle
+    
+    def close(self):
+        """Release the engine-side base."""
+        if self._handle:
+            self._lib.timeline_base_destroy(self._handle)
+            self._handle = None
+    
+    def __enter__(self) -> 'TimelineBase':
+        return self
+    
+    def __exit__(self, *exc):
+        self.close()
+    
+    def __del__(self):
+        self.close()
+
+
 # ============================================
 # SCHEDULER ENGINE
 # ============================================
@@ -235,6 +671,11 @@ class SchedulerEngine:
         self._lib: Optional[ctypes.CDLL] = None
         self._is_loaded = False
         
+        # One engine context (arena) per calling thread
+        self._local = threading.local()
+        self._contexts: List[int] = []
+        self._contexts_lock = threading.Lock()
+        
         if library_path:
             self._library_path = Path(library_path)
         else:
@@ -297,6 +738,103 @@ class SchedulerEngine:
         # validate_constraints
         self._lib.validate_constraints.argtypes = [POINTER(WeeklyTimeline)]
         self._lib.validate_constraints.restype = c_int
+        if hasattr(self._lib, 'validate_constraints_ex'):
+            self._lib.validate_constraints_ex.argtypes = [
+                POINTER(WeeklyTimeline),
+                POINTER(ConstraintViolation),
+                c_int
+            ]
+            self._lib.validate_constraints_ex.restype = c_int
+        
+        # optimize_timeline_ex
+        if hasattr(self._lib, 'optimize_timeline_ex'):
+            self._lib.optimize_timeline_ex.argtypes = [
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(SolveOptions)
+            ]
+            self._lib.optimize_timeline_ex.restype = POINTER(WeeklyTimeline)
+        
+        # optimize_timeline_batch
+        if hasattr(self._lib, 'optimize_timeline_batch'):
+            self._lib.optimize_timeline_batch.argtypes = [
+                POINTER(TimelineTask),
+                POINTER(c_int),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(WeeklyTimeline)
+            ]
+            self._lib.optimize_timeline_batch.restype = c_int
+            self._lib.get_solve_slots.argtypes = [POINTER(OptimizationConfig), c_void_p]
+            self._lib.get_solve_slots.restype = c_int
+        
+        # Batch thread pool sizing
+        if hasattr(self._lib, 'set_engine_threads'):
+            self._lib.set_engine_threads.argtypes = [c_int]
+            self._lib.set_engine_threads.restype = c_int
+            self._lib.get_engine_threads.argtypes = []
+            self._lib.get_engine_threads.restype = c_int
+            self._lib.set_engine_threads(get_engine_config().batch_threads)
+        
+        # Engine contexts (arena-owned results)
+        if hasattr(self._lib, 'engine_context_create'):
+            self._lib.engine_context_create.argtypes = [c_size_t]
+            self._lib.engine_context_create.restype = c_void_p
+            self._lib.engine_context_reset.argtypes = [c_void_p]
+            self._lib.engine_context_reset.restype = None
+            self._lib.engine_context_destroy.argtypes = [c_void_p]
+            self._lib.engine_context_destroy.restype = None
+            self._lib.engine_context_stats.argtypes = [c_void_p, POINTER(ArenaStats)]
+            self._lib.engine_context_stats.restype = None
+            self._lib.optimize_timeline_ctx.argtypes = [
+                c_void_p,
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(SolveOptions)
+            ]
+            self._lib.optimize_timeline_ctx.restype = POINTER(WeeklyTimeline)
+        
+        # Zero-copy result arrays
+        if hasattr(self._lib, 'timeline_result_view'):
+            self._lib.timeline_result_view.argtypes = [
+                c_void_p,
+                POINTER(WeeklyTimeline),
+                POINTER(TimelineTask),
+                POINTER(ResultView)
+            ]
+            self._lib.timeline_result_view.restype = c_int
+        
+        # JSON result documents
+        if hasattr(self._lib, 'timeline_to_json'):
+            self._lib.timeline_to_json.argtypes = [POINTER(WeeklyTimeline), c_void_p, c_size_t]
+            self._lib.timeline_to_json.restype = c_size_t
+        
+        # Incremental timeline handles
+        if hasattr(self._lib, 'timeline_open'):
+            self._lib.timeline_open.argtypes = [
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(OptimizationConfig)
+            ]
+            self._lib.timeline_open.restype = c_void_p
+            self._lib.timeline_insert_task.argtypes = [c_void_p, POINTER(TimelineTask)]
+            self._lib.timeline_insert_task.restype = c_int
+            self._lib.timeline_remove_task.argtypes = [c_void_p, c_int]
+            self._lib.timeline_remove_task.restype = c_int
+            self._lib.timeline_get.argtypes = [c_void_p]
+            self._lib.timeline_get.restype = POINTER(WeeklyTimeline)
+            self._lib.timeline_close.argtypes = [c_void_p]
+            self._lib.timeline_close.restype = None
+        if hasattr(self._lib, 'timeline_what_if'):
+            self._lib.timeline_what_if.argtypes = [
+                c_void_p,
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(WhatIfResult)
+            ]
+            self._lib.timeline_what_if.restype = c_int
         
         # find_gaps
         if hasattr(self._lib, 'find_gaps'):
@@ -306,16 +844,270 @@ class SchedulerEngine:
                 c_int
             ]
             self._lib.find_gaps.restype = c_int
+        if hasattr(self._lib, 'fill_gaps'):
+            self._lib.fill_gaps.argtypes = [
+                POINTER(WeeklyTimeline),
+                POINTER(TimelineTask),
+                c_int
+            ]
+            self._lib.fill_gaps.restype = c_int
+        
+        # Scoring kernel selected for this CPU
+        if hasattr(self._lib, 'get_engine_simd'):
+            self._lib.get_engine_simd.argtypes = []
+            self._lib.get_engine_simd.restype = c_char_p
+        
+        # Shared base timelines
+        if hasattr(self._lib, 'timeline_base_create'):
+            self._lib.timeline_base_create.argtypes = [
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(OptimizationConfig)
+            ]
+            self._lib.timeline_base_create.restype = c_void_p
+            self._lib.timeline_base_destroy.argtypes = [c_void_p]
+            self._lib.timeline_base_destroy.restype = None
+            self._lib.optimize_timeline_base_ctx.argtypes = [
+                c_void_p,
+                c_void_p,
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(SolveOptions)
+            ]
+            self._lib.optimize_timeline_base_ctx.restype = POINTER(WeeklyTimeline)
+            self._lib.optimize_timeline_batch_base.argtypes = [
+                POINTER(TimelineTask),
+                POINTER(c_int),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(c_void_p),
+                POINTER(WeeklyTimeline)
+            ]
+            self._lib.optimize_timeline_batch_base.restype = c_int
+        
+        # Capacity pre-check
+        if hasattr(self._lib, 'check_feasibility'):
+            self._lib.check_feasibility.argtypes = [
+                POINTER(TimelineTask),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(FeasibilityReport),
+                POINTER(c_int),
+                c_int
+            ]
+            self._lib.check_feasibility.restype = c_int
+        
+        # Result cache for repeat solves
+        if hasattr(self._lib, 'engine_cache_configure'):
+            self._lib.engine_cache_configure.argtypes = [c_int]
+            self._lib.engine_cache_configure.restype = c_int
+            self._lib.engine_cache_invalidate.argtypes = []
+            self._lib.engine_cache_invalidate.restype = None
+            self._lib.engine_cache_stats.argtypes = [POINTER(EngineCacheStats)]
+            self._lib.engine_cache_stats.restype = None
+            self._lib.engine_cache_configure(get_engine_config().result_cache_size)
+        
+        # Counters and phase timings
+        if hasattr(self._lib, 'get_engine_stats'):
+            self._lib.get_engine_stats.argtypes = [POINTER(EngineStats), POINTER(EngineStats)]
+            self._lib.get_engine_stats.restype = c_int
+            self._lib.reset_engine_stats.argtypes = []
+            self._lib.reset_engine_stats.restype = None
+        
+        # Deadlines, cancellation and progress
+        if hasattr(self._lib, 'engine_clock_us'):
+            self._lib.engine_clock_us.argtypes = []
+            self._lib.engine_clock_us.restype = c_int64
+            self._lib.optimize_timeline_batch_ex.argtypes = [
+                POINTER(TimelineTask),
+                POINTER(c_int),
+                c_int,
+                POINTER(OptimizationConfig),
+                POINTER(c_void_p),
+                POINTER(SolveOptions),
+                POINTER(WeeklyTimeline)
+            ]
+            self._lib.optimize_timeline_batch_ex.restype = c_int
+        
+        # Portfolio strategy names
+        if hasattr(self._lib, 'get_strategy_name'):
+            self._lib.get_strategy_name.argtypes = [c_int]
+            self._lib.get_strategy_name.restype = c_char_p
+    
+    def _solve_options(self, options: Optional[Dict[str, Any]]) -> Optional[SolveOptions]:
+        """
+        SolveOptions for an options dict, with the per-call controls:
+        timeout_ms (a deadline for the whole call, unlike the search
+        budget time_limit_ms), cancel (a CancelToken) and progress (a
+        callable taking an EngineProgress dict; returning True cancels).
+        The callback wrapper lives as long as the returned struct.
+        """
+        if options is None:
+            return None
+        solve_options = SolveOptions.from_dict(options)
+        controls = hasattr(self._lib, 'engine_clock_us')
+        
+        timeout_ms = options.get('timeout_ms')
+        if timeout_ms is not None and controls:
+            solve_options.deadline_us = self._lib.engine_clock_us() + int(timeout_ms * 1000)
+        
+        token = options.get('cancel')
+        if token is not None and controls:
+            solve_options.cancel = token.pointer
+        
+        callback = options.get('progress')
+        if callback is not None and controls:
+            def report(progress, _user):
+                try:
+                    return 1 if callback(progress.contents.to_dict()) else 0
+                except Exception as e:
+                    logger.error(f"Progress callback failed, cancelling solve: {e}")
+                    return 1
+            solve_options.progress = PROGRESS_FN(report)
+        return solve_options
+    
+    @staticmethod
+    def _status_message(timeline: WeeklyTimeline) -> str:
+        if timeline.optimization_status == -2 and timeline.error_code in STOP_MESSAGES:
+            return STOP_MESSAGES[timeline.error_code]
+        return STATUS_MESSAGES.get(
+            timeline.optimization_status,
+            f"Unknown status: {timeline.optimization_status}"
+        )
+    
+    def _violations(self, timeline) -> Optional[List[Dict[str, Any]]]:
+        """Violations of a solved timeline (pointer or struct), or None if unchecked."""
+        if not hasattr(self._lib, 'validate_constraints_ex'):
+            return None
+        buffer = (ConstraintViolation * MAX_VIOLATIONS)()
+        if not isinstance(timeline, ctypes._Pointer):
+            timeline = ctypes.pointer(timeline)
+        count = self._lib.validate_constraints_ex(timeline, buffer, MAX_VIOLATIONS)
+        if count < 0:
+            return None
+        if count > 0:
+            logger.warning(f"Timeline has {count} constraint violation(s)")
+        return [buffer[k].to_dict() for k in range(min(count, MAX_VIOLATIONS))]
+    
+    def _strategy_name(self, strategy: int) -> Optional[str]:
+        """Name of the portfolio strategy behind a result, if any."""
+        if strategy < 0 or not hasattr(self._lib, 'get_strategy_name'):
+            return None
+        name = self._lib.get_strategy_name(strategy)
+        return name.decode() if name else None
     
     @property
     def is_available(self) -> bool:
         """Check if C engine is available."""
         return self._is_loaded and self._lib is not None
     
+    def _context(self) -> Optional[int]:
+        """This thread's engine context, created on first use."""
+        if not hasattr(self._lib, 'engine_context_create'):
+            return None
+        ctx = getattr(self._local, 'context', None)
+        if ctx is None:
+            ctx = self._lib.engine_context_create(0)
+            if not ctx:
+                return None
+            self._local.context = ctx
+            with self._contexts_lock:
+                self._contexts.append(ctx)
+        return ctx
+    
+    @property
+    def simd_level(self) -> Optional[str]:
+        """Vector instruction set the engine scores slots with, if reported."""
+        if not self.is_available or not hasattr(self._lib, 'get_engine_simd'):
+            return None
+        return self._lib.get_engine_simd().decode()
+    
+    def get_memory_stats(self) -> Dict[str, int]:
+        """
+        Arena usage of the calling thread's engine context.
+        
+        Returns:
+            bytes_used, high_water, bytes_reserved, block_count,
+            alloc_count and reset_count (empty if the engine is unavailable)
+        """
+        if not self.is_available:
+            return {}
+        ctx = self._context()
+        if ctx is None:
+            return {}
+        stats = ArenaStats()
+        self._lib.engine_context_stats(ctx, byref(stats))
+        return stats.to_dict()
+    
+    def get_cache_stats(self) -> Dict[str, int]:
+        """
+        Counters of the engine's result cache, shared by all threads.
+        
+        Returns:
+            hits, misses, evictions, entries and capacity
+            (empty if the engine is unavailable)
+        """
+        if not self.is_available or not hasattr(self._lib, 'engine_cache_stats'):
+            return {}
+        stats = EngineCacheStats()
+        self._lib.engine_cache_stats(byref(stats))
+        return stats.to_dict()
+    
+    def get_engine_stats(self) -> Dict[str, Any]:
+        """
+        Solver counters and phase timings measured inside the engine.
+        
+        Returns:
+            enabled (False if the library was built with ENGINE_NO_STATS),
+            last_solve (the calling thread's most recent solve, with any
+            gap scans since) and totals (every solve in the process), each
+            an EngineStats dict. Empty if the engine is unavailable.
+        """
+        if not self.is_available or not hasattr(self._lib, 'get_engine_stats'):
+            return {}
+        last, totals = EngineStats(), EngineStats()
+        enabled = self._lib.get_engine_stats(byref(last), byref(totals))
+        return {
+            "enabled": bool(enabled),
+            "last_solve": last.to_dict(),
+            "totals": totals.to_dict(),
+        }
+    
+    def reset_engine_stats(self) -> None:
+        """Zero the engine totals and this thread's last-solve counters."""
+        if self.is_available and hasattr(self._lib, 'reset_engine_stats'):
+            self._lib.reset_engine_stats()
+    
+    def invalidate_cache(self) -> None:
+        """Drop every cached solve result (the counters are kept)."""
+        if self.is_available and hasattr(self._lib, 'engine_cache_invalidate'):
+            self._lib.engine_cache_invalidate()
+    
+    def __del__(self):
+        lib = getattr(self, '_lib', None)
+        for ctx in getattr(self, '_contexts', []):
+            lib.engine_context_destroy(ctx)
+    
+    def set_thread_count(self, n_threads: int) -> int:
+        """
+        Set the number of threads used by optimize_timeline_batch.
+        
+        Args:
+            n_threads: Worker count including the calling thread (0 = one per CPU)
+            
+        Returns:
+            The thread count the engine will use (1 if the engine is unavailable)
+        """
+        if not self.is_available or not hasattr(self._lib, 'set_engine_threads'):
+            return 1
+        return self._lib.set_engine_threads(n_threads)
+    
     def optimize_timeline(
         self,
         tasks: List[Dict[str, Any]],
-        config: Optional[Dict[str, int]] = None
+        config: Optional[Dict[str, int]] = None,
+        options: Optional[Dict[str, Any]] = None,
+        base: Optional[TimelineBase] = None
     ) -> OptimizationResult:
         """
         Optimize a weekly timeline using the C engine.
@@ -325,6 +1117,16 @@ class SchedulerEngine:
                    - id, duration_slots, priority, category
                    - deadline_slot, is_locked, title, subject
             config: Optimization configuration (uses defaults if None)
+            options: Search options (search_mode, time_limit_ms, node_limit,
+                     improve_iterations, improve_time_us). time_limit_ms
+                     defaults to the engine search_time_limit_ms; either
+                     improve_ budget adds a local-search pass after the search.
+                     None runs the plain greedy pass. timeout_ms, cancel and
+                     progress bound the whole call (see _solve_options); a
+                     solve they stop returns its best result with status -2.
+            base: Shared classes and sleep window to solve on (see
+                  create_base); its config replaces config, and tasks
+                  should not repeat its classes
             
         Returns:
             OptimizationResult with optimized schedule
@@ -344,19 +1146,49 @@ class SchedulerEngine:
         opt_config = OptimizationConfig.from_dict(config)
         
         # Convert tasks to C structures
-        task_count = min(len(tasks), MAX_TASKS)
+        task_count = len(tasks)
         task_array = (TimelineTask * task_count)()
         
-        for i, task in enumerate(tasks[:task_count]):
+        for i, task in enumerate(tasks):
             task_array[i] = TimelineTask.from_dict(task)
         
-        # Call C function
+        # Call C function. With an engine context the result lives in this
+        # thread's arena until the next call resets it, so nothing is freed.
+        ctx = self._context()
         try:
-            timeline_ptr = self._lib.optimize_timeline(
-                task_array,
-                task_count,
-                byref(opt_config)
-            )
+            if ctx is not None:
+                self._lib.engine_context_reset(ctx)
+                solve_options = self._solve_options(options)
+                if base is not None:
+                    timeline_ptr = self._lib.optimize_timeline_base_ctx(
+                        ctx,
+                        base.handle,
+                        task_array,
+                        task_count,
+                        byref(solve_options) if solve_options is not None else None
+                    )
+                else:
+                    timeline_ptr = self._lib.optimize_timeline_ctx(
+                        ctx,
+                        task_array,
+                        task_count,
+                        byref(opt_config),
+                        byref(solve_options) if solve_options is not None else None
+                    )
+            elif options is not None and hasattr(self._lib, 'optimize_timeline_ex'):
+                solve_options = self._solve_options(options)
+                timeline_ptr = self._lib.optimize_timeline_ex(
+                    task_array,
+                    task_count,
+                    byref(opt_config),
+                    byref(solve_options)
+                )
+            else:
+                timeline_ptr = self._lib.optimize_timeline(
+                    task_array,
+                    task_count,
+                    byref(opt_config)
+                )
         except Exception as e:
             logger.error(f"C engine call failed: {e}")
             return OptimizationResult(
@@ -386,23 +1218,16 @@ class SchedulerEngine:
             timeline = timeline_ptr.contents
             
             # Extract results
-            slots = list(timeline.slots[:WEEK_SLOTS])
+            slots = list(timeline.slots[:timeline.slot_count])
             
-            # Extract optimized tasks
+            # Extract optimized tasks (the context solves a copy)
+            solved = timeline.tasks if ctx is not None else task_array
             optimized_tasks = []
             for i in range(task_count):
-                optimized_tasks.append(task_array[i].to_dict())
+                optimized_tasks.append(solved[i].to_dict())
             
             # Determine status message
-            status_messages = {
-                0: "Optimization successful",
-                -1: "Schedule unsolvable - too many tasks for available slots",
-                -2: "Optimization timeout",
-            }
-            status_msg = status_messages.get(
-                timeline.optimization_status,
-                f"Unknown status: {timeline.optimization_status}"
-            )
+            status_msg = self._status_message(timeline)
             
             result = OptimizationResult(
                 success=timeline.optimization_status == 0,
@@ -412,14 +1237,422 @@ class SchedulerEngine:
                 tasks=optimized_tasks,
                 gaps_filled=timeline.total_gaps_filled,
                 conflicts=timeline.total_conflicts,
-                execution_time_ms=(time.time() - start_time) * 1000
+                execution_time_ms=(time.time() - start_time) * 1000,
+                strategy=self._strategy_name(timeline.solve_strategy)
             )
+            if get_engine_config().validate_solves:
+                result.violations = self._violations(timeline_ptr)
             
             return result
             
         finally:
-            # Always free C memory
-            self._lib.free_timeline_memory(timeline_ptr)
+            # Without a context the timeline was malloc'd for us
+            if ctx is None:
+                self._lib.free_timeline_memory(timeline_ptr)
+    
+    def optimize_timeline_view(
+        self,
+        tasks: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None,
+        options: Optional[Dict[str, Any]] = None
+    ) -> SolveView:
+        """
+        Optimize a timeline like optimize_timeline, without building
+        Python lists and dicts for the result.
+        
+        The slot grid and per-task assignments come back as memoryviews
+        over the engine's result buffers, and changed lists only the
+        tasks whose assigned_slot differs from the input, keyed by id.
+        Views are valid until the next solve on this thread.
+        """
+        import time
+        start_time = time.time()
+        
+        ctx = self._context() if self.is_available else None
+        if ctx is None or not hasattr(self._lib, 'timeline_result_view'):
+            return self._result_to_view(tasks, self.optimize_timeline(tasks, config, options))
+        
+        if config is None:
+            config = get_optimization_config(get_schedule_config())
+        opt_config = OptimizationConfig.from_dict(config)
+        solve_options = self._solve_options(options)
+        
+        task_count = len(tasks)
+        task_array = (TimelineTask * max(task_count, 1))()
+        for i, task in enumerate(tasks):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        self._lib.engine_context_reset(ctx)
+        timeline_ptr = self._lib.optimize_timeline_ctx(
+            ctx,
+            task_array,
+            task_count,
+            byref(opt_config),
+            byref(solve_options) if solve_options is not None else None
+        )
+        view = ResultView()
+        if not timeline_ptr or self._lib.timeline_result_view(ctx, timeline_ptr, task_array, byref(view)) != 0:
+            raise MemoryError("C engine could not allocate the result")
+        
+        timeline = timeline_ptr.contents
+        task_ids = _int_view(view.task_ids, view.task_count)
+        assigned = _int_view(view.assigned, view.task_count)
+        changed = {}
+        for k in range(view.changed_count):
+            i = view.changed[k]
+            changed[task_ids[i]] = {"assigned_slot": assigned[i]}
+        
+        return SolveView(
+            success=timeline.optimization_status == 0,
+            status_code=timeline.optimization_status,
+            status_message=self._status_message(timeline),
+            slots=_int_view(view.slots, view.slot_count),
+            task_ids=task_ids,
+            assigned=assigned,
+            conflicts=_int_view(view.conflicts, view.conflict_count),
+            changed=changed,
+            gaps_filled=timeline.total_gaps_filled,
+            execution_time_ms=(time.time() - start_time) * 1000
+        )
+    
+    def optimize_timeline_json(
+        self,
+        tasks: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None,
+        options: Optional[Dict[str, Any]] = None
+    ) -> str:
+        """
+        Optimize a timeline like optimize_timeline and return the result
+        as a JSON document written by the engine, for handing straight to
+        an HTTP response.
+        
+        Keys are those of OptimizationResult.to_dict without
+        status_message and execution_time_ms. The engine's output buffer
+        is kept per thread and grows to the largest document seen.
+        """
+        ctx = self._context() if self.is_available else None
+        if ctx is None or not hasattr(self._lib, 'timeline_to_json'):
+            result = self.optimize_timeline(tasks, config, options).to_dict()
+            del result["status_message"], result["execution_time_ms"]
+            return json.dumps(result)
+        
+        if config is None:
+            config = get_optimization_config(get_schedule_config())
+        opt_config = OptimizationConfig.from_dict(config)
+        solve_options = self._solve_options(options)
+        
+        task_count = len(tasks)
+        task_array = (TimelineTask * max(task_count, 1))()
+        for i, task in enumerate(tasks):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        self._lib.engine_context_reset(ctx)
+        timeline_ptr = self._lib.optimize_timeline_ctx(
+            ctx,
+            task_array,
+            task_count,
+            byref(opt_config),
+            byref(solve_options) if solve_options is not None else None
+        )
+        if not timeline_ptr:
+            raise MemoryError("C engine could not allocate the result")
+        
+        buffer = getattr(self._local, 'json_buffer', None)
+        if buffer is None:
+            buffer = ctypes.create_string_buffer(64 * 1024)
+        length = self._lib.timeline_to_json(timeline_ptr, buffer, len(buffer))
+        if length >= len(buffer):
+            buffer = ctypes.create_string_buffer(length + 1)
+            self._lib.timeline_to_json(timeline_ptr, buffer, len(buffer))
+        self._local.json_buffer = buffer
+        return buffer.raw[:length].decode('utf-8', errors='replace')
+    
+    @staticmethod
+    def _result_to_view(tasks: List[Dict[str, Any]], result: OptimizationResult) -> SolveView:
+        """SolveView over Python-owned copies of an OptimizationResult."""
+        ids = [t['id'] for t in result.tasks]
+        assigned = [t['assigned_slot'] for t in result.tasks]
+        changed = {
+            ids[i]: {"assigned_slot": assigned[i]}
+            for i in range(len(ids))
+            if assigned[i] != tasks[i].get('assigned_slot', -1)
+        }
+        return SolveView(
+            success=result.success,
+            status_code=result.status_code,
+            status_message=result.status_message,
+            slots=memoryview(array.array('i', result.slots)),
+            task_ids=memoryview(array.array('i', ids)),
+            assigned=memoryview(array.array('i', assigned)),
+            conflicts=memoryview(array.array('i', [ids[i] for i in range(len(ids)) if assigned[i] < 0])),
+            changed=changed,
+            gaps_filled=result.gaps_filled,
+            execution_time_ms=result.execution_time_ms
+        )
+    
+    def optimize_timeline_batch(
+        self,
+        users: List[List[Dict[str, Any]]],
+        configs: Optional[List[Optional[Dict[str, int]]]] = None,
+        bases: Optional[List[Optional[TimelineBase]]] = None,
+        options: Optional[Dict[str, Any]] = None
+    ) -> List[OptimizationResult]:
+        """
+        Optimize many independent weekly timelines in a single C call.
+        
+        Args:
+            users: One task list per user (same dict format as optimize_timeline)
+            configs: Optional per-user configuration (None entries use defaults)
+            bases: Optional per-user base timeline (see create_base); a user
+                   with a base is solved on it with its config
+            options: Search options for every user (as optimize_timeline).
+                     timeout_ms, cancel and progress cover the whole batch;
+                     progress reports count solved users
+            
+        Returns:
+            One OptimizationResult per user, in input order. execution_time_ms
+            is the batch wall time divided evenly across users.
+        
+        The engine solves users in parallel on its own thread pool. ctypes
+        releases the GIL for the duration of the call, so other Python
+        threads keep running while the batch is solved.
+        """
+        import time
+        start_time = time.time()
+        
+        n_users = len(users)
+        if n_users == 0:
+            return []
+        
+        if not self.is_available or not hasattr(self._lib, 'optimize_timeline_batch'):
+            return [
+                self.optimize_timeline(
+                    tasks,
+                    configs[i] if configs else None,
+                    options,
+                    base=bases[i] if bases else None
+                )
+                for i, tasks in enumerate(users)
+            ]
+        
+        default_config = None
+        if configs is None or any(c is None for c in configs):
+            default_config = get_optimization_config(get_schedule_config())
+        
+        # Flatten every user's tasks into one array plus offsets
+        offsets = (c_int * (n_users + 1))()
+        total = 0
+        for i, tasks in enumerate(users):
+            offsets[i] = total
+            total += len(tasks)
+        offsets[n_users] = total
+        
+        task_array = (TimelineTask * max(total, 1))()
+        result_array = (TimelineTask * max(total, 1))()
+        k = 0
+        for tasks in users:
+            for task in tasks:
+                task_array[k] = TimelineTask.from_dict(task)
+                k += 1
+        
+        cfg_array = (OptimizationConfig * n_users)()
+        for i in range(n_users):
+            cfg = configs[i] if configs and configs[i] is not None else default_config
+            cfg_array[i] = OptimizationConfig.from_dict(cfg)
+        
+        base_array = None
+        if bases is not None:
+            base_array = (c_void_p * n_users)(*[b.handle if b is not None else None for b in bases])
+        
+        # Solved tasks are written into result_array and slots into slot_array,
+        # one slice per user, each sized to the user's grid
+        slot_counts = [
+            self._lib.get_solve_slots(byref(cfg_array[i]), base_array[i] if base_array else None)
+            for i in range(n_users)
+        ]
+        slot_array = (c_int * max(sum(slot_counts), 1))()
+        out = (WeeklyTimeline * n_users)()
+        task_size = ctypes.sizeof(TimelineTask)
+        base_addr = ctypes.addressof(result_array)
+        slot_addr = ctypes.addressof(slot_array)
+        for i in range(n_users):
+            out[i].tasks = ctypes.cast(base_addr + offsets[i] * task_size, POINTER(TimelineTask))
+            out[i].slots = ctypes.cast(slot_addr, POINTER(c_int))
+            out[i].slot_capacity = slot_counts[i]
+            slot_addr += slot_counts[i] * ctypes.sizeof(c_int)
+        if options is not None and hasattr(self._lib, 'optimize_timeline_batch_ex'):
+            solve_options = self._solve_options(options)
+            rc = self._lib.optimize_timeline_batch_ex(task_array, offsets, n_users, cfg_array,
+                                                      base_array, byref(solve_options), out)
+        elif base_array is not None:
+            rc = self._lib.optimize_timeline_batch_base(task_array, offsets, n_users, cfg_array,
+                                                        base_array, out)
+        else:
+            rc = self._lib.optimize_timeline_batch(task_array, offsets, n_users, cfg_array, out)
+        elapsed_ms = (time.time() - start_time) * 1000
+        per_user_ms = elapsed_ms / n_users
+        
+        if rc != 0:
+            logger.error(f"C engine batch call failed with code {rc}")
+            return [
+                OptimizationResult(
+                    success=False,
+                    status_code=-3,
+                    status_message=f"C engine batch error: {rc}",
+                    slots=[],
+                    tasks=[],
+                    gaps_filled=0,
+                    conflicts=0,
+                    execution_time_ms=per_user_ms
+                )
+                for _ in range(n_users)
+            ]
+        
+        validate = get_engine_config().validate_solves
+        results = []
+        for i in range(n_users):
+            timeline = out[i]
+            results.append(OptimizationResult(
+                success=timeline.optimization_status == 0,
+                status_code=timeline.optimization_status,
+                status_message=self._status_message(timeline),
+                slots=list(timeline.slots[:timeline.slot_count]),
+                tasks=[result_array[j].to_dict() for j in range(offsets[i], offsets[i + 1])],
+                gaps_filled=timeline.total_gaps_filled,
+                conflicts=timeline.total_conflicts,
+                execution_time_ms=per_user_ms,
+                violations=self._violations(timeline) if validate else None
+            ))
+        
+        return results
+    
+    def open_timeline(
+        self,
+        tasks: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None
+    ) -> Optional[TimelineSession]:
+        """
+        Solve a timeline once and keep it open for incremental edits.
+        
+        Args:
+            tasks: Initial task list (same dict format as optimize_timeline)
+            config: Optimization configuration (uses defaults if None)
+            
+        Returns:
+            A TimelineSession, or None if the C engine is unavailable
+        """
+        if not self.is_available or not hasattr(self._lib, 'timeline_open'):
+            return None
+        
+        if config is None:
+            config = get_optimization_config(get_schedule_config())
+        opt_config = OptimizationConfig.from_dict(config)
+        
+        task_array = (TimelineTask * max(len(tasks), 1))()
+        for i, task in enumerate(tasks):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        handle = self._lib.timeline_open(task_array, len(tasks), byref(opt_config))
+        if not handle:
+            logger.error("C engine could not open timeline")
+            return None
+        return TimelineSession(self._lib, handle)
+    
+    def what_if(
+        self,
+        tasks: List[Dict[str, Any]],
+        candidates: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None
+    ) -> Optional[List[Dict[str, int]]]:
+        """
+        Solve tasks once and evaluate every candidate edit against the
+        result (see TimelineSession.what_if), instead of one solve per
+        hypothetical.
+        
+        Returns:
+            One dict per candidate, or None if the C engine is unavailable
+        """
+        if not self.is_available or not hasattr(self._lib, 'timeline_what_if'):
+            return None
+        session = self.open_timeline(tasks, config)
+        if session is None:
+            return None
+        with session:
+            return session.what_if(candidates)
+    
+    def create_base(
+        self,
+        classes: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None
+    ) -> Optional[TimelineBase]:
+        """
+        Build a shared base timeline for a cohort with the same classes.
+        
+        Args:
+            classes: Locked tasks with a preferred_slot (others are ignored)
+            config: Optimization configuration (uses defaults if None)
+            
+        Returns:
+            A TimelineBase, or None if the C engine is unavailable or
+            rejects the config
+        """
+        if not self.is_available or not hasattr(self._lib, 'timeline_base_create'):
+            return None
+        
+        if config is None:
+            config = get_optimization_config(get_schedule_config())
+        opt_config = OptimizationConfig.from_dict(config)
+        
+        task_array = (TimelineTask * max(len(classes), 1))()
+        for i, task in enumerate(classes):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        handle = self._lib.timeline_base_create(task_array, len(classes), byref(opt_config))
+        if not handle:
+            logger.error("C engine could not build the base timeline")
+            return None
+        return TimelineBase(self._lib, handle)
+    
+    def check_feasibility(
+        self,
+        tasks: List[Dict[str, Any]],
+        config: Optional[Dict[str, int]] = None
+    ) -> Optional[Dict[str, Any]]:
+        """
+        Quick "can this fit?" answer without running the solver.
+        
+        Compares the slots due by each deadline with the free time before
+        it. Passing does not guarantee a conflict-free solve; failing means
+        no solve can place every task.
+        
+        Returns:
+            FeasibilityReport fields plus drop_ids, the ids of the fewest
+            tasks to drop or give a later deadline (None if the engine is
+            unavailable or rejects the config)
+        """
+        if not self.is_available or not hasattr(self._lib, 'check_feasibility'):
+            return None
+        
+        if config is None:
+            schedule_cfg = get_schedule_config()
+            config = get_optimization_config(schedule_cfg)
+        opt_config = OptimizationConfig.from_dict(config)
+        
+        task_count = len(tasks)
+        task_array = (TimelineTask * task_count)()
+        for i, task in enumerate(tasks):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        report = FeasibilityReport()
+        drop_ids = (c_int * max(task_count, 1))()
+        drops = self._lib.check_feasibility(
+            task_array, task_count, byref(opt_config), byref(report), drop_ids, task_count
+        )
+        if drops < 0:
+            return None
+        result = report.to_dict()
+        result["drop_ids"] = list(drop_ids[:drops])
+        return result
     
     def _python_optimize(
         self,
@@ -428,7 +1661,8 @@ class SchedulerEngine:
     ) -> OptimizationResult:
         """
         Pure Python fallback optimization.
-        Uses a simple greedy algorithm instead of full CSP.
+        Uses a simple greedy algorithm instead of full CSP, and always
+        plans the default one-week horizon of 30-minute slots.
         """
         import time
         start_time = time.time()
@@ -437,6 +1671,10 @@ class SchedulerEngine:
             schedule_cfg = get_schedule_config()
             config = get_optimization_config(schedule_cfg)
         
+        if (config.get('horizon_weeks', 1) != 1 or
+                config.get('slot_minutes', MINUTES_PER_DAY // SLOTS_PER_DAY) != MINUTES_PER_DAY // SLOTS_PER_DAY):
+            logger.warning("Python fallback only supports a one-week horizon of 30-minute slots")
+        
         # Initialize empty timeline
         slots = [-1] * WEEK_SLOTS
         
@@ -578,108 +1816,163 @@ class SchedulerEngine:
                 return False
         return True
     
+    def _timeline_from_slots(self, slots: List[int], slots_per_day: int) -> WeeklyTimeline:
+        """Build a WeeklyTimeline (slots and free_mask) from a slot list."""
+        timeline = WeeklyTimeline()
+        count = min(len(slots), MAX_SLOTS)
+        timeline.slots = (c_int * count)(*slots[:count])  # Kept alive by the struct
+        timeline.slot_capacity = count
+        timeline.slot_count = count
+        timeline.slots_per_day = slots_per_day
+        timeline.occ_words = (count + 63) // 64
+        for w in range(timeline.occ_words):
+            bits = 0
+            for b, value in enumerate(slots[w * 64:min((w + 1) * 64, count)]):
+                if value == -1:
+                    bits |= 1 << b
+            timeline.free_mask[w] = bits
+        return timeline
+    
+    def _gap_dict(self, start: int, end: int, day_index: int, slots_per_day: int) -> Dict[str, Any]:
+        minutes = (end - start) * (MINUTES_PER_DAY // slots_per_day)
+        return {
+            "start_slot": start,
+            "end_slot": end,
+            "duration_slots": end - start,
+            "day_index": day_index,
+            "gap_type": GAP_TYPES[0 if minutes <= 30 else (1 if minutes <= 60 else 2)],
+            "start_time": self._slot_to_time_str(start % slots_per_day, slots_per_day),
+            "end_time": self._slot_to_time_str(end % slots_per_day or slots_per_day, slots_per_day),
+        }
+    
     def find_gaps(
         self,
         slots: List[int],
-        min_duration: int = 1
+        min_duration: int = 1,
+        slots_per_day: int = SLOTS_PER_DAY
     ) -> List[Dict[str, Any]]:
         """
         Find gaps in the timeline.
         
+        Uses the engine's free-bitmap scan when available.
+        
         Args:
             slots: Current slot assignments
             min_duration: Minimum gap duration in slots
+            slots_per_day: Grid resolution of slots
             
         Returns:
             List of gap dictionaries
         """
+        if self.is_available and hasattr(self._lib, 'find_gaps'):
+            timeline = self._timeline_from_slots(slots, slots_per_day)
+            capacity = max((timeline.slot_count + 1) // 2, 1)
+            buffer = (ScheduleGap * capacity)()
+            count = self._lib.find_gaps(byref(timeline), buffer, capacity)
+            return [
+                self._gap_dict(g.start_slot, g.end_slot, g.day_index, slots_per_day)
+                for g in buffer[:min(count, capacity)]
+                if g.duration_slots >= min_duration
+            ]
+        
         gaps = []
         gap_start = None
         
-        for i, slot_value in enumerate(slots):
+        for i, slot_value in enumerate(slots + [None]):
             if slot_value == -1:  # Empty slot
                 if gap_start is None:
                     gap_start = i
-            else:
-                if gap_start is not None:
-                    duration = i - gap_start
-                    if duration >= min_duration:
-                        day_index = gap_start // SLOTS_PER_DAY
-                        
-                        # Classify gap type
-                        if duration <= 1:
-                            gap_type = "micro"
-                        elif duration <= 4:
-                            gap_type = "standard"
-                        else:
-                            gap_type = "deep_work"
-                        
-                        gaps.append({
-                            "start_slot": gap_start,
-                            "end_slot": i,
-                            "duration_slots": duration,
-                            "day_index": day_index,
-                            "gap_type": gap_type,
-                            "start_time": self._slot_to_time_str(gap_start % SLOTS_PER_DAY),
-                            "end_time": self._slot_to_time_str(i % SLOTS_PER_DAY),
-                        })
-                    gap_start = None
-        
-        # Check final gap
-        if gap_start is not None:
-            duration = WEEK_SLOTS - gap_start
-            if duration >= min_duration:
-                day_index = gap_start // SLOTS_PER_DAY
-                gap_type = "micro" if duration <= 1 else ("standard" if duration <= 4 else "deep_work")
-                gaps.append({
-                    "start_slot": gap_start,
-                    "end_slot": WEEK_SLOTS,
-                    "duration_slots": duration,
-                    "day_index": day_index,
-                    "gap_type": gap_type,
-                    "start_time": self._slot_to_time_str(gap_start % SLOTS_PER_DAY),
-                    "end_time": "24:00",
-                })
+            elif gap_start is not None:
+                if i - gap_start >= min_duration:
+                    gaps.append(self._gap_dict(gap_start, i, gap_start // slots_per_day, slots_per_day))
+                gap_start = None
         
         return gaps
     
-    def _slot_to_time_str(self, slot: int) -> str:
+    def fill_gaps(
+        self,
+        slots: List[int],
+        tasks: List[Dict[str, Any]],
+        slots_per_day: int = SLOTS_PER_DAY
+    ) -> Dict[str, Any]:
+        """
+        Best-fit tasks into the free gaps of an existing timeline.
+        
+        Tasks go in priority order, longest first, each into the
+        shortest gap that holds it before its deadline. Occupied slots
+        are never moved.
+        
+        Returns:
+            {"placed": count, "slots": updated slots, "tasks": tasks
+            with assigned_slot set (-1 = no gap fit)}
+        """
+        if not self.is_available or not hasattr(self._lib, 'fill_gaps'):
+            raise RuntimeError("Scheduler engine not available")
+        
+        timeline = self._timeline_from_slots(slots, slots_per_day)
+        task_array = (TimelineTask * max(len(tasks), 1))()
+        for i, task in enumerate(tasks):
+            task_array[i] = TimelineTask.from_dict(task)
+        
+        placed = self._lib.fill_gaps(byref(timeline), task_array, len(tasks))
+        if placed < 0:
+            raise RuntimeError("fill_gaps failed")
+        
+        return {
+            "placed": placed,
+            "slots": list(timeline.slots[:timeline.slot_count]),
+            "tasks": [task_array[i].to_dict() for i in range(len(tasks))],
+        }
+    
+    def _slot_to_time_str(self, slot: int, slots_per_day: int = SLOTS_PER_DAY) -> str:
         """Convert slot index to time string."""
-        hour = slot // 2
-        minute = 30 if slot % 2 else 0
-        return f"{hour:02d}:{minute:02d}"
+        minutes = slot * (MINUTES_PER_DAY // slots_per_day)
+        return f"{minutes // 60:02d}:{minutes % 60:02d}"
     
     def validate(self, slots: List[int], tasks: List[Dict[str, Any]]) -> Dict[str, Any]:
         """
         Validate a timeline meets all constraints.
         
+        Runs the engine's validate_constraints_ex when available. slots has
+        no sleep window attached here, so blocked_slot is only reported for
+        solves checked by optimize_timeline (validate_solves).
+        
         Returns:
-            Validation result with any violations
+            Validation result with any violations (type, task_id,
+            start_slot, end_slot, other_id)
         """
+        if self.is_available and hasattr(self._lib, 'validate_constraints_ex'):
+            task_array = (TimelineTask * max(len(tasks), 1))()
+            for i, task in enumerate(tasks):
+                task_array[i] = TimelineTask.from_dict(task)
+            timeline = WeeklyTimeline()
+            timeline.slot_count = min(len(slots), MAX_SLOTS)
+            timeline.slots = (c_int * timeline.slot_count)(*slots[:timeline.slot_count])
+            timeline.slot_capacity = timeline.slot_count
+            timeline.tasks = task_array
+            timeline.task_count = len(tasks)
+            violations = self._violations(timeline)
+            if violations is not None:
+                return {"valid": len(violations) == 0, "violations": violations}
+        
         violations = []
         
         # Check for overlaps
         for i, task in enumerate(tasks):
             assigned = task.get('assigned_slot', -1)
             duration = task.get('duration_slots', 2)
+            task_id = task.get('id', i)
             
             if assigned < 0:
                 continue
             
             for j in range(duration):
                 slot_idx = assigned + j
-                if slot_idx >= WEEK_SLOTS:
-                    violations.append({
-                        "type": "out_of_bounds",
-                        "task_id": task.get('id', i),
-                        "slot": slot_idx
-                    })
-                elif slots[slot_idx] != task.get('id', i):
-                    violations.append({
-                        "type": "overlap",
-                        "task_id": task.get('id', i),
-                        "slot": slot_idx
-                    })
+                if slot_idx >= len(slots):
+                    violations.append(self._violation("out_of_bounds", task_id, slot_idx, slot_idx + 1))
+                elif slots[slot_idx] != task_id:
+                    violations.append(self._violation("overlap", task_id, slot_idx, slot_idx + 1,
+                                                      slots[slot_idx]))
         
         # Check deadlines
         for task in tasks:
@@ -688,17 +1981,17 @@ class SchedulerEngine:
             duration = task.get('duration_slots', 2)
             
             if assigned >= 0 and assigned + duration > deadline:
-                violations.append({
-                    "type": "deadline_violation",
-                    "task_id": task.get('id'),
-                    "assigned_end": assigned + duration,
-                    "deadline": deadline
-                })
+                violations.append(self._violation("deadline_violation", task.get('id'),
+                                                  max(assigned, deadline), assigned + duration))
         
         return {
             "valid": len(violations) == 0,
             "violations": violations
         }
+    
+    @staticmethod
+    def _violation(kind: str, task_id: int, start: int, end: int, other: int = -1) -> Dict[str, Any]:
+        return {"type": kind, "task_id": task_id, "start_slot": start, "end_slot": end, "other_id": other}
 
 
 # ============================================
@@ -204,6 +204,28 @@ class EngineConfig(BaseSettings):
         le=30000,
         description="Timeout for C engine optimization in milliseconds"
     )
+    search_time_limit_ms: int = Field(
+        default=50,
+        ge=1,
+        le=30000,
+        description="Default search budget of a non-greedy solve (time_limit_ms) in milliseconds"
+    )
+    batch_threads: int = Field(
+        default=0,
+        ge=0,
+        le=256,
+        description="Worker threads for batch optimization (0 = one per CPU)"
+    )
+    result_cache_size: int = Field(
+        default=64,
+        ge=0,
+        le=1024,
+        description="Solve results kept for repeat requests (0 = no caching)"
+    )
+    validate_solves: bool = Field(
+        default=True,
+        description="Check every C engine solve for constraint violations"
+    )
     
     model_config = {
         "env_prefix": "ENGINE_",
@@ -217,41 +239,48 @@ class EngineConfig(BaseSettings):
 # HELPER FUNCTIONS
 # ============================================
 
-def get_slot_from_time(hour: int, minute: int = 0) -> int:
+def get_slot_from_time(hour: int, minute: int = 0, slot_minutes: int = 30) -> int:
     """
-    Convert time to slot index (30-minute slots).
+    Convert time to slot index.
     
     Args:
         hour: Hour (0-23)
         minute: Minute (0-59)
+        slot_minutes: Slot granularity (15, 30 or 60)
         
     Returns:
-        Slot index (0-47 for a single day)
+        Slot index (0-47 for a single day of 30-minute slots)
     """
-    return hour * 2 + (1 if minute >= 30 else 0)
+    return (hour * 60 + minute) // slot_minutes
 
 
-def get_time_from_slot(slot: int) -> tuple[int, int]:
+def get_time_from_slot(slot: int, slot_minutes: int = 30) -> tuple[int, int]:
     """
     Convert slot index to time.
     
     Args:
         slot: Slot index
+        slot_minutes: Slot granularity (15, 30 or 60)
         
     Returns:
         Tuple of (hour, minute)
     """
-    hour = (slot // 2) % 24
-    minute = 30 if slot % 2 else 0
-    return hour, minute
+    minutes = (slot * slot_minutes) % (24 * 60)
+    return minutes // 60, minutes % 60
 
 
-def get_optimization_config(schedule_config: ScheduleConfig) -> Dict[str, int]:
+def get_optimization_config(
+    schedule_config: ScheduleConfig,
+    slot_minutes: int = 30,
+    horizon_weeks: int = 1
+) -> Dict[str, int]:
     """
     Get optimization configuration for C engine.
     
     Args:
         schedule_config: Schedule configuration instance
+        slot_minutes: Slot granularity (15, 30 or 60)
+        horizon_weeks: Weeks in the horizon (1-4)
         
     Returns:
         Dictionary with slot-based configuration for C engine
@@ -262,18 +291,23 @@ def get_optimization_config(schedule_config: ScheduleConfig) -> Dict[str, int]:
     ) % 24
     sleep_end_minute = int((schedule_config.sleep_duration_hours % 1) * 60)
     
+    def slot(hour: int, minute: int = 0) -> int:
+        return get_slot_from_time(hour, minute, slot_minutes)
+    
     return {
-        "sleep_start_slot": get_slot_from_time(
+        "sleep_start_slot": slot(
             schedule_config.sleep_start_hour,
             schedule_config.sleep_start_minute
         ),
-        "sleep_end_slot": get_slot_from_time(sleep_end_hour, sleep_end_minute),
-        "concept_peak_start": get_slot_from_time(schedule_config.concept_peak_start_hour),
-        "concept_peak_end": get_slot_from_time(schedule_config.concept_peak_end_hour),
-        "practice_peak_start": get_slot_from_time(schedule_config.practice_peak_start_hour),
-        "practice_peak_end": get_slot_from_time(schedule_config.practice_peak_end_hour),
-        "deep_work_min_slots": schedule_config.deep_work_min_minutes // 30,
-        "micro_gap_max_slots": schedule_config.micro_gap_max_minutes // 30,
+        "sleep_end_slot": slot(sleep_end_hour, sleep_end_minute),
+        "concept_peak_start": slot(schedule_config.concept_peak_start_hour),
+        "concept_peak_end": slot(schedule_config.concept_peak_end_hour),
+        "practice_peak_start": slot(schedule_config.practice_peak_start_hour),
+        "practice_peak_end": slot(schedule_config.practice_peak_end_hour),
+        "deep_work_min_slots": schedule_config.deep_work_min_minutes // slot_minutes,
+        "micro_gap_max_slots": schedule_config.micro_gap_max_minutes // slot_minutes,
+        "slot_minutes": slot_minutes,
+        "horizon_weeks": horizon_weeks,
     }
 
 
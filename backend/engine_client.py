@@ -0,0 +1,70 @@
+"""
+Personal Engineering OS - Engine Socket Client
+Sends requests to a scheduler started with --serve.
+
+The server answers one JSON object per line (see engine/server.h). Each
+call here opens a connection, sends one request line and reads its reply,
+so callers need no connection state.
+"""
+
+import itertools
+import json
+import os
+import socket
+from typing import Any, Dict
+
+ENGINE_SOCKET = os.getenv("ENGINE_SOCKET", "../engine/scheduler.sock")
+ENGINE_SOCKET_TIMEOUT = 10.0
+
+_request_ids = itertools.count(1)
+
+
+class EngineUnavailable(Exception):
+    """No server is listening on the socket (or the platform has no Unix sockets)."""
+
+
+class EngineRequestError(Exception):
+    """The server answered with "ok": false."""
+
+
+def engine_request(cmd: str, socket_path: str = ENGINE_SOCKET, **fields: Any) -> Any:
+    """Send {"cmd": cmd, ...fields} and return the reply's "result".
+
+    Raises EngineUnavailable if the server cannot be reached, and
+    EngineRequestError if it rejects the request.
+    """
+    if not hasattr(socket, "AF_UNIX"):
+        raise EngineUnavailable("Unix sockets are not supported on this platform")
+
+    request_id = next(_request_ids)
+    line = json.dumps({"id": request_id, "cmd": cmd, **fields}) + "\n"
+
+    try:
+        with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+            sock.settimeout(ENGINE_SOCKET_TIMEOUT)
+            sock.connect(socket_path)
+            sock.sendall(line.encode("utf-8"))
+            reply = _read_line(sock)
+    except (FileNotFoundError, ConnectionRefusedError) as e:
+        raise EngineUnavailable(str(e)) from e
+
+    response: Dict[str, Any] = json.loads(reply)
+    if response.get("id") != request_id:
+        raise EngineRequestError(f"reply for request {response.get('id')}, expected {request_id}")
+    if not response.get("ok"):
+        raise EngineRequestError(response.get("error", "request failed"))
+    return response.get("result")
+
+
+def _read_line(sock: socket.socket) -> bytes:
+    """Read one reply line, without its newline."""
+    chunks = []
+    while True:
+        chunk = sock.recv(65536)
+        if not chunk:
+            raise EngineRequestError("server closed the connection without a reply")
+        end = chunk.find(b"\n")
+        if end >= 0:
+            chunks.append(chunk[:end])
+            return b"".join(chunks)
+        chunks.append(chunk)
@@ -19,6 +19,7 @@ from database import (
     get_ai_memory, save_ai_memory, get_ai_guidelines, add_ai_guideline,
     create_notification, get_unread_notifications
 )
+from engine_client import engine_request, EngineUnavailable, EngineRequestError
 
 
 # Base upload directory
@@ -1039,7 +1040,16 @@ async def tool_edit_schedule(args: Dict[str, Any]) -> Dict[str, Any]:
 
 
 async def tool_analyze_gaps(args: Dict[str, Any]) -> Dict[str, Any]:
-    """Call C engine to analyze deep work gaps."""
+    """Ask the C engine for deep work gaps, over its socket if it is serving."""
+    try:
+        gaps = engine_request("analyze-gaps")
+        return {"success": True, "gaps": gaps}
+    except EngineUnavailable:
+        pass
+    except (EngineRequestError, OSError, ValueError) as e:
+        return {"success": False, "error": str(e)}
+    
+    # No server running: start the CLI for this one request
     try:
         result = subprocess.run(
             [ENGINE_PATH, "--analyze-gaps", "--json"],
@@ -1049,7 +1059,10 @@ async def tool_analyze_gaps(args: Dict[str, Any]) -> Dict[str, Any]:
         )
         
         if result.returncode == 0:
-            gaps = json.loads(result.stdout)
+            # The document is the last line; status lines such as
+            # "Schedule loaded from ..." come before it
+            lines = result.stdout.strip().splitlines()
+            gaps = json.loads(lines[-1]) if lines else {"gaps": [], "count": 0}
             return {"success": True, "gaps": gaps}
         else:
             return {"success": False, "error": result.stderr}
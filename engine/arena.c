@@ -0,0 +1,231 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * arena.c - Bump allocator for per-request memory
+ *
+ * Blocks form a singly linked list. Allocation bumps through the current
+ * block and moves on to the next one (reusing a spare left behind by a
+ * rewind, or mallocing a new one) when it runs out. A reset that finds
+ * more than one block replaces them with a single block of the combined
+ * size, so after the first few requests every request fits in one block.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define ARENA_DEFAULT_BLOCK (256 * 1024)
+#define ARENA_ALIGN 16
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;               /* Usable bytes after the header */
+    size_t used;
+} ArenaBlock;
+
+/* Data starts after the header, rounded up to the alignment */
+#define BLOCK_HEADER ((sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+#define BLOCK_DATA(b) ((unsigned char*)(b) + BLOCK_HEADER)
+
+struct Arena {
+    ArenaBlock* head;
+    ArenaBlock* current;       /* Blocks after this one are spares */
+    size_t block_size;
+    size_t used_before;        /* Bytes used in blocks before current */
+    ArenaStats stats;
+};
+
+/* ============================================
+ * BLOCK MANAGEMENT
+ * ============================================ */
+
+static size_t align_up(size_t n) {
+    return (n + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaBlock* block_new(size_t size) {
+    ArenaBlock* block = (ArenaBlock*)malloc(BLOCK_HEADER + size);
+    if (block) {
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+    }
+    return block;
+}
+
+static void blocks_free(ArenaBlock* block) {
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+static size_t arena_used(const Arena* arena) {
+    return arena->used_before + (arena->current ? arena->current->used : 0);
+}
+
+/* Move to a block with room for size bytes; false if out of memory */
+static int arena_advance(Arena* arena, size_t size) {
+    ArenaBlock* cur = arena->current;
+
+    /* Reuse the next spare if it is big enough */
+    if (cur && cur->next && cur->next->size >= size) {
+        arena->used_before += cur->used;
+        arena->current = cur->next;
+        arena->current->used = 0;
+        return 1;
+    }
+
+    ArenaBlock* block = block_new(size > arena->block_size ? size : arena->block_size);
+    if (!block) {
+        return 0;
+    }
+
+    arena->stats.bytes_reserved += block->size;
+    arena->stats.block_count++;
+
+    if (cur) {
+        block->next = cur->next;
+        cur->next = block;
+        arena->used_before += cur->used;
+    } else {
+        block->next = arena->head;
+        arena->head = block;
+    }
+    arena->current = block;
+    return 1;
+}
+
+/* ============================================
+ * PUBLIC API
+ * ============================================ */
+
+Arena* arena_create(size_t block_size) {
+    Arena* arena = (Arena*)calloc(1, sizeof(Arena));
+    if (!arena) {
+        return NULL;
+    }
+    arena->block_size = block_size ? align_up(block_size) : ARENA_DEFAULT_BLOCK;
+    return arena;
+}
+
+void arena_destroy(Arena* arena) {
+    if (arena) {
+        blocks_free(arena->head);
+        free(arena);
+    }
+}
+
+void* arena_alloc(Arena* arena, size_t size) {
+    if (!arena) {
+        return NULL;
+    }
+
+    size = align_up(size ? size : 1);
+    ArenaBlock* cur = arena->current;
+    if (!cur || cur->size - cur->used < size) {
+        if (!arena_advance(arena, size)) {
+            return NULL;
+        }
+        cur = arena->current;
+    }
+
+    void* p = BLOCK_DATA(cur) + cur->used;
+    cur->used += size;
+
+    arena->stats.alloc_count++;
+    size_t used = arena_used(arena);
+    if (used > arena->stats.high_water) {
+        arena->stats.high_water = used;
+    }
+    return p;
+}
+
+void* arena_calloc(Arena* arena, size_t count, size_t size) {
+    if (size && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    void* p = arena_alloc(arena, count * size);
+    if (p) {
+        memset(p, 0, count * size);
+    }
+    return p;
+}
+
+void arena_reset(Arena* arena) {
+    if (!arena) {
+        return;
+    }
+
+    /* Coalesce so the next request of this size needs a single block */
+    if (arena->stats.block_count > 1) {
+        ArenaBlock* merged = block_new(arena->stats.bytes_reserved);
+        if (merged) {
+            blocks_free(arena->head);
+            arena->head = merged;
+            arena->stats.block_count = 1;
+        }
+    }
+
+    for (ArenaBlock* b = arena->head; b; b = b->next) {
+        b->used = 0;
+    }
+    arena->current = arena->head;
+    arena->used_before = 0;
+    arena->stats.alloc_count = 0;
+    arena->stats.reset_count++;
+}
+
+ArenaMark arena_mark(const Arena* arena) {
+    ArenaMark mark = { NULL, 0 };
+    if (arena && arena->current) {
+        mark.block = arena->current;
+        mark.used = arena->current->used;
+    }
+    return mark;
+}
+
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    if (!arena || !arena->head) {
+        return;
+    }
+
+    /* A mark taken before the first block existed rewinds to empty */
+    ArenaBlock* target = mark.block ? (ArenaBlock*)mark.block : arena->head;
+    size_t used = mark.block ? mark.used : 0;
+
+    /* Blocks between the mark and the current block become spares */
+    size_t before = 0;
+    for (ArenaBlock* b = arena->head; b != target; b = b->next) {
+        before += b->used;
+    }
+    for (ArenaBlock* b = target->next; b && b != arena->current->next; b = b->next) {
+        b->used = 0;
+    }
+
+    target->used = used;
+    arena->current = target;
+    arena->used_before = before;
+}
+
+void arena_get_stats(const Arena* arena, ArenaStats* out) {
+    if (!out) {
+        return;
+    }
+    if (!arena) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = arena->stats;
+    out->bytes_used = arena_used(arena);
+}
@@ -0,0 +1,51 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * arena.h - Bump allocator for per-request memory
+ *
+ * An arena hands out memory by bumping a pointer through large blocks and
+ * never frees individual allocations. Everything allocated since the last
+ * arena_reset is released at once by the next reset, which keeps the
+ * memory mapped so steady-state requests do not touch malloc at all.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct Arena Arena;
+
+/* Usage counters (must match the Python ArenaStats mirror) */
+typedef struct {
+    size_t bytes_used;         /* Allocated since the last reset */
+    size_t high_water;         /* Largest bytes_used ever seen */
+    size_t bytes_reserved;     /* Total size of all blocks held */
+    size_t block_count;
+    size_t alloc_count;        /* Allocations since the last reset */
+    size_t reset_count;
+} ArenaStats;
+
+/* Position to rewind to, for scratch memory inside a request */
+typedef struct {
+    void* block;
+    size_t used;
+} ArenaMark;
+
+/* block_size 0 picks a default; requests larger than a block get their own */
+Arena* arena_create(size_t block_size);
+void arena_destroy(Arena* arena);
+
+/* 16-byte aligned; NULL on allocation failure */
+void* arena_alloc(Arena* arena, size_t size);
+void* arena_calloc(Arena* arena, size_t count, size_t size);
+
+/* Release everything at once; memory is kept for the next request */
+void arena_reset(Arena* arena);
+
+/* Release everything allocated after the mark was taken */
+ArenaMark arena_mark(const Arena* arena);
+void arena_rewind(Arena* arena, ArenaMark mark);
+
+void arena_get_stats(const Arena* arena, ArenaStats* out);
+
+#endif /* ARENA_H */
@@ -0,0 +1,606 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * bench_engine.c - Solver benchmark over seeded synthetic weeks
+ *
+ * Each workload generates a fixed set of weeks from the seed (the same
+ * weeks on every platform and every run), solves each of them with the
+ * greedy solver, with greedy plus a move-limited local-search pass, with
+ * a node-limited branch-and-bound search and with the portfolio, once
+ * more greedily with every week already in the result cache, and
+ * greedily on base timelines holding each week's classes. It reports
+ * per-solve latency percentiles, solves per second, conflicts and the
+ * placement score as one JSON document on stdout. Conflicts and score
+ * are deterministic for a given seed, so any change to them means the
+ * solver itself changed. The exception is the portfolio on more than
+ * one thread, whose workers race. A base solve must give what the plain
+ * greedy solve gives, and timeline_what_if must predict what the edits
+ * it evaluates do when applied (checked on the first weeks, replacing
+ * some tasks and inserting others): if either differs on any workload,
+ * the run fails. The scale workloads (1k and 10k tasks a week, far more
+ * than a week holds) solve fewer weeks, capped by max_weeks, to show how
+ * the solver grows with task count. Build and run with `make bench`.
+ *
+ *   bench_engine [--seed N] [--weeks N] [--workload NAME] [--nodes N] [--moves N]
+ *                [--threads N]
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L     /* clock_gettime */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#endif
+
+#include "scheduler_engine.h"
+#include "json_writer.h"
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define BENCH_SEED 20240917u
+#define BENCH_WEEKS 200              /* Weeks generated per workload */
+#define BENCH_MAX_WEEKS 1024         /* The most results the cache holds */
+#define BENCH_WARMUP 10              /* Untimed solves before each run */
+#define BENCH_NODE_LIMIT 20000       /* Branch-and-bound budget, in nodes so results repeat */
+#define BENCH_MOVES 2000             /* Local-search budget, in moves for the same reason */
+#define BENCH_WHAT_IF_WEEKS 20       /* Weeks whose what-if answers are checked */
+#define BENCH_WHAT_IF_CANDIDATES 8   /* Candidate edits per checked week */
+
+/* ============================================
+ * WORKLOADS
+ * ============================================ */
+
+typedef struct {
+    const char* name;
+    int tasks;                 /* Tasks per week */
+    int locked_pct;            /* Share that are locked classes at a fixed slot */
+    int micro_pct;             /* Share of the rest that take a single slot */
+    int min_duration;          /* Slots, for the remaining flexible tasks */
+    int max_duration;
+    int deadline_days;         /* Deadline within this many days of a random day (7 = end of week) */
+    int preferred_pct;         /* Share of flexible tasks that ask for a slot */
+    int max_weeks;             /* Weeks solved at most (0 = all); bounds the scale runs */
+} Workload;
+
+static const Workload g_workloads[] = {
+    { "sparse",         12, 20,  0, 2, 4, 7, 10,  0 },
+    { "dense",          70, 15, 10, 1, 4, 7, 10,  0 },
+    { "deadline_heavy", 40, 10,  0, 2, 4, 2, 10,  0 },
+    { "micro_gap",      90, 20, 60, 1, 3, 7,  5,  0 },
+    { "locked_heavy",   50, 60,  0, 2, 3, 7, 20,  0 },
+    { "overcommitted", 120, 10,  0, 4, 8, 3, 10,  0 },
+    { "scale_1k",     1000, 10, 20, 1, 4, 7, 10, 50 },
+    { "scale_10k",   10000, 10, 20, 1, 4, 7, 10, 10 },
+};
+
+#define WORKLOAD_COUNT ((int)(sizeof(g_workloads) / sizeof(g_workloads[0])))
+
+/* Weeks a run of the workload solves when --weeks asks for n */
+static int workload_weeks(const Workload* wl, int n) {
+    return wl->max_weeks > 0 && wl->max_weeks < n ? wl->max_weeks : n;
+}
+
+static const int g_flexible_categories[] = {
+    TASK_STUDY_CONCEPT, TASK_STUDY_PRACTICE, TASK_REVISION, TASK_ASSIGNMENT, TASK_LAB_WORK
+};
+
+/* xorshift32: the same sequence on every platform */
+static uint32_t next_random(uint32_t* state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+static int random_between(uint32_t* state, int lo, int hi) {
+    return lo + (int)(next_random(state) % (uint32_t)(hi - lo + 1));
+}
+
+/* The default week: 30-minute slots, sleep 22:00-06:00, peaks as documented */
+static OptimizationConfig default_config(void) {
+    OptimizationConfig config;
+    memset(&config, 0, sizeof(config));
+    config.sleep_start_slot = 44;
+    config.sleep_end_slot = 12;
+    config.concept_peak_start = 16;
+    config.concept_peak_end = 24;
+    config.practice_peak_start = 32;
+    config.practice_peak_end = 40;
+    config.deep_work_min_slots = 3;
+    config.micro_gap_max_slots = 1;
+    config.enable_heuristics = true;
+    return config;
+}
+
+/* Week number week of a workload; classes fall between 08:00 and 18:00 */
+static void generate_week(const Workload* wl, uint32_t seed, int week, TimelineTask* tasks) {
+    uint32_t state = seed ^ (uint32_t)(week + 1) * 2654435761u;
+    if (state == 0) {
+        state = 1;
+    }
+
+    for (int i = 0; i < wl->tasks; i++) {
+        TimelineTask* t = &tasks[i];
+        memset(t, 0, sizeof(*t));
+        t->id = i + 1;
+        t->assigned_slot = -1;
+        t->preferred_slot = -1;
+        t->deadline_slot = WEEK_SLOTS - 1;
+
+        if (random_between(&state, 1, 100) <= wl->locked_pct) {
+            int day = random_between(&state, 0, 6);
+            t->category = TASK_FIXED_CLASS;
+            t->is_locked = true;
+            t->priority = 10;
+            t->duration_slots = random_between(&state, 2, 3);
+            t->preferred_slot = day * SLOTS_PER_DAY + random_between(&state, 16, 36 - t->duration_slots);
+            snprintf(t->title, sizeof(t->title), "Class %d", i + 1);
+            continue;
+        }
+
+        t->category = random_between(&state, 1, 100) <= wl->micro_pct
+                    ? TASK_MICRO_GAP
+                    : g_flexible_categories[next_random(&state) % 5];
+        t->priority = random_between(&state, 1, 10);
+        t->duration_slots = t->category == TASK_MICRO_GAP
+                          ? 1 : random_between(&state, wl->min_duration, wl->max_duration);
+        if (wl->deadline_days < 7) {
+            int day = random_between(&state, 0, 6);
+            int end = day + random_between(&state, 1, wl->deadline_days);
+            t->deadline_slot = (end > 7 ? 7 : end) * SLOTS_PER_DAY - 1;
+        }
+        if (random_between(&state, 1, 100) <= wl->preferred_pct) {
+            t->preferred_slot = random_between(&state, 0, WEEK_SLOTS - t->duration_slots);
+        }
+        snprintf(t->title, sizeof(t->title), "Task %d", i + 1);
+    }
+}
+
+/* ============================================
+ * MEASUREMENT
+ * ============================================ */
+
+static int64_t monotonic_ns(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (int64_t)(now.QuadPart / freq.QuadPart) * 1000000000 +
+           (int64_t)(now.QuadPart % freq.QuadPart) * 1000000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+static int compare_int64(const void* a, const void* b) {
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static int64_t percentile(const int64_t* sorted, int n, int pct) {
+    int rank = (pct * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+typedef struct {
+    int solves;
+    int failed;                /* Solves that returned NULL */
+    int64_t elapsed_ns;
+    int64_t conflicts;
+    int64_t placed;
+    int64_t score;
+    int64_t preferred;         /* Flexible tasks on their preferred slot */
+    int timeouts;              /* Search stopped by its node budget */
+    int64_t* latency_ns;       /* One per solve, sorted after the run */
+} RunResult;
+
+/*
+ * Each week split into a base with its classes and the remaining tasks.
+ * A solve on a base reports only its own tasks, so the classes' placed
+ * count and score are kept here to add back: base rows then count the
+ * same tasks as the from-scratch ones
+ */
+typedef struct {
+    TimelineBase** bases;
+    TimelineTask* tasks;       /* Week i's own tasks start at i * tasks per week */
+    int* counts;
+    int* class_placed;         /* Classes the base placed */
+    int64_t* class_score;      /* Their placement score */
+} BaseWeeks;
+
+static bool build_base_weeks(const Workload* wl, const TimelineTask* weeks, int n_weeks,
+                             const OptimizationConfig* config, BaseWeeks* out) {
+    TimelineTask* classes = (TimelineTask*)malloc(sizeof(TimelineTask) * (size_t)wl->tasks);
+    out->bases = (TimelineBase**)calloc((size_t)n_weeks, sizeof(TimelineBase*));
+    out->tasks = (TimelineTask*)malloc(sizeof(TimelineTask) * (size_t)n_weeks * (size_t)wl->tasks);
+    out->counts = (int*)malloc(sizeof(int) * (size_t)n_weeks);
+    out->class_placed = (int*)malloc(sizeof(int) * (size_t)n_weeks);
+    out->class_score = (int64_t*)malloc(sizeof(int64_t) * (size_t)n_weeks);
+    if (!classes || !out->bases || !out->tasks || !out->counts || !out->class_placed || !out->class_score) {
+        free(classes);
+        return false;
+    }
+    int slot_count = get_solve_slots(config, NULL);
+    for (int i = 0; i < n_weeks; i++) {
+        const TimelineTask* week = &weeks[i * wl->tasks];
+        int n_classes = 0;
+        out->counts[i] = 0;
+        for (int t = 0; t < wl->tasks; t++) {
+            if (week[t].category == TASK_FIXED_CLASS && week[t].is_locked) {
+                classes[n_classes++] = week[t];
+            } else {
+                out->tasks[i * wl->tasks + out->counts[i]++] = week[t];
+            }
+        }
+        out->bases[i] = timeline_base_create(classes, n_classes, config);
+        if (!out->bases[i]) {
+            free(classes);
+            return false;
+        }
+
+        /* The base places the classes as a solve force-places locked tasks */
+        out->class_placed[i] = 0;
+        for (int c = 0; c < n_classes; c++) {
+            TimelineTask* t = &classes[c];
+            bool fits = t->preferred_slot >= 0 && t->preferred_slot + t->duration_slots <= slot_count;
+            t->assigned_slot = fits ? t->preferred_slot : -1;
+            out->class_placed[i] += fits;
+        }
+        WeeklyTimeline placed = { .tasks = classes, .task_count = n_classes,
+                                  .slots_per_day = slot_count / (7 * (config->horizon_weeks ? config->horizon_weeks : 1)) };
+        out->class_score[i] = timeline_placement_score(&placed, config);
+    }
+    free(classes);
+    return true;
+}
+
+static void free_base_weeks(BaseWeeks* based, int n_weeks) {
+    for (int i = 0; based->bases && i < n_weeks; i++) {
+        timeline_base_destroy(based->bases[i]);
+    }
+    free(based->bases);
+    free(based->tasks);
+    free(based->counts);
+    free(based->class_placed);
+    free(based->class_score);
+}
+
+static WeeklyTimeline* solve_week(EngineContext* ctx, const Workload* wl, const TimelineTask* weeks,
+                                  const BaseWeeks* based, int i, const OptimizationConfig* config,
+                                  const SolveOptions* options) {
+    if (based) {
+        return optimize_timeline_base_ctx(ctx, based->bases[i], &based->tasks[i * wl->tasks],
+                                          based->counts[i], options);
+    }
+    return optimize_timeline_ctx(ctx, &weeks[i * wl->tasks], wl->tasks, config, options);
+}
+
+static void run_workload(EngineContext* ctx, const Workload* wl, const TimelineTask* weeks,
+                         const BaseWeeks* based, int n_weeks, const OptimizationConfig* config,
+                         const SolveOptions* options, RunResult* out) {
+    for (int i = 0; i < BENCH_WARMUP && i < n_weeks; i++) {
+        solve_week(ctx, wl, weeks, based, i, config, options);
+        engine_context_reset(ctx);
+    }
+
+    out->solves = n_weeks;
+    int64_t start = monotonic_ns();
+    for (int i = 0; i < n_weeks; i++) {
+        int64_t t0 = monotonic_ns();
+        WeeklyTimeline* timeline = solve_week(ctx, wl, weeks, based, i, config, options);
+        out->latency_ns[i] = monotonic_ns() - t0;
+
+        if (!timeline) {
+            out->failed++;
+        } else {
+            out->conflicts += timeline->total_conflicts;
+            out->placed += timeline->total_gaps_filled;
+            out->score += timeline_placement_score(timeline, config);
+            for (int t = 0; t < timeline->task_count; t++) {
+                const TimelineTask* task = &timeline->tasks[t];
+                out->preferred += !task->is_locked && task->preferred_slot >= 0 &&
+                                  task->assigned_slot == task->preferred_slot;
+            }
+            out->timeouts += timeline->optimization_status == -2;
+            if (based) {
+                out->placed += based->class_placed[i];
+                out->score += based->class_score[i];
+            }
+        }
+        engine_context_reset(ctx);
+    }
+    out->elapsed_ns = monotonic_ns() - start;
+    qsort(out->latency_ns, (size_t)n_weeks, sizeof(int64_t), compare_int64);
+}
+
+/*
+ * Evaluate candidate edits of each checked week with timeline_what_if,
+ * then apply each one to a fresh handle (remove any task with its id,
+ * then insert) and compare. Even candidates replace the task with their
+ * id, odd ones are new. Returns the number of mismatches, or -1 if a
+ * handle cannot be opened.
+ */
+static int check_what_if(const Workload* wl, const TimelineTask* weeks, int n_weeks,
+                         const OptimizationConfig* config) {
+    int checked = n_weeks < BENCH_WHAT_IF_WEEKS ? n_weeks : BENCH_WHAT_IF_WEEKS;
+    int n_cand = wl->tasks < BENCH_WHAT_IF_CANDIDATES ? wl->tasks : BENCH_WHAT_IF_CANDIDATES;
+    int* before = (int*)malloc(sizeof(int) * (size_t)(wl->tasks + 1));   /* Slot by id */
+    int mismatches = 0;
+    if (!before) {
+        return -1;
+    }
+
+    for (int i = 0; i < checked; i++) {
+        const TimelineTask* week = &weeks[i * wl->tasks];
+        const TimelineTask* other = &weeks[((i + 1) % n_weeks) * wl->tasks];
+        TimelineTask cand[BENCH_WHAT_IF_CANDIDATES];
+        WhatIfResult out[BENCH_WHAT_IF_CANDIDATES];
+        for (int c = 0; c < n_cand; c++) {
+            cand[c] = other[c];
+            cand[c].id += (c % 2) * wl->tasks;
+        }
+
+        TimelineHandle* h = timeline_open(week, wl->tasks, config);
+        if (!h || timeline_what_if(h, cand, n_cand, out) != 0) {
+            timeline_close(h);
+            free(before);
+            return -1;
+        }
+        const WeeklyTimeline* tl = timeline_get(h);
+        for (int t = 0; t < tl->task_count; t++) {
+            before[tl->tasks[t].id] = tl->tasks[t].assigned_slot;
+        }
+
+        for (int c = 0; c < n_cand; c++) {
+            TimelineHandle* e = timeline_open(week, wl->tasks, config);
+            if (!e) {
+                timeline_close(h);
+                free(before);
+                return -1;
+            }
+            timeline_remove_task(e, cand[c].id);
+            int slot = timeline_insert_task(e, &cand[c]);
+            const WeeklyTimeline* after = timeline_get(e);
+            int moved = 0;
+            for (int t = 0; t < after->task_count; t++) {
+                const TimelineTask* task = &after->tasks[t];
+                moved += task->id != cand[c].id && task->id <= wl->tasks && before[task->id] >= 0 &&
+                         task->assigned_slot >= 0 && task->assigned_slot != before[task->id];
+            }
+            mismatches += slot != out[c].best_slot ||
+                          after->total_conflicts - tl->total_conflicts != out[c].conflicts ||
+                          timeline_placement_score(after, config) - timeline_placement_score(tl, config) !=
+                              out[c].score_delta ||
+                          moved != out[c].moved;
+            timeline_close(e);
+        }
+        timeline_close(h);
+    }
+    free(before);
+    return mismatches;
+}
+
+/* ============================================
+ * REPORT
+ * ============================================ */
+
+static void write_result(JsonWriter* w, const Workload* wl, const char* search, const RunResult* r) {
+    int n = r->solves;
+    json_begin_object(w);
+    json_key(w, "workload");
+    json_string(w, wl->name, strlen(wl->name));
+    json_key(w, "search");
+    json_string(w, search, strlen(search));
+    json_key(w, "tasks_per_week");
+    json_int(w, wl->tasks);
+    json_key(w, "solves");
+    json_int(w, n);
+    json_key(w, "failed");
+    json_int(w, r->failed);
+    json_key(w, "solves_per_sec");
+    json_double(w, r->elapsed_ns > 0 ? n * 1e9 / (double)r->elapsed_ns : 0.0, 1);
+
+    json_key(w, "latency_us");
+    json_begin_object(w);
+    json_key(w, "p50");
+    json_double(w, percentile(r->latency_ns, n, 50) / 1e3, 2);
+    json_key(w, "p90");
+    json_double(w, percentile(r->latency_ns, n, 90) / 1e3, 2);
+    json_key(w, "p99");
+    json_double(w, percentile(r->latency_ns, n, 99) / 1e3, 2);
+    json_key(w, "max");
+    json_double(w, r->latency_ns[n - 1] / 1e3, 2);
+    json_end_object(w);
+
+    json_key(w, "conflicts");
+    json_int(w, r->conflicts);
+    json_key(w, "conflicts_per_week");
+    json_double(w, (double)r->conflicts / n, 3);
+    json_key(w, "placed");
+    json_int(w, r->placed);
+    json_key(w, "score");
+    json_int(w, r->score);
+    json_key(w, "score_per_week");
+    json_double(w, (double)r->score / n, 3);
+    json_key(w, "preferred_hits");
+    json_int(w, r->preferred);
+    json_key(w, "budget_exhausted");
+    json_int(w, r->timeouts);
+    json_end_object(w);
+}
+
+static void usage(const char* program) {
+    fprintf(stderr, "Usage: %s [--seed N] [--weeks N] [--workload NAME] [--nodes N] [--moves N] [--threads N]\n",
+            program);
+    fprintf(stderr, "Workloads:");
+    for (int i = 0; i < WORKLOAD_COUNT; i++) {
+        fprintf(stderr, " %s", g_workloads[i].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = BENCH_SEED;
+    int n_weeks = BENCH_WEEKS;
+    long long nodes = BENCH_NODE_LIMIT;
+    long long moves = BENCH_MOVES;
+    int threads = 0;
+    const char* only = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--seed") == 0 && has_value) {
+            seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--weeks") == 0 && has_value) {
+            n_weeks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--nodes") == 0 && has_value) {
+            nodes = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--moves") == 0 && has_value) {
+            moves = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workload") == 0 && has_value) {
+            only = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (n_weeks < 1 || n_weeks > BENCH_MAX_WEEKS || nodes < 1 || moves < 1 || threads < 0) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    OptimizationConfig config = default_config();
+    const struct {
+        const char* name;
+        SolveOptions options;
+        bool cached;           /* Solve every week once untimed, then time the repeats */
+        bool on_base;          /* Solve each week's own tasks on a base with its classes */
+    } modes[] = {
+        { "greedy",           { .search_mode = SEARCH_GREEDY }, false, false },
+        { "greedy_local",     { .search_mode = SEARCH_GREEDY, .improve_iterations = moves }, false, false },
+        { "branch_and_bound", { .search_mode = SEARCH_BRANCH_AND_BOUND, .node_limit = nodes }, false, false },
+        { "portfolio",        { .search_mode = SEARCH_PORTFOLIO, .node_limit = nodes,
+                                .improve_iterations = moves }, false, false },
+        { "greedy_repeat",    { .search_mode = SEARCH_GREEDY }, true, false },
+        { "greedy_base",      { .search_mode = SEARCH_GREEDY }, false, true },
+    };
+    set_engine_threads(threads);
+    engine_cache_configure(0);         /* Only the repeat mode measures the cache */
+    EngineContext* ctx = engine_context_create(0);
+    size_t week_tasks = 0;
+    for (int k = 0; k < WORKLOAD_COUNT; k++) {
+        size_t n = (size_t)workload_weeks(&g_workloads[k], n_weeks) * (size_t)g_workloads[k].tasks;
+        week_tasks = n > week_tasks ? n : week_tasks;
+    }
+    TimelineTask* weeks = (TimelineTask*)malloc(sizeof(TimelineTask) * week_tasks);
+    int64_t* latency = (int64_t*)malloc(sizeof(int64_t) * (size_t)n_weeks);
+    if (!ctx || !weeks || !latency) {
+        fprintf(stderr, "Error: Failed to allocate benchmark\n");
+        return 1;
+    }
+
+    JsonWriter w;
+    json_writer_to_file(&w, stdout);
+    json_begin_object(&w);
+    json_key(&w, "engine");
+    json_begin_object(&w);
+    json_key(&w, "version");
+    json_string(&w, get_engine_version(), strlen(get_engine_version()));
+    json_key(&w, "simd");
+    json_string(&w, get_engine_simd(), strlen(get_engine_simd()));
+    json_end_object(&w);
+    json_key(&w, "seed");
+    json_int(&w, seed);
+    json_key(&w, "weeks");
+    json_int(&w, n_weeks);
+    json_key(&w, "node_limit");
+    json_int(&w, nodes);
+    json_key(&w, "move_limit");
+    json_int(&w, moves);
+    json_key(&w, "threads");
+    json_int(&w, get_engine_threads());
+    json_key(&w, "results");
+    json_begin_array(&w);
+
+    int matched = 0;
+    int diverged = 0;
+    for (int k = 0; k < WORKLOAD_COUNT; k++) {
+        const Workload* wl = &g_workloads[k];
+        if (only && strcmp(only, wl->name) != 0) {
+            continue;
+        }
+        matched++;
+        int runs = workload_weeks(wl, n_weeks);
+        for (int i = 0; i < runs; i++) {
+            generate_week(wl, seed + (uint32_t)k, i, &weeks[i * wl->tasks]);
+        }
+
+        RunResult plain;
+        memset(&plain, 0, sizeof(plain));
+        for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            RunResult r;
+            BaseWeeks based = { NULL, NULL, NULL, NULL, NULL };
+            if (modes[m].on_base && !build_base_weeks(wl, weeks, runs, &config, &based)) {
+                fprintf(stderr, "Error: Failed to build base timelines\n");
+                return 1;
+            }
+            const BaseWeeks* bases = modes[m].on_base ? &based : NULL;
+            if (modes[m].cached) {
+                engine_cache_configure(runs);
+                memset(&r, 0, sizeof(r));
+                r.latency_ns = latency;
+                run_workload(ctx, wl, weeks, bases, runs, &config, &modes[m].options, &r);
+            }
+            memset(&r, 0, sizeof(r));
+            r.latency_ns = latency;
+            run_workload(ctx, wl, weeks, bases, runs, &config, &modes[m].options, &r);
+            write_result(&w, wl, modes[m].name, &r);
+            if (m == 0) {
+                plain = r;
+            } else if (modes[m].on_base &&
+                       (r.conflicts != plain.conflicts || r.placed != plain.placed ||
+                        r.score != plain.score || r.preferred != plain.preferred)) {
+                fprintf(stderr, "Error: %s on %s differs from %s\n", modes[m].name, wl->name, modes[0].name);
+                diverged++;
+            }
+            engine_cache_configure(0);
+            free_base_weeks(&based, runs);
+        }
+
+        int wrong = check_what_if(wl, weeks, runs, &config);
+        if (wrong != 0) {
+            fprintf(stderr, "Error: timeline_what_if on %s: %s\n", wl->name,
+                    wrong < 0 ? "failed to open a timeline" : "differs from applying the edit");
+            diverged++;
+        }
+    }
+
+    json_end_array(&w);
+    json_end_object(&w);
+    json_raw(&w, "\n", 1);
+    json_writer_finish(&w);
+
+    free(latency);
+    free(weeks);
+    engine_context_destroy(ctx);
+    if (only && matched == 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    return w.error || diverged ? 1 : 0;
+}
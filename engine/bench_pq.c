@@ -0,0 +1,163 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * bench_pq.c - Lab queue micro-benchmark
+ *
+ * Replays one seeded workload against the queue at each heap arity:
+ * deadline updates are the most common operation, then inserts, removes
+ * by id and extract-min, as the server sees them when reports are
+ * rescheduled. Then it times the dashboard's top-k listing. Build and
+ * run with `make bench-pq`.
+ */
+
+#define _POSIX_C_SOURCE 200809L     /* clock_gettime */
+
+#include "scheduler.h"
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define BENCH_SEED 20240917u
+#define BENCH_QUEUE_SIZE 10000       /* Reports loaded before timing */
+#define BENCH_OPERATIONS 2000000
+#define BENCH_DEADLINE_SPAN (90 * 86400)
+#define BENCH_TOP_K 10               /* Dashboard "next due" listing */
+#define BENCH_TOP_K_CALLS 200000
+
+/* ============================================
+ * WORKLOAD
+ * ============================================ */
+
+typedef enum {
+    OP_UPDATE,
+    OP_INSERT,
+    OP_REMOVE,
+    OP_EXTRACT
+} BenchOp;
+
+static uint32_t g_rng = BENCH_SEED;
+
+/* xorshift32: the same sequence on every platform */
+static uint32_t next_random(void) {
+    g_rng ^= g_rng << 13;
+    g_rng ^= g_rng >> 17;
+    g_rng ^= g_rng << 5;
+    return g_rng;
+}
+
+static LabReport random_report(void) {
+    LabReport report = {0};
+    snprintf(report.title, sizeof(report.title), "Lab %u", next_random() % 1000);
+    snprintf(report.subject, sizeof(report.subject), "COMP %u", 100 + next_random() % 300);
+    report.deadline = (time_t)(1700000000 + next_random() % BENCH_DEADLINE_SPAN);
+    report.credits = (int)(next_random() % 5);
+    return report;
+}
+
+/* 60% update, 20% insert, 10% remove, 10% extract */
+static BenchOp random_op(void) {
+    uint32_t r = next_random() % 10;
+    return r < 6 ? OP_UPDATE : r < 8 ? OP_INSERT : r < 9 ? OP_REMOVE : OP_EXTRACT;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+/* ============================================
+ * BENCHMARK
+ * ============================================ */
+
+/* Live ids are kept in a dense array, so a random report is one draw
+ * away, with each id's slot in it alongside */
+static int run(int arity, double* ns_per_op, double* ns_per_top_k, long* checksum) {
+    g_rng = BENCH_SEED;
+    PriorityQueue* pq = pq_create(BENCH_QUEUE_SIZE);
+    int* live = (int*)malloc(sizeof(int) * (BENCH_QUEUE_SIZE + BENCH_OPERATIONS));
+    int* slot_of = (int*)malloc(sizeof(int) * (BENCH_QUEUE_SIZE + BENCH_OPERATIONS + 1));
+    int count = 0;
+    if (!pq || !live || !slot_of || pq_set_arity(pq, arity) != 0) {
+        free(live);
+        free(slot_of);
+        pq_destroy(pq);
+        return -1;
+    }
+
+    for (int i = 0; i < BENCH_QUEUE_SIZE; i++) {
+        int id = pq_insert(pq, random_report());
+        slot_of[id] = count;
+        live[count++] = id;
+    }
+
+    long sum = 0;
+    double start = now_seconds();
+    for (int i = 0; i < BENCH_OPERATIONS; i++) {
+        BenchOp op = random_op();
+        if (count == 0) {
+            op = OP_INSERT;
+        }
+        switch (op) {
+        case OP_UPDATE: {
+            int id = live[next_random() % (uint32_t)count];
+            pq_update_deadline(pq, id, (time_t)(1700000000 + next_random() % BENCH_DEADLINE_SPAN));
+            break;
+        }
+        case OP_INSERT: {
+            int id = pq_insert(pq, random_report());
+            slot_of[id] = count;
+            live[count++] = id;
+            break;
+        }
+        case OP_REMOVE:
+        case OP_EXTRACT: {
+            int id;
+            if (op == OP_REMOVE) {
+                id = live[next_random() % (uint32_t)count];
+                pq_remove(pq, id, NULL);
+            } else {
+                id = pq_extract_min(pq).id;
+                sum += id;
+            }
+            int slot = slot_of[id];
+            live[slot] = live[--count];
+            slot_of[live[slot]] = slot;
+            break;
+        }
+        }
+    }
+    double elapsed = now_seconds() - start;
+    *ns_per_op = elapsed * 1e9 / BENCH_OPERATIONS;
+
+    LabReport top[BENCH_TOP_K];
+    start = now_seconds();
+    for (int i = 0; i < BENCH_TOP_K_CALLS; i++) {
+        sum += pq_top_k(pq, BENCH_TOP_K, top);
+    }
+    *ns_per_top_k = (now_seconds() - start) * 1e9 / BENCH_TOP_K_CALLS;
+
+    *checksum = sum + pq->size;
+    free(live);
+    free(slot_of);
+    pq_destroy(pq);
+    return 0;
+}
+
+int main(void) {
+    static const int arities[] = { 2, 4 };
+
+    printf("Lab queue: %d reports, %d operations (60%% update, 20%% insert, 10%% remove, 10%% extract)\n",
+           BENCH_QUEUE_SIZE, BENCH_OPERATIONS);
+    for (size_t i = 0; i < sizeof(arities) / sizeof(arities[0]); i++) {
+        double ns, top_k_ns;
+        long checksum;
+        if (run(arities[i], &ns, &top_k_ns, &checksum) != 0) {
+            fprintf(stderr, "Error: benchmark setup failed\n");
+            return 1;
+        }
+        printf("  arity %d: %7.1f ns/op, top %d in %.0f ns  (checksum %ld)\n",
+               arities[i], ns, BENCH_TOP_K, top_k_ns, checksum);
+    }
+    return 0;
+}
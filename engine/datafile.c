@@ -0,0 +1,336 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * datafile.c - Versioned fixed-stride record files
+ *
+ * Records are checksummed one by one, each with a hash seeded by its
+ * index, and the header stores the 32-bit sum of those hashes. Only
+ * datafile_save writes, rewriting the whole file and its sum at once;
+ * edits between saves live in the journal (journal.c).
+ * On POSIX systems files are mapped with mmap, over an anonymous
+ * reservation that provides the spare room; elsewhere they are read
+ * into memory.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+    #define _DEFAULT_SOURCE            /* MAP_ANONYMOUS */
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#ifdef _WIN32
+    #include <io.h>
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#include "datafile.h"
+
+#if !defined(_WIN32) && !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+    #define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+#define HEADER_CHECKED_BYTES offsetof(DataFileHeader, header_checksum)
+
+typedef char header_size_check[sizeof(DataFileHeader) == DATAFILE_HEADER_SIZE ? 1 : -1];
+
+/* ============================================
+ * CHECKSUMS
+ * ============================================ */
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/* Seeded by index so that swapped records change the sum */
+static uint32_t record_hash(uint32_t index, const void* record, uint32_t record_size) {
+    return fnv1a(FNV_OFFSET ^ (index * 0x9E3779B1u), record, record_size);
+}
+
+static uint32_t header_hash(const DataFileHeader* header) {
+    return fnv1a(FNV_OFFSET, header, HEADER_CHECKED_BYTES);
+}
+
+/* ============================================
+ * HEADER
+ * ============================================ */
+
+static void header_init(DataFileHeader* header, uint32_t type, uint32_t record_size) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, DATAFILE_MAGIC, sizeof(header->magic));
+    header->version = DATAFILE_VERSION;
+    header->header_size = DATAFILE_HEADER_SIZE;
+    header->record_type = type;
+    header->record_size = record_size;
+    header->byte_order = DATAFILE_BYTE_ORDER;
+}
+
+/* Classify a header read from disk; size is the file size in bytes */
+static DataFileStatus header_check(const DataFileHeader* header, size_t size,
+                                   uint32_t type, uint32_t record_size) {
+    if (size < sizeof(header->magic) || memcmp(header->magic, DATAFILE_MAGIC, sizeof(header->magic)) != 0) {
+        return DATAFILE_LEGACY;
+    }
+    if (size < DATAFILE_HEADER_SIZE) {
+        return DATAFILE_CORRUPT;
+    }
+    if (header->byte_order != DATAFILE_BYTE_ORDER) {
+        return DATAFILE_INCOMPATIBLE;
+    }
+    if (header->header_checksum != header_hash(header) ||
+        header->version != DATAFILE_VERSION ||
+        header->header_size != DATAFILE_HEADER_SIZE ||
+        header->record_type != type) {
+        return DATAFILE_CORRUPT;
+    }
+    if (header->record_size != record_size) {
+        return DATAFILE_INCOMPATIBLE;
+    }
+    return DATAFILE_OK;
+}
+
+static size_t records_present(const DataFileHeader* header, size_t size) {
+    size_t room = (size - DATAFILE_HEADER_SIZE) / header->record_size;
+    return room < header->record_count ? room : header->record_count;
+}
+
+/* ============================================
+ * READING
+ * ============================================ */
+
+DataFileStatus datafile_map(const char* path, uint32_t type, uint32_t record_size,
+                            uint32_t spare, DataFileMap* out) {
+    memset(out, 0, sizeof(*out));
+    size_t extra = (size_t)spare * record_size;
+
+#ifdef _WIN32
+    FILE* fp = fopen(path, "rb");
+    if (!fp) {
+        return DATAFILE_MISSING;
+    }
+    long end = -1;
+    if (fseek(fp, 0, SEEK_END) == 0) {
+        end = ftell(fp);
+    }
+    if (end < 0 || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return DATAFILE_IO_ERROR;
+    }
+    size_t size = (size_t)end;
+    size_t span = size + extra;
+    void* base = malloc(span > 0 ? span : 1);
+    if (!base || fread(base, 1, size, fp) != size) {
+        free(base);
+        fclose(fp);
+        return DATAFILE_IO_ERROR;
+    }
+    fclose(fp);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return DATAFILE_MISSING;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return DATAFILE_IO_ERROR;
+    }
+    size_t size = (size_t)st.st_size;
+    if (size < DATAFILE_HEADER_SIZE) {
+        /* Too short to map usefully; let header_check classify it */
+        DataFileHeader header;
+        memset(&header, 0, sizeof(header));
+        ssize_t got = read(fd, &header, size);
+        close(fd);
+        if (got < 0) {
+            return DATAFILE_IO_ERROR;
+        }
+        return header_check(&header, (size_t)got, type, record_size);
+    }
+    size_t span = size;
+    void* base = MAP_FAILED;
+#ifdef MAP_ANONYMOUS
+    /* Reserve room for spare records, then map the file over its start.
+     * Pages past the file stay anonymous, so touching them is safe */
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    span = (size + extra + page - 1) / page * page;
+    base = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base != MAP_FAILED &&
+        mmap(base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        munmap(base, span);
+        base = MAP_FAILED;
+    }
+#endif
+    if (base == MAP_FAILED) {
+        span = size;
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        return DATAFILE_IO_ERROR;
+    }
+#endif
+
+    DataFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(&header, base, size < sizeof(header) ? size : sizeof(header));
+
+    out->base = base;
+    out->size = span;
+    DataFileStatus status = header_check(&header, size, type, record_size);
+    if (status != DATAFILE_OK) {
+        datafile_unmap(out);
+        return status;
+    }
+
+    out->records = (unsigned char*)base + DATAFILE_HEADER_SIZE;
+    out->stored_count = header.record_count;
+    out->snapshot_id = header.header_checksum;
+    out->record_count = (uint32_t)records_present(&header, size);
+    size_t room = (span - DATAFILE_HEADER_SIZE) / record_size;
+    out->room = room > UINT32_MAX ? UINT32_MAX : (uint32_t)room;
+    if (out->room < out->record_count) {
+        out->room = out->record_count;
+    }
+    return DATAFILE_OK;
+}
+
+void datafile_unmap(DataFileMap* map) {
+    if (map->base) {
+#ifdef _WIN32
+        free(map->base);
+#else
+        munmap(map->base, map->size);
+#endif
+    }
+    memset(map, 0, sizeof(*map));
+}
+
+DataFileStatus datafile_verify(const char* path, uint32_t type, uint32_t record_size) {
+    DataFileMap map;
+    DataFileStatus status = datafile_map(path, type, record_size, 0, &map);
+    if (status != DATAFILE_OK) {
+        return status;
+    }
+
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < map.record_count; i++) {
+        sum += record_hash(i, map.records + (size_t)i * record_size, record_size);
+    }
+
+    DataFileHeader header;
+    memcpy(&header, map.base, sizeof(header));
+    if (map.record_count != map.stored_count || sum != header.records_checksum) {
+        status = DATAFILE_CORRUPT;
+    }
+    datafile_unmap(&map);
+    return status;
+}
+
+/* ============================================
+ * WRITING
+ * ============================================ */
+
+int datafile_flush(FILE* fp) {
+    if (fflush(fp) != 0) {
+        return -1;
+    }
+#ifdef _WIN32
+    return _commit(_fileno(fp)) == 0 ? 0 : -1;
+#else
+    return fsync(fileno(fp)) == 0 ? 0 : -1;
+#endif
+}
+
+/* Make a rename in path's directory durable (best effort) */
+void datafile_sync_parent_dir(const char* path) {
+#ifdef _WIN32
+    (void)path;
+#else
+    char dir[1024];
+    const char* slash = strrchr(path, '/');
+    size_t len = slash ? (size_t)(slash - path) : 0;
+    if (len == 0 || len >= sizeof(dir)) {
+        strcpy(dir, len == 0 && slash ? "/" : ".");
+    } else {
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    int fd = open(dir, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+/* Written to path.tmp and renamed over path, so readers see either the
+ * old file or the new one, never a partial write */
+DataFileStatus datafile_save(const char* path, uint32_t type, uint32_t record_size,
+                             const void* records, uint32_t count, uint32_t* snapshot_id) {
+    DataFileHeader header;
+    header_init(&header, type, record_size);
+    header.record_count = count;
+
+    const unsigned char* bytes = (const unsigned char*)records;
+    for (uint32_t i = 0; i < count; i++) {
+        header.records_checksum += record_hash(i, bytes + (size_t)i * record_size, record_size);
+    }
+    header.header_checksum = header_hash(&header);
+
+    char tmp[1024];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        return DATAFILE_IO_ERROR;
+    }
+    FILE* fp = fopen(tmp, "wb");
+    if (!fp) {
+        return DATAFILE_IO_ERROR;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              (count == 0 || fwrite(records, record_size, count, fp) == count) &&
+              datafile_flush(fp) == 0;
+    ok = (fclose(fp) == 0) && ok;
+#ifdef _WIN32
+    ok = ok && MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    ok = ok && rename(tmp, path) == 0;
+#endif
+    if (!ok) {
+        remove(tmp);
+        return DATAFILE_IO_ERROR;
+    }
+    datafile_sync_parent_dir(path);
+    if (snapshot_id) {
+        *snapshot_id = header.header_checksum;
+    }
+    return DATAFILE_OK;
+}
+
+const char* datafile_status_name(DataFileStatus status) {
+    switch (status) {
+    case DATAFILE_OK:           return "ok";
+    case DATAFILE_MISSING:      return "missing";
+    case DATAFILE_LEGACY:       return "legacy layout";
+    case DATAFILE_CORRUPT:      return "corrupt";
+    case DATAFILE_INCOMPATIBLE: return "written by an incompatible build";
+    case DATAFILE_IO_ERROR:     return "I/O error";
+    }
+    return "unknown";
+}
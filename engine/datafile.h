@@ -0,0 +1,104 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * datafile.h - Versioned fixed-stride record files
+ *
+ * A data file is a DATAFILE_HEADER_SIZE-byte header followed by
+ * record_count records of record_size bytes each, with nothing after
+ * them. Records use the in-memory struct layout of the build that wrote
+ * them, so a mapped file is used in place; record_size and the byte
+ * order marker let a reader reject files from an incompatible build
+ * instead of misreading them. Opening a file checks only the header, so
+ * its cost does not depend on the number of records; datafile_verify
+ * checks the records as well.
+ */
+
+#ifndef DATAFILE_H
+#define DATAFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define DATAFILE_MAGIC "PEOSDAT"        /* 8 bytes with the terminator */
+#define DATAFILE_VERSION 1
+#define DATAFILE_HEADER_SIZE 64
+#define DATAFILE_BYTE_ORDER 0x01020304u /* Read back in the writer's order */
+
+/* What the records are, stored in the header */
+typedef enum {
+    DATAFILE_TASKS = 1,
+    DATAFILE_LABS = 2
+} DataFileType;
+
+/* Status of datafile_map / datafile_verify */
+typedef enum {
+    DATAFILE_OK = 0,
+    DATAFILE_MISSING = 1,      /* No such file */
+    DATAFILE_LEGACY = 2,       /* No header: the original headerless layout */
+    DATAFILE_CORRUPT = 3,      /* Bad header, wrong type or checksum mismatch */
+    DATAFILE_INCOMPATIBLE = 4, /* Written with another record size or byte order */
+    DATAFILE_IO_ERROR = 5
+} DataFileStatus;
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+/* On-disk header, padded to DATAFILE_HEADER_SIZE */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;      /* Offset of record 0 */
+    uint32_t record_type;      /* DataFileType */
+    uint32_t record_size;      /* Stride in bytes */
+    uint32_t byte_order;       /* DATAFILE_BYTE_ORDER */
+    uint32_t record_count;
+    uint32_t records_checksum; /* Sum of per-record hashes (see datafile.c) */
+    uint32_t header_checksum;  /* FNV-1a of every header byte before this field */
+    unsigned char reserved[DATAFILE_HEADER_SIZE - 40];
+} DataFileHeader;
+
+/* Private mapping of a file's records: writes stay in memory */
+typedef struct {
+    void* base;
+    size_t size;               /* Bytes mapped, including the spare room */
+    unsigned char* records;
+    uint32_t record_count;     /* Records actually present */
+    uint32_t stored_count;     /* record_count from the header */
+    uint32_t room;             /* Records that fit in the mapping */
+    uint32_t snapshot_id;      /* header_checksum: changes with every write */
+} DataFileMap;
+
+/* ============================================
+ * FUNCTION PROTOTYPES
+ * ============================================ */
+
+/* Map path's records with room for at least spare more after them, so a
+ * few appends need no copy. record_count < stored_count means the file
+ * is truncated */
+DataFileStatus datafile_map(const char* path, uint32_t type, uint32_t record_size,
+                            uint32_t spare, DataFileMap* out);
+void datafile_unmap(DataFileMap* map);
+
+/* Check every record against records_checksum (reads the whole file) */
+DataFileStatus datafile_verify(const char* path, uint32_t type, uint32_t record_size);
+
+/* Atomically replace path with count records; snapshot_id (optional)
+ * receives the new file's DataFileMap.snapshot_id */
+DataFileStatus datafile_save(const char* path, uint32_t type, uint32_t record_size,
+                             const void* records, uint32_t count, uint32_t* snapshot_id);
+
+/* fflush and fsync; 0 or -1 */
+int datafile_flush(FILE* fp);
+
+/* fsync the directory holding path, so a file just created or renamed
+ * there survives a crash (best effort; a no-op on Windows) */
+void datafile_sync_parent_dir(const char* path);
+
+const char* datafile_status_name(DataFileStatus status);
+
+#endif /* DATAFILE_H */
@@ -0,0 +1,237 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * journal.c - Write-ahead log of edits to a data file
+ *
+ * Entries are numbered from 1 and checksummed with their number, so
+ * replay stops at the first entry that is short, out of sequence or
+ * damaged. Appends go through stdio buffering and reach the disk only
+ * on journal_sync, so several edits cost one fsync. The writer trusts
+ * the entry count found by the last replay and cuts off whatever
+ * follows it, so an old entry can never reappear after a new one.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <sys/types.h>
+    #include <unistd.h>
+#endif
+
+#include "journal.h"
+#include "datafile.h"
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+#define ENTRY_HEADER_SIZE 12           /* seq, op, checksum */
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t payload_size;
+    uint32_t base;             /* snapshot_id of the data file */
+    uint32_t header_checksum;  /* FNV-1a of the bytes above */
+    unsigned char reserved[8];
+} JournalHeader;
+
+/* ============================================
+ * CHECKSUMS
+ * ============================================ */
+
+static uint32_t fnv1a(uint32_t hash, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ p[i]) * FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t entry_hash(uint32_t seq, uint32_t op, const void* payload, uint32_t payload_size) {
+    uint32_t hash = fnv1a(FNV_OFFSET, &seq, sizeof(seq));
+    hash = fnv1a(hash, &op, sizeof(op));
+    return fnv1a(hash, payload, payload_size);
+}
+
+static uint32_t header_hash(const JournalHeader* header) {
+    return fnv1a(FNV_OFFSET, header, offsetof(JournalHeader, header_checksum));
+}
+
+static size_t entry_size(const Journal* j) {
+    return ENTRY_HEADER_SIZE + (size_t)j->payload_size;
+}
+
+/* ============================================
+ * JOURNAL
+ * ============================================ */
+
+int journal_init(Journal* j, const char* data_path, uint32_t payload_size, uint32_t base) {
+    memset(j, 0, sizeof(*j));
+    j->payload_size = payload_size;
+    j->base = base;
+    int len = snprintf(j->path, sizeof(j->path), "%s%s", data_path, JOURNAL_SUFFIX);
+    return (len < 0 || len >= (int)sizeof(j->path)) ? -1 : 0;
+}
+
+int journal_replay(Journal* j, JournalApplyFn apply, void* ctx) {
+    j->entries = 0;
+    FILE* fp = fopen(j->path, "rb");
+    if (!fp) {
+        return 0;
+    }
+
+    JournalHeader header;
+    if (fread(&header, sizeof(header), 1, fp) != 1 ||
+        memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != JOURNAL_VERSION ||
+        header.header_checksum != header_hash(&header) ||
+        header.payload_size != j->payload_size ||
+        header.base != j->base) {
+        /* Unusable or stale: the next append starts a fresh journal */
+        fclose(fp);
+        return 0;
+    }
+
+    unsigned char* entry = (unsigned char*)malloc(entry_size(j));
+    if (!entry) {
+        fclose(fp);
+        return -1;
+    }
+
+    int applied = 0;
+    while (fread(entry, entry_size(j), 1, fp) == 1) {
+        uint32_t seq, op, checksum;
+        memcpy(&seq, entry, 4);
+        memcpy(&op, entry + 4, 4);
+        memcpy(&checksum, entry + 8, 4);
+        const void* payload = entry + ENTRY_HEADER_SIZE;
+
+        if (seq != j->entries + 1 || checksum != entry_hash(seq, op, payload, j->payload_size)) {
+            break;
+        }
+        if (apply(ctx, op, payload) != 0) {
+            applied = -1;
+            break;
+        }
+        j->entries++;
+        applied++;
+    }
+
+    free(entry);
+    fclose(fp);
+    return applied;
+}
+
+/* Open for appending after the last valid entry, or start a new file */
+static int journal_open(Journal* j) {
+    if (j->entries > 0) {
+        long end = (long)(sizeof(JournalHeader) + j->entries * entry_size(j));
+        j->fp = fopen(j->path, "r+b");
+#ifdef _WIN32
+        if (j->fp && _chsize(_fileno(j->fp), end) == 0 && fseek(j->fp, end, SEEK_SET) == 0) {
+#else
+        if (j->fp && ftruncate(fileno(j->fp), (off_t)end) == 0 && fseek(j->fp, end, SEEK_SET) == 0) {
+#endif
+            return 0;
+        }
+        if (j->fp) {
+            fclose(j->fp);
+        }
+        j->fp = NULL;
+        return -1;
+    }
+
+    JournalHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+    header.version = JOURNAL_VERSION;
+    header.payload_size = j->payload_size;
+    header.base = j->base;
+    header.header_checksum = header_hash(&header);
+
+    j->fp = fopen(j->path, "w+b");
+    if (!j->fp) {
+        return -1;
+    }
+    /* Make the new file's directory entry durable before any entry is acknowledged */
+    datafile_sync_parent_dir(j->path);
+    if (fwrite(&header, sizeof(header), 1, j->fp) != 1) {
+        fclose(j->fp);
+        j->fp = NULL;
+        return -1;
+    }
+    j->unsynced++;
+    return 0;
+}
+
+int journal_append(Journal* j, uint32_t op, const void* payload) {
+    if (!j->fp && journal_open(j) != 0) {
+        return -1;
+    }
+
+    uint32_t seq = j->entries + 1;
+    uint32_t checksum = entry_hash(seq, op, payload, j->payload_size);
+    unsigned char head[ENTRY_HEADER_SIZE];
+    memcpy(head, &seq, 4);
+    memcpy(head + 4, &op, 4);
+    memcpy(head + 8, &checksum, 4);
+
+    if (fwrite(head, sizeof(head), 1, j->fp) != 1 ||
+        fwrite(payload, j->payload_size, 1, j->fp) != 1) {
+        return -1;
+    }
+    j->entries++;
+    j->unsynced++;
+    return 0;
+}
+
+int journal_sync(Journal* j) {
+    if (!j->fp || j->unsynced == 0) {
+        return 0;
+    }
+    if (datafile_flush(j->fp) != 0) {
+        return -1;
+    }
+    j->unsynced = 0;
+    return 0;
+}
+
+int journal_discard(Journal* j, uint32_t new_base) {
+    if (j->fp) {
+        fclose(j->fp);
+        j->fp = NULL;
+    }
+    j->base = new_base;
+    j->entries = 0;
+    j->unsynced = 0;
+
+    /* Only a stale journal is left if this fails, and replay ignores it */
+    FILE* fp = fopen(j->path, "rb");
+    if (!fp) {
+        return 0;
+    }
+    fclose(fp);
+    return remove(j->path) == 0 ? 0 : -1;
+}
+
+void journal_close(Journal* j) {
+    if (j->fp) {
+        journal_sync(j);
+        fclose(j->fp);
+        j->fp = NULL;
+    }
+}
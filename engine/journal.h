@@ -0,0 +1,69 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * journal.h - Write-ahead log of edits to a data file
+ *
+ * A journal is a short header followed by fixed-size entries, each an
+ * operation code and one record-sized payload. Edits are appended here
+ * instead of rewriting the data file (the snapshot), and replayed over
+ * it on load. The journal names the snapshot it extends by its
+ * snapshot_id, so a journal left behind by an interrupted compaction is
+ * recognized as stale and ignored. A torn final entry fails its
+ * checksum and is dropped, along with anything after it.
+ */
+
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define JOURNAL_MAGIC "PEOSJNL"         /* 8 bytes with the terminator */
+#define JOURNAL_VERSION 1
+#define JOURNAL_SUFFIX ".journal"       /* Journal of X lives in X.journal */
+#define JOURNAL_PATH_MAX 1024
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+/* Journal of one data file. Closed (fp NULL) until the first append */
+typedef struct {
+    FILE* fp;
+    char path[JOURNAL_PATH_MAX];
+    uint32_t payload_size;
+    uint32_t base;             /* snapshot_id of the data file it extends */
+    uint32_t entries;          /* Valid entries in the file */
+    uint32_t unsynced;         /* Appended since the last journal_sync */
+} Journal;
+
+/* Apply one replayed entry; nonzero stops the replay */
+typedef int (*JournalApplyFn)(void* ctx, uint32_t op, const void* payload);
+
+/* ============================================
+ * FUNCTION PROTOTYPES
+ * ============================================ */
+
+/* Set up the journal of data_path for a snapshot; -1 if the path is too long */
+int journal_init(Journal* j, const char* data_path, uint32_t payload_size, uint32_t base);
+
+/* Apply every valid entry in order. Returns the number applied, or -1 if
+ * apply failed; a missing or stale journal applies nothing */
+int journal_replay(Journal* j, JournalApplyFn apply, void* ctx);
+
+/* Buffered: the entry is durable only after journal_sync */
+int journal_append(Journal* j, uint32_t op, const void* payload);
+
+/* Group commit: one fsync for everything appended since the last sync */
+int journal_sync(Journal* j);
+
+/* After the snapshot was rewritten as new_base: delete the journal */
+int journal_discard(Journal* j, uint32_t new_base);
+
+/* Sync and close the file (appending later reopens it) */
+void journal_close(Journal* j);
+
+#endif /* JOURNAL_H */
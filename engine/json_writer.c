@@ -0,0 +1,371 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * json_writer.c - Buffered streaming JSON emitter
+ *
+ * Strings are copied in runs between the bytes that need escaping, and
+ * integers and timestamps are formatted by hand, so no record costs a
+ * printf (json_double, for reports, still uses one). Local times come
+ * from a small per-thread cache of UTC offsets keyed by day: a day
+ * whose offset is the same at both ends has no zone transition in it,
+ * and every time on it uses that offset. Days with a transition fall
+ * back to localtime for every call.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L     /* localtime_r, tzset */
+#endif
+
+#include <string.h>
+
+#include "json_writer.h"
+
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define SECONDS_PER_DAY 86400
+#define TZ_CACHE_SIZE 64           /* Days whose offset is remembered */
+
+/* ============================================
+ * OUTPUT
+ * ============================================ */
+
+static void flush_chunk(JsonWriter* w) {
+    if (w->out && w->len > 0) {
+        if (fwrite(w->buf, 1, w->len, w->out) != w->len) {
+            w->error = true;
+        }
+        w->len = 0;
+    }
+}
+
+static void put(JsonWriter* w, const char* s, size_t n) {
+    w->total += n;
+    while (n > 0) {
+        if (w->len == w->cap) {
+            if (!w->out) {
+                return;            /* Memory writer is full: only count */
+            }
+            flush_chunk(w);
+        }
+        size_t room = w->cap - w->len;
+        size_t k = n < room ? n : room;
+        memcpy(w->buf + w->len, s, k);
+        w->len += k;
+        s += k;
+        n -= k;
+    }
+}
+
+static void put_char(JsonWriter* w, char c) {
+    if (w->len < w->cap) {
+        w->buf[w->len++] = c;
+        w->total++;
+    } else {
+        put(w, &c, 1);
+    }
+}
+
+/* Decimal, at least width digits (zero-padded) */
+static void put_uint(JsonWriter* w, unsigned long long value, int width) {
+    char digits[24];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0 || n < width);
+    put(w, digits + sizeof(digits) - n, (size_t)n);
+}
+
+/* printf("%0*lld", width, value) */
+static void put_int(JsonWriter* w, long long value, int width) {
+    if (value < 0) {
+        put_char(w, '-');
+        put_uint(w, 0ULL - (unsigned long long)value, width - 1);
+    } else {
+        put_uint(w, (unsigned long long)value, width);
+    }
+}
+
+/* Comma before every member or element but the first of its container */
+static void separate(JsonWriter* w) {
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    if (w->depth > 0 && w->depth <= JSON_WRITER_DEPTH) {
+        if (w->first[w->depth - 1]) {
+            w->first[w->depth - 1] = false;
+        } else {
+            put(w, ", ", 2);
+        }
+    }
+}
+
+static void open_container(JsonWriter* w, char c) {
+    separate(w);
+    put_char(w, c);
+    if (w->depth < JSON_WRITER_DEPTH) {
+        w->first[w->depth] = true;
+    }
+    w->depth++;
+}
+
+static void close_container(JsonWriter* w, char c) {
+    if (w->depth > 0) {
+        w->depth--;
+    }
+    put_char(w, c);
+}
+
+/* ============================================
+ * WRITER
+ * ============================================ */
+
+static void writer_init(JsonWriter* w, FILE* out, char* buf, size_t cap) {
+    w->buf = buf;
+    w->cap = cap;
+    w->len = 0;
+    w->total = 0;
+    w->out = out;
+    w->error = false;
+    w->depth = 0;
+    w->after_key = false;
+}
+
+void json_writer_to_file(JsonWriter* w, FILE* out) {
+    writer_init(w, out, w->chunk, sizeof(w->chunk));
+}
+
+void json_writer_to_memory(JsonWriter* w, char* buf, size_t cap) {
+    /* One byte is kept back for the terminator */
+    writer_init(w, NULL, cap > 0 ? buf : NULL, cap > 0 ? cap - 1 : 0);
+}
+
+size_t json_writer_finish(JsonWriter* w) {
+    if (w->out) {
+        flush_chunk(w);
+    } else if (w->buf) {
+        w->buf[w->len] = '\0';
+    }
+    return w->total;
+}
+
+/* ============================================
+ * VALUES
+ * ============================================ */
+
+void json_begin_object(JsonWriter* w) {
+    open_container(w, '{');
+}
+
+void json_end_object(JsonWriter* w) {
+    close_container(w, '}');
+}
+
+void json_begin_array(JsonWriter* w) {
+    open_container(w, '[');
+}
+
+void json_end_array(JsonWriter* w) {
+    close_container(w, ']');
+}
+
+void json_key(JsonWriter* w, const char* key) {
+    json_string(w, key, strlen(key));
+    put(w, ": ", 2);
+    w->after_key = true;
+}
+
+void json_string(JsonWriter* w, const char* s, size_t max) {
+    static const char hex[] = "0123456789abcdef";
+    separate(w);
+    put_char(w, '"');
+
+    size_t run = 0;
+    size_t i = 0;
+    for (; i < max && s[i] != '\0'; i++) {
+        unsigned char c = (unsigned char)s[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        put(w, s + run, i - run);
+        run = i + 1;
+
+        char esc[6] = { '\\', 0, 0, 0, 0, 0 };
+        size_t n = 2;
+        switch (c) {
+        case '"':  esc[1] = '"';  break;
+        case '\\': esc[1] = '\\'; break;
+        case '\n': esc[1] = 'n';  break;
+        case '\r': esc[1] = 'r';  break;
+        case '\t': esc[1] = 't';  break;
+        case '\b': esc[1] = 'b';  break;
+        case '\f': esc[1] = 'f';  break;
+        default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0xf];
+            n = 6;
+            break;
+        }
+        put(w, esc, n);
+    }
+    put(w, s + run, i - run);
+    put_char(w, '"');
+}
+
+void json_int(JsonWriter* w, long long value) {
+    separate(w);
+    put_int(w, value, 1);
+}
+
+/* Fixed-point with the given number of decimals; not finite is null */
+void json_double(JsonWriter* w, double value, int decimals) {
+    char text[64];
+    separate(w);
+    if (value != value || value > 1e300 || value < -1e300) {
+        put(w, "null", 4);
+        return;
+    }
+    int n = snprintf(text, sizeof(text), "%.*f", decimals, value);
+    put(w, text, n > 0 && n < (int)sizeof(text) ? (size_t)n : 0);
+}
+
+void json_bool(JsonWriter* w, bool value) {
+    separate(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_clock(JsonWriter* w, int hour, int minute) {
+    separate(w);
+    put_char(w, '"');
+    put_int(w, hour, 2);
+    put_char(w, ':');
+    put_int(w, minute, 2);
+    put_char(w, '"');
+}
+
+void json_raw(JsonWriter* w, const char* s, size_t len) {
+    put(w, s, len);
+}
+
+/* ============================================
+ * LOCAL TIME
+ * ============================================ */
+
+typedef struct {
+    long long day;             /* UTC day number */
+    long offset;               /* Local minus UTC, in seconds */
+    bool valid;
+} TzEntry;
+
+static THREAD_LOCAL TzEntry g_tz_cache[TZ_CACHE_SIZE];
+static THREAD_LOCAL bool g_tz_ready = false;
+
+/* Days since 1970-01-01 of a proleptic Gregorian date */
+static long long days_from_civil(long long y, int m, int d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    long long yoe = y - era * 400;
+    long long doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civil_from_days(long long z, long long* y, int* m, int* d) {
+    z += 719468;
+    long long era = (z >= 0 ? z : z - 146096) / 146097;
+    long long doe = z - era * 146097;
+    long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long long mp = (5 * doy + 2) / 153;
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = yoe + era * 400 + (*m <= 2);
+}
+
+static long long floor_div(long long a, long long b) {
+    long long q = a / b;
+    return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+/* Zone offset at t straight from the C library (0 if it cannot say) */
+static long offset_at(time_t t) {
+    struct tm lt;
+#ifdef _WIN32
+    if (localtime_s(&lt, &t) != 0) {
+        return 0;
+    }
+#else
+    if (!localtime_r(&t, &lt)) {
+        return 0;
+    }
+#endif
+    long long local = days_from_civil(lt.tm_year + 1900LL, lt.tm_mon + 1, lt.tm_mday) * SECONDS_PER_DAY +
+                      lt.tm_hour * 3600 + lt.tm_min * 60 + lt.tm_sec;
+    return (long)(local - (long long)t);
+}
+
+static long local_offset(time_t t) {
+    if (!g_tz_ready) {
+#ifdef _WIN32
+        _tzset();
+#else
+        tzset();
+#endif
+        g_tz_ready = true;
+    }
+
+    long long day = floor_div((long long)t, SECONDS_PER_DAY);
+    TzEntry* entry = &g_tz_cache[(unsigned long long)day % TZ_CACHE_SIZE];
+    if (entry->valid && entry->day == day) {
+        return entry->offset;
+    }
+
+    long start = offset_at((time_t)(day * SECONDS_PER_DAY));
+    long end = offset_at((time_t)(day * SECONDS_PER_DAY + SECONDS_PER_DAY - 1));
+    if (start != end) {
+        return offset_at(t);       /* Transition day: not cached */
+    }
+    entry->day = day;
+    entry->offset = start;
+    entry->valid = true;
+    return start;
+}
+
+void json_local_time(JsonWriter* w, time_t t) {
+    long long local = (long long)t + local_offset(t);
+    long long day = floor_div(local, SECONDS_PER_DAY);
+    long long secs = local - day * SECONDS_PER_DAY;
+    long long year;
+    int month, mday;
+    civil_from_days(day, &year, &month, &mday);
+
+    separate(w);
+    put_char(w, '"');
+    put_int(w, year, 4);
+    put_char(w, '-');
+    put_int(w, month, 2);
+    put_char(w, '-');
+    put_int(w, mday, 2);
+    put_char(w, 'T');
+    put_int(w, secs / 3600, 2);
+    put_char(w, ':');
+    put_int(w, secs / 60 % 60, 2);
+    put_char(w, ':');
+    put_int(w, secs % 60, 2);
+    put_char(w, '"');
+}
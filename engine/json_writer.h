@@ -0,0 +1,85 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * json_writer.h - Buffered streaming JSON emitter
+ *
+ * Output is built in a buffer and handed on in large chunks: either to a
+ * FILE when the buffer fills (json_writer_to_file, using a buffer inside
+ * the writer) or nowhere, when the buffer belongs to the caller
+ * (json_writer_to_memory). A memory writer that runs out of room keeps
+ * counting, so json_writer_finish reports the size needed, as snprintf
+ * does. Nothing is allocated. Separators between members and elements
+ * are inserted automatically; output uses ", " and ": " like the
+ * original printf-based writers.
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <time.h>
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define JSON_WRITER_CHUNK 8192     /* Bytes buffered before a FILE write */
+#define JSON_WRITER_DEPTH 16       /* Deepest nesting of objects and arrays */
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+typedef struct {
+    char* buf;
+    size_t cap;
+    size_t len;                /* Bytes in buf */
+    size_t total;              /* Bytes produced, including any that did not fit */
+    FILE* out;                 /* Flush target, or NULL for a memory writer */
+    bool error;                /* A FILE write failed */
+    int depth;
+    bool first[JSON_WRITER_DEPTH];  /* No member written yet at this level */
+    bool after_key;            /* Next value follows a key, no separator */
+    char chunk[JSON_WRITER_CHUNK];
+} JsonWriter;
+
+/* ============================================
+ * FUNCTION PROTOTYPES
+ * ============================================ */
+
+void json_writer_to_file(JsonWriter* w, FILE* out);
+
+/* buf receives NUL-terminated output; cap 0 only measures */
+void json_writer_to_memory(JsonWriter* w, char* buf, size_t cap);
+
+/* Flush (and terminate a memory buffer). Returns the bytes the document
+ * takes, not counting the NUL; for a memory writer, a result >= cap means
+ * it was truncated */
+size_t json_writer_finish(JsonWriter* w);
+
+void json_begin_object(JsonWriter* w);
+void json_end_object(JsonWriter* w);
+void json_begin_array(JsonWriter* w);
+void json_end_array(JsonWriter* w);
+void json_key(JsonWriter* w, const char* key);
+
+/* Escaped; stops at a NUL or after max bytes (for fixed char arrays) */
+void json_string(JsonWriter* w, const char* s, size_t max);
+void json_int(JsonWriter* w, long long value);
+void json_bool(JsonWriter* w, bool value);
+
+/* value with decimals digits after the point (null if not finite) */
+void json_double(JsonWriter* w, double value, int decimals);
+
+/* "HH:MM" */
+void json_clock(JsonWriter* w, int hour, int minute);
+
+/* Local time as "YYYY-MM-DDTHH:MM:SS", like strftime of localtime but with
+ * the zone offset cached per day */
+void json_local_time(JsonWriter* w, time_t t);
+
+/* Raw bytes written as-is, e.g. a trailing newline after the document */
+void json_raw(JsonWriter* w, const char* s, size_t len);
+
+#endif /* JSON_WRITER_H */
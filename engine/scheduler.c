@@ -5,75 +5,313 @@
  */
 
 #include "scheduler.h"
+#include "server.h"
 
 /* ============================================
  * MEMORY MANAGEMENT
  * ============================================ */
 
+/* Allocate from the arena if there is one, else from the heap */
+static void* cli_alloc(Arena* arena, size_t size) {
+    return arena ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void cli_free(Arena* arena, void* p) {
+    if (!arena) {
+        free(p);
+    }
+}
+
+/* realloc for either owner; the old arena copy is reclaimed on reset */
+static void* cli_grow(Arena* arena, void* p, size_t old_size, size_t new_size) {
+    if (!arena) {
+        return realloc(p, new_size);
+    }
+    void* grown = arena_alloc(arena, new_size);
+    if (grown && p) {
+        memcpy(grown, p, old_size);
+    }
+    return grown;
+}
+
+/* Grow an array that may point into a mapped file, which is copied out */
+static void* grow_records(Arena* arena, DataFileMap* source, void* p,
+                          size_t used_size, size_t old_size, size_t new_size) {
+    if (!source->base) {
+        return cli_grow(arena, p, old_size, new_size);
+    }
+    void* grown = cli_alloc(arena, new_size);
+    if (grown) {
+        memcpy(grown, p, used_size);
+        datafile_unmap(source);
+    }
+    return grown;
+}
+
+/* Next capacity holding n, doubling from current; -1 on overflow */
+static int grown_capacity(int current, int n) {
+    int capacity = current > 0 ? current : INITIAL_CAPACITY;
+    while (capacity < n) {
+        if (capacity > INT_MAX / 2) {
+            return -1;
+        }
+        capacity *= 2;
+    }
+    return capacity;
+}
+
 DailySchedule* schedule_create(int capacity) {
-    DailySchedule* schedule = (DailySchedule*)malloc(sizeof(DailySchedule));
+    return schedule_create_in(NULL, capacity);
+}
+
+DailySchedule* schedule_create_in(Arena* arena, int capacity) {
+    if (capacity < 1) {
+        capacity = INITIAL_CAPACITY;
+    }
+    
+    DailySchedule* schedule = (DailySchedule*)cli_alloc(arena, sizeof(DailySchedule));
     if (!schedule) {
         fprintf(stderr, "Error: Failed to allocate schedule\n");
         return NULL;
     }
     
-    schedule->tasks = (Task*)malloc(sizeof(Task) * capacity);
+    schedule->tasks = (Task*)cli_alloc(arena, sizeof(Task) * capacity);
     if (!schedule->tasks) {
         fprintf(stderr, "Error: Failed to allocate tasks array\n");
-        free(schedule);
+        cli_free(arena, schedule);
         return NULL;
     }
     
-    schedule->gaps = (ScheduleGap*)malloc(sizeof(ScheduleGap) * capacity);
-    if (!schedule->gaps) {
+    schedule->gaps = (ScheduleGap*)cli_alloc(arena, sizeof(ScheduleGap) * ((size_t)capacity + 1));
+    schedule->order = (int*)cli_alloc(arena, sizeof(int) * capacity);
+    if (!schedule->gaps || !schedule->order) {
         fprintf(stderr, "Error: Failed to allocate gaps array\n");
-        free(schedule->tasks);
-        free(schedule);
+        cli_free(arena, schedule->order);
+        cli_free(arena, schedule->gaps);
+        cli_free(arena, schedule->tasks);
+        cli_free(arena, schedule);
         return NULL;
     }
     
     schedule->task_count = 0;
     schedule->gap_count = 0;
     schedule->capacity = capacity;
+    schedule->sorted = true;
+    schedule->position = NULL;
+    schedule->position_capacity = 0;
+    schedule->next_id = 1;
+    schedule->indexed = true;
+    schedule->arena = arena;
+    memset(&schedule->source, 0, sizeof(schedule->source));
+    memset(&schedule->journal, 0, sizeof(schedule->journal));
     
     return schedule;
 }
 
+int schedule_reserve(DailySchedule* schedule, int n) {
+    if (n <= schedule->capacity) {
+        return 0;
+    }
+    
+    int capacity = grown_capacity(schedule->capacity, n);
+    if (capacity < 0) {
+        fprintf(stderr, "Error: Schedule too large\n");
+        return -1;
+    }
+    
+    /* analyze_gaps finds at most one gap per task plus the evening */
+    Task* tasks = (Task*)grow_records(schedule->arena, &schedule->source, schedule->tasks,
+                                      sizeof(Task) * schedule->task_count,
+                                      sizeof(Task) * schedule->capacity,
+                                      sizeof(Task) * (size_t)capacity);
+    if (!tasks) {
+        fprintf(stderr, "Error: Failed to grow tasks array\n");
+        return -1;
+    }
+    schedule->tasks = tasks;
+    
+    ScheduleGap* gaps = (ScheduleGap*)cli_grow(schedule->arena, schedule->gaps,
+                                               sizeof(ScheduleGap) * ((size_t)schedule->capacity + 1),
+                                               sizeof(ScheduleGap) * ((size_t)capacity + 1));
+    if (!gaps) {
+        fprintf(stderr, "Error: Failed to grow gaps array\n");
+        return -1;
+    }
+    schedule->gaps = gaps;
+    
+    int* order = (int*)cli_grow(schedule->arena, schedule->order, sizeof(int) * schedule->capacity,
+                                sizeof(int) * (size_t)capacity);
+    if (!order) {
+        fprintf(stderr, "Error: Failed to grow tasks array\n");
+        return -1;
+    }
+    schedule->order = order;
+    schedule->capacity = capacity;
+    
+    return 0;
+}
+
 void schedule_destroy(DailySchedule* schedule) {
-    if (schedule) {
+    if (!schedule) {
+        return;
+    }
+    journal_close(&schedule->journal);
+    if (schedule->source.base) {
+        datafile_unmap(&schedule->source);
+        schedule->tasks = NULL;
+    }
+    if (!schedule->arena) {
         free(schedule->tasks);
         free(schedule->gaps);
+        free(schedule->order);
+        free(schedule->position);
         free(schedule);
     }
 }
 
 PriorityQueue* pq_create(int capacity) {
-    PriorityQueue* pq = (PriorityQueue*)malloc(sizeof(PriorityQueue));
+    return pq_create_in(NULL, capacity);
+}
+
+PriorityQueue* pq_create_in(Arena* arena, int capacity) {
+    if (capacity < 1) {
+        capacity = INITIAL_CAPACITY;
+    }
+    
+    PriorityQueue* pq = (PriorityQueue*)cli_alloc(arena, sizeof(PriorityQueue));
     if (!pq) {
         fprintf(stderr, "Error: Failed to allocate priority queue\n");
         return NULL;
     }
     
-    pq->reports = (LabReport*)malloc(sizeof(LabReport) * capacity);
+    pq->reports = (LabReport*)cli_alloc(arena, sizeof(LabReport) * capacity);
     if (!pq->reports) {
         fprintf(stderr, "Error: Failed to allocate reports array\n");
-        free(pq);
+        cli_free(arena, pq);
         return NULL;
     }
     
     pq->size = 0;
     pq->capacity = capacity;
+    pq->position = NULL;
+    pq->position_capacity = 0;
+    pq->frontier = NULL;
+    pq->frontier_capacity = 0;
+    pq->next_id = 1;
+    pq->arity = PQ_DEFAULT_ARITY;
+    pq->ordered = true;
+    pq->arena = arena;
+    memset(&pq->source, 0, sizeof(pq->source));
+    memset(&pq->journal, 0, sizeof(pq->journal));
     
     return pq;
 }
 
+int pq_reserve(PriorityQueue* pq, int n) {
+    if (n <= pq->capacity) {
+        return 0;
+    }
+    
+    int capacity = grown_capacity(pq->capacity, n);
+    if (capacity < 0) {
+        fprintf(stderr, "Error: Priority queue too large\n");
+        return -1;
+    }
+    
+    LabReport* reports = (LabReport*)grow_records(pq->arena, &pq->source, pq->reports,
+                                                  sizeof(LabReport) * pq->size,
+                                                  sizeof(LabReport) * pq->capacity,
+                                                  sizeof(LabReport) * (size_t)capacity);
+    if (!reports) {
+        fprintf(stderr, "Error: Failed to grow reports array\n");
+        return -1;
+    }
+    pq->reports = reports;
+    pq->capacity = capacity;
+    
+    return 0;
+}
+
 void pq_destroy(PriorityQueue* pq) {
-    if (pq) {
+    if (!pq) {
+        return;
+    }
+    journal_close(&pq->journal);
+    if (pq->source.base) {
+        datafile_unmap(&pq->source);
+        pq->reports = NULL;
+    }
+    if (!pq->arena) {
         free(pq->reports);
+        free(pq->position);
+        free(pq->frontier);
         free(pq);
     }
 }
 
+/* ============================================
+ * ID INDEX
+ * ============================================ */
+
+/* Make (*position)[id] addressable; new entries are -1 (not present) */
+static int reserve_ids(Arena* arena, int** position, int* capacity, int id) {
+    if (id < *capacity) {
+        return 0;
+    }
+    int grown = grown_capacity(*capacity, id + 1);
+    if (grown < 0) {
+        return -1;
+    }
+    int* index = (int*)cli_grow(arena, *position, sizeof(int) * (size_t)*capacity, sizeof(int) * (size_t)grown);
+    if (!index) {
+        return -1;
+    }
+    for (int i = *capacity; i < grown; i++) {
+        index[i] = -1;
+    }
+    *position = index;
+    *capacity = grown;
+    return 0;
+}
+
+/*
+ * Point (*position)[id] at the index of each record with that id, for
+ * records starting with an int id (Task and LabReport). Ids that are
+ * not positive, repeat an earlier record's id or are implausibly large
+ * (a damaged file) are replaced with fresh ones. Returns the next
+ * unused id, or -1 if the index cannot be allocated.
+ */
+static int index_ids(Arena* arena, void* records, size_t stride, int count, int** position, int* capacity) {
+    long long limit = (long long)count * 16;
+    limit = limit < ID_INDEX_MIN_LIMIT ? ID_INDEX_MIN_LIMIT : (limit > ID_INDEX_MAX ? ID_INDEX_MAX : limit);
+    int max_id = 0;
+    for (int i = 0; i < count; i++) {
+        int id = *(int*)((char*)records + (size_t)i * stride);
+        if (id > max_id && id <= limit) {
+            max_id = id;
+        }
+    }
+    if (reserve_ids(arena, position, capacity, max_id) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < *capacity; i++) {
+        (*position)[i] = -1;
+    }
+    
+    int next_id = max_id + 1;
+    for (int i = 0; i < count; i++) {
+        int* id = (int*)((char*)records + (size_t)i * stride);
+        if (*id < 1 || *id > max_id || (*position)[*id] >= 0) {
+            if (reserve_ids(arena, position, capacity, next_id) != 0) {
+                return -1;
+            }
+            *id = next_id++;
+        }
+        (*position)[*id] = i;
+    }
+    return next_id;
+}
+
 /* ============================================
  * UTILITY FUNCTIONS
  * ============================================ */
@@ -82,6 +320,21 @@ int time_to_minutes(TimeSlot t) {
     return t.hour * 60 + t.minute;
 }
 
+/* "YYYY-MM-DD HH:MM" in local time, nothing after it */
+bool parse_local_time(const char* text, time_t* out) {
+    struct tm tm = {0};
+    char extra;
+    if (sscanf(text, "%d-%d-%d %d:%d%c", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+               &tm.tm_hour, &tm.tm_min, &extra) != 5) {
+        return false;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    *out = mktime(&tm);
+    return true;
+}
+
 TimeSlot minutes_to_time(int minutes) {
     TimeSlot t;
     t.hour = minutes / 60;
@@ -99,51 +352,157 @@ int compare_time(TimeSlot a, TimeSlot b) {
  * SCHEDULE OPERATIONS
  * ============================================ */
 
-int schedule_add_task(DailySchedule* schedule, Task task) {
-    if (schedule->task_count >= schedule->capacity) {
-        fprintf(stderr, "Error: Schedule is full\n");
+/* The order index sorts by start time, then id */
+static bool task_before(const Task* a, const Task* b) {
+    int start_a = time_to_minutes(a->start_time);
+    int start_b = time_to_minutes(b->start_time);
+    return start_a != start_b ? start_a < start_b : a->id < b->id;
+}
+
+/* First of the first count order entries that task does not sort after:
+ * its own entry if it is there, else where it belongs */
+static int order_slot(const DailySchedule* schedule, int count, const Task* task) {
+    int lo = 0;
+    int hi = count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (task_before(&schedule->tasks[schedule->order[mid]], task)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* Index loaded tasks by id. A damaged file's ids may be rewritten, so
+ * the start-time order is rebuilt when next needed */
+static int schedule_index(DailySchedule* schedule) {
+    int next_id = index_ids(schedule->arena, schedule->tasks, sizeof(Task), schedule->task_count,
+                            &schedule->position, &schedule->position_capacity);
+    if (next_id < 0) {
+        return -1;
+    }
+    schedule->next_id = next_id;
+    schedule->sorted = false;
+    schedule->indexed = true;
+    return 0;
+}
+
+/* Build the id index on the first edit after loading */
+static int schedule_require_index(DailySchedule* schedule) {
+    return schedule->indexed ? 0 : schedule_index(schedule);
+}
+
+/* Append under task.id, which must be positive and unused */
+static int schedule_insert(DailySchedule* schedule, Task task) {
+    if (schedule_require_index(schedule) != 0 || task.id < 1 || task.id == INT_MAX || schedule_reserve(schedule, schedule->task_count + 1) != 0 ||
+        reserve_ids(schedule->arena, &schedule->position, &schedule->position_capacity, task.id) != 0) {
         return -1;
     }
     
-    task.id = schedule->task_count + 1;
-    schedule->tasks[schedule->task_count] = task;
+    if (task.id >= schedule->next_id) {
+        schedule->next_id = task.id + 1;
+    }
+    int index = schedule->task_count;
+    schedule->tasks[index] = task;
+    schedule->position[task.id] = index;
+    if (schedule->sorted) {
+        int slot = order_slot(schedule, index, &task);
+        memmove(&schedule->order[slot + 1], &schedule->order[slot], sizeof(int) * (size_t)(index - slot));
+        schedule->order[slot] = index;
+    }
     schedule->task_count++;
     
     return task.id;
 }
 
+/* Tasks are stored in the order they were added (the file appends the
+ * newest); ids are never reused while the schedule is loaded */
+int schedule_add_task(DailySchedule* schedule, Task task) {
+    if (schedule_require_index(schedule) != 0) {
+        return -1;
+    }
+    task.id = schedule->next_id;
+    return schedule_insert(schedule, task);
+}
+
+/* The last task moves into the hole, so only index entries shift */
 int schedule_remove_task(DailySchedule* schedule, int task_id) {
-    for (int i = 0; i < schedule->task_count; i++) {
-        if (schedule->tasks[i].id == task_id) {
-            /* Shift remaining tasks */
-            for (int j = i; j < schedule->task_count - 1; j++) {
-                schedule->tasks[j] = schedule->tasks[j + 1];
-            }
-            schedule->task_count--;
-            return 0;
+    if (schedule_require_index(schedule) != 0 ||
+        task_id < 1 || task_id >= schedule->position_capacity || schedule->position[task_id] < 0) {
+        return -1;
+    }
+    int index = schedule->position[task_id];
+    int last = schedule->task_count - 1;
+    
+    if (schedule->sorted) {
+        int slot = order_slot(schedule, schedule->task_count, &schedule->tasks[index]);
+        memmove(&schedule->order[slot], &schedule->order[slot + 1], sizeof(int) * (size_t)(last - slot));
+        if (index != last) {
+            schedule->order[order_slot(schedule, last, &schedule->tasks[last])] = index;
         }
     }
-    return -1;
+    if (index != last) {
+        schedule->tasks[index] = schedule->tasks[last];
+        schedule->position[schedule->tasks[index].id] = index;
+    }
+    schedule->position[task_id] = -1;
+    schedule->task_count--;
+    return 0;
 }
 
-/* Sort tasks by start time (bubble sort for simplicity) */
-void schedule_sort_by_time(DailySchedule* schedule) {
-    for (int i = 0; i < schedule->task_count - 1; i++) {
-        for (int j = 0; j < schedule->task_count - i - 1; j++) {
-            if (compare_time(schedule->tasks[j].start_time, 
-                           schedule->tasks[j + 1].start_time) > 0) {
-                Task temp = schedule->tasks[j];
-                schedule->tasks[j] = schedule->tasks[j + 1];
-                schedule->tasks[j + 1] = temp;
-            }
+static void sift_order(const Task* tasks, int* order, int root, int count) {
+    int moving = order[root];
+    while (2 * root + 1 < count) {
+        int child = 2 * root + 1;
+        if (child + 1 < count && task_before(&tasks[order[child]], &tasks[order[child + 1]])) {
+            child++;
         }
+        if (!task_before(&tasks[moving], &tasks[order[child]])) {
+            break;
+        }
+        order[root] = order[child];
+        root = child;
+    }
+    order[root] = moving;
+}
+
+/* Build the start-time index (heapsort, in place) unless it is current:
+ * adds and removes keep it up to date once built */
+void schedule_sort_by_time(DailySchedule* schedule) {
+    if (schedule->sorted) {
+        return;
     }
+    int count = schedule->task_count;
+    int* order = schedule->order;
+    for (int i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    for (int i = count / 2 - 1; i >= 0; i--) {
+        sift_order(schedule->tasks, order, i, count);
+    }
+    for (int end = count - 1; end > 0; end--) {
+        int top = order[0];
+        order[0] = order[end];
+        order[end] = top;
+        sift_order(schedule->tasks, order, 0, end);
+    }
+    schedule->sorted = true;
+}
+
+/* Task at position i in start-time order */
+Task* schedule_task_at(DailySchedule* schedule, int i) {
+    schedule_sort_by_time(schedule);
+    return &schedule->tasks[schedule->order[i]];
 }
 
 /* ============================================
  * DEEP WORK GAP ANALYSIS
  * ============================================ */
 
+/* One sweep in start-time order. current is the latest end seen so far,
+ * so a task inside or overlapping an earlier one never moves it back */
 int analyze_gaps(DailySchedule* schedule) {
     schedule_sort_by_time(schedule);
     schedule->gap_count = 0;
@@ -155,7 +514,7 @@ int analyze_gaps(DailySchedule* schedule) {
     TimeSlot current = wake;
     
     for (int i = 0; i < schedule->task_count; i++) {
-        Task* task = &schedule->tasks[i];
+        Task* task = &schedule->tasks[schedule->order[i]];
         
         /* Check gap before this task */
         int gap_mins = time_to_minutes(task->start_time) - time_to_minutes(current);
@@ -168,8 +527,10 @@ int analyze_gaps(DailySchedule* schedule) {
             schedule->gaps[schedule->gap_count++] = gap;
         }
         
-        /* Move current to end of this task */
-        current = task->end_time;
+        /* Move current to end of this task, if it ends later */
+        if (compare_time(task->end_time, current) > 0) {
+            current = task->end_time;
+        }
     }
     
     /* Check gap after last task until sleep */
@@ -213,86 +574,147 @@ void print_gaps(DailySchedule* schedule) {
  * PRIORITY QUEUE (MIN-HEAP)
  * ============================================ */
 
-/* Compare by deadline first, then by credits (higher credits = higher priority) */
-static int compare_reports(LabReport* a, LabReport* b) {
+/* Compare by deadline first, then by credits (higher credits = higher
+ * priority), then by id so that listings have one stable order */
+static int compare_reports(const LabReport* a, const LabReport* b) {
     if (a->deadline != b->deadline) {
         return (a->deadline < b->deadline) ? -1 : 1;
     }
     /* Same deadline: higher credits = higher priority (comes first) */
-    return b->credits - a->credits;
+    if (a->credits != b->credits) {
+        return b->credits - a->credits;
+    }
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+static int pq_reserve_ids(PriorityQueue* pq, int id) {
+    return reserve_ids(pq->arena, &pq->position, &pq->position_capacity, id);
 }
 
+static void pq_place(PriorityQueue* pq, int index, const LabReport* report) {
+    pq->reports[index] = *report;
+    pq->position[report->id] = index;
+}
+
+/* Sift the report at index towards the root, moving parents down into the hole */
 void pq_heapify_up(PriorityQueue* pq, int index) {
+    LabReport moving = pq->reports[index];
     while (index > 0) {
-        int parent = (index - 1) / 2;
-        if (compare_reports(&pq->reports[index], &pq->reports[parent]) < 0) {
-            /* Swap */
-            LabReport temp = pq->reports[index];
-            pq->reports[index] = pq->reports[parent];
-            pq->reports[parent] = temp;
-            index = parent;
-        } else {
+        int parent = (index - 1) / pq->arity;
+        if (compare_reports(&moving, &pq->reports[parent]) >= 0) {
             break;
         }
+        pq_place(pq, index, &pq->reports[parent]);
+        index = parent;
     }
+    pq_place(pq, index, &moving);
 }
 
 void pq_heapify_down(PriorityQueue* pq, int index) {
+    LabReport moving = pq->reports[index];
     while (1) {
-        int smallest = index;
-        int left = 2 * index + 1;
-        int right = 2 * index + 2;
-        
-        if (left < pq->size && 
-            compare_reports(&pq->reports[left], &pq->reports[smallest]) < 0) {
-            smallest = left;
+        int first = pq->arity * index + 1;
+        if (first >= pq->size) {
+            break;
         }
-        if (right < pq->size && 
-            compare_reports(&pq->reports[right], &pq->reports[smallest]) < 0) {
-            smallest = right;
+        int last = first + pq->arity < pq->size ? first + pq->arity : pq->size;
+        int smallest = first;
+        for (int child = first + 1; child < last; child++) {
+            if (compare_reports(&pq->reports[child], &pq->reports[smallest]) < 0) {
+                smallest = child;
+            }
         }
-        
-        if (smallest != index) {
-            LabReport temp = pq->reports[index];
-            pq->reports[index] = pq->reports[smallest];
-            pq->reports[smallest] = temp;
-            index = smallest;
-        } else {
+        if (compare_reports(&pq->reports[smallest], &moving) >= 0) {
             break;
         }
+        pq_place(pq, index, &pq->reports[smallest]);
+        index = smallest;
     }
+    pq_place(pq, index, &moving);
 }
 
-void pq_insert(PriorityQueue* pq, LabReport report) {
-    if (pq->size >= pq->capacity) {
-        fprintf(stderr, "Error: Priority queue is full\n");
-        return;
+/* Restore heap order around a report whose key changed */
+static void pq_resift(PriorityQueue* pq, int index) {
+    if (index > 0 && compare_reports(&pq->reports[index], &pq->reports[(index - 1) / pq->arity]) < 0) {
+        pq_heapify_up(pq, index);
+    } else {
+        pq_heapify_down(pq, index);
+    }
+}
+
+/* Rebuild the id index (see index_ids) and heap order in O(n). -1 if
+ * the index cannot be allocated */
+int pq_heapify(PriorityQueue* pq) {
+    int next_id = index_ids(pq->arena, pq->reports, sizeof(LabReport), pq->size,
+                            &pq->position, &pq->position_capacity);
+    if (next_id < 0) {
+        return -1;
+    }
+    pq->next_id = next_id;
+    
+    for (int i = (pq->size - 2) / pq->arity; i >= 0 && pq->size > 1; i--) {
+        pq_heapify_down(pq, i);
+    }
+    pq->ordered = true;
+    return 0;
+}
+
+/* Build order and index on the first use after loading */
+static int pq_require_order(PriorityQueue* pq) {
+    return pq->ordered ? 0 : pq_heapify(pq);
+}
+
+/* 2 for a binary heap, 4 for a shallower, more cache-friendly one */
+int pq_set_arity(PriorityQueue* pq, int arity) {
+    if (arity < 2 || arity > PQ_MAX_ARITY) {
+        return -1;
+    }
+    pq->arity = arity;
+    return pq_heapify(pq);
+}
+
+/* Insert under report.id, which must be positive and unused */
+static int pq_insert_id(PriorityQueue* pq, LabReport report) {
+    if (pq_require_order(pq) != 0 || report.id < 1 || report.id == INT_MAX || pq_reserve(pq, pq->size + 1) != 0 ||
+        pq_reserve_ids(pq, report.id) != 0) {
+        return -1;
     }
     
-    report.id = pq->size + 1;
+    if (report.id >= pq->next_id) {
+        pq->next_id = report.id + 1;
+    }
     pq->reports[pq->size] = report;
-    pq_heapify_up(pq, pq->size);
     pq->size++;
+    pq_heapify_up(pq, pq->size - 1);
+    
+    return report.id;
+}
+
+/* Ids are never reused while the queue is loaded. Returns the new id, or -1 */
+int pq_insert(PriorityQueue* pq, LabReport report) {
+    if (pq_require_order(pq) != 0) {
+        return -1;
+    }
+    report.id = pq->next_id;
+    return pq_insert_id(pq, report);
 }
 
 LabReport pq_extract_min(PriorityQueue* pq) {
     LabReport empty = {0};
-    if (pq->size == 0) {
+    if (pq->size == 0 || pq_require_order(pq) != 0) {
         fprintf(stderr, "Error: Priority queue is empty\n");
         return empty;
     }
     
     LabReport min = pq->reports[0];
-    pq->reports[0] = pq->reports[pq->size - 1];
-    pq->size--;
-    pq_heapify_down(pq, 0);
+    pq_remove(pq, min.id, NULL);
     
     return min;
 }
 
 LabReport pq_peek(PriorityQueue* pq) {
     LabReport empty = {0};
-    if (pq->size == 0) {
+    if (pq->size == 0 || pq_require_order(pq) != 0) {
         return empty;
     }
     return pq->reports[0];
@@ -302,96 +724,606 @@ bool pq_is_empty(PriorityQueue* pq) {
     return pq->size == 0;
 }
 
+LabReport* pq_find(PriorityQueue* pq, int id) {
+    if (pq_require_order(pq) != 0 || id < 1 || id >= pq->position_capacity || pq->position[id] < 0) {
+        return NULL;
+    }
+    return &pq->reports[pq->position[id]];
+}
+
+/* The last report fills the hole and is sifted whichever way it belongs */
+int pq_remove(PriorityQueue* pq, int id, LabReport* out) {
+    LabReport* report = pq_find(pq, id);
+    if (!report) {
+        return -1;
+    }
+    int index = pq->position[id];
+    if (out) {
+        *out = *report;
+    }
+    
+    pq->position[id] = -1;
+    pq->size--;
+    if (index < pq->size) {
+        pq_place(pq, index, &pq->reports[pq->size]);
+        pq_resift(pq, index);
+    }
+    return 0;
+}
+
+int pq_update_deadline(PriorityQueue* pq, int id, time_t deadline) {
+    LabReport* report = pq_find(pq, id);
+    if (!report) {
+        return -1;
+    }
+    report->deadline = deadline;
+    pq_resift(pq, pq->position[id]);
+    return 0;
+}
+
+/* Completion does not affect the order, so this is O(1) */
+int pq_set_completed(PriorityQueue* pq, int id, bool completed) {
+    LabReport* report = pq_find(pq, id);
+    if (!report) {
+        return -1;
+    }
+    report->completed = completed;
+    return 0;
+}
+
+/* ============================================
+ * ORDERED TRAVERSAL
+ * ============================================ */
+
+/* Called for each report in priority order; false stops the walk */
+typedef bool (*ReportVisitFn)(void* ctx, const LabReport* report);
+
+static bool frontier_less(const PriorityQueue* pq, int a, int b) {
+    return compare_reports(&pq->reports[a], &pq->reports[b]) < 0;
+}
+
+/*
+ * Visit reports in priority order without disturbing the heap. The
+ * frontier is a small binary heap of heap indices: each visited report
+ * is replaced by its children, so m visits cost O(m log m) (times the
+ * arity) and the frontier never holds more than m * (arity - 1) + 1
+ * indices. It is kept in the queue between calls. Returns the number
+ * visited, or -1 if the frontier cannot grow.
+ */
+static int pq_walk(PriorityQueue* pq, ReportVisitFn visit, void* ctx) {
+    int count = 0;
+    int n = 0;
+    if (pq_require_order(pq) != 0) {
+        return -1;
+    }
+    if (pq->size > 0) {
+        if (pq->frontier_capacity < 1) {
+            int* frontier = (int*)cli_alloc(pq->arena, sizeof(int) * INITIAL_CAPACITY);
+            if (!frontier) {
+                return -1;
+            }
+            pq->frontier = frontier;
+            pq->frontier_capacity = INITIAL_CAPACITY;
+        }
+        pq->frontier[n++] = 0;
+    }
+    
+    while (n > 0) {
+        int top = pq->frontier[0];
+        if (!visit(ctx, &pq->reports[top])) {
+            break;
+        }
+        count++;
+        
+        /* Grow so the children fit after the top is popped */
+        if (n - 1 + pq->arity > pq->frontier_capacity) {
+            int capacity = grown_capacity(pq->frontier_capacity, n - 1 + pq->arity);
+            int* frontier = capacity < 0 ? NULL :
+                (int*)cli_grow(pq->arena, pq->frontier, sizeof(int) * (size_t)pq->frontier_capacity,
+                               sizeof(int) * (size_t)capacity);
+            if (!frontier) {
+                return -1;
+            }
+            pq->frontier = frontier;
+            pq->frontier_capacity = capacity;
+        }
+        
+        /* Pop the top, then push each child of the report just visited */
+        int* f = pq->frontier;
+        int moving = f[--n];
+        int i = 0;
+        while (n > 0) {
+            int child = 2 * i + 1;
+            if (child >= n) {
+                break;
+            }
+            if (child + 1 < n && frontier_less(pq, f[child + 1], f[child])) {
+                child++;
+            }
+            if (!frontier_less(pq, f[child], moving)) {
+                break;
+            }
+            f[i] = f[child];
+            i = child;
+        }
+        if (n > 0) {
+            f[i] = moving;
+        }
+        
+        int first = pq->arity * top + 1;
+        for (int c = first; c < first + pq->arity && c < pq->size; c++) {
+            int hole = n++;
+            while (hole > 0 && frontier_less(pq, c, f[(hole - 1) / 2])) {
+                f[hole] = f[(hole - 1) / 2];
+                hole = (hole - 1) / 2;
+            }
+            f[hole] = c;
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    LabReport* out;
+    int max;
+    int count;
+    bool bounded;           /* Stop at the first report due at or after before */
+    time_t before;
+} CopyWalk;
+
+static bool copy_report(void* ctx, const LabReport* report) {
+    CopyWalk* walk = (CopyWalk*)ctx;
+    if (walk->count == walk->max || (walk->bounded && report->deadline >= walk->before)) {
+        return false;
+    }
+    walk->out[walk->count++] = *report;
+    return true;
+}
+
+/* The k most urgent reports, in priority order, in O(k log k). Returns
+ * how many were copied (fewer than k if the queue is shorter), or -1 */
+int pq_top_k(PriorityQueue* pq, int k, LabReport* out) {
+    CopyWalk walk = { out, k, 0, false, 0 };
+    return k > 0 && pq_walk(pq, copy_report, &walk) < 0 ? -1 : walk.count;
+}
+
+/* Reports due before a time, soonest first, at most max of them. The
+ * heap is ordered by deadline first, so the walk stops at the first
+ * report that is not due and costs O(m log m) for m results */
+int pq_due_before(PriorityQueue* pq, time_t before, LabReport* out, int max) {
+    CopyWalk walk = { out, max, 0, true, before };
+    return max > 0 && pq_walk(pq, copy_report, &walk) < 0 ? -1 : walk.count;
+}
+
 /* ============================================
  * BINARY FILE I/O
  * ============================================ */
 
+/* Copies with every padding byte zeroed, so the bytes on disk (and their
+ * checksums) depend only on the field values */
+static void pack_task(Task* out, const Task* in) {
+    memset(out, 0, sizeof(*out));
+    out->id = in->id;
+    memcpy(out->title, in->title, sizeof(out->title));
+    memcpy(out->subject, in->subject, sizeof(out->subject));
+    out->priority = in->priority;
+    out->duration_mins = in->duration_mins;
+    out->start_time = in->start_time;
+    out->end_time = in->end_time;
+    out->is_deep_work = in->is_deep_work;
+    out->completed = in->completed;
+}
+
+static void pack_report(LabReport* out, const LabReport* in) {
+    memset(out, 0, sizeof(*out));
+    out->id = in->id;
+    memcpy(out->title, in->title, sizeof(out->title));
+    memcpy(out->subject, in->subject, sizeof(out->subject));
+    out->deadline = in->deadline;
+    out->credits = in->credits;
+    out->completed = in->completed;
+}
+
+static void report_file_error(const char* filename, DataFileStatus status) {
+    if (status == DATAFILE_MISSING) {
+        fprintf(stderr, "Error: Cannot open %s for reading\n", filename);
+    } else {
+        fprintf(stderr, "Error: %s is %s\n", filename, datafile_status_name(status));
+    }
+}
+
+/* Whether j is filename's journal */
+static bool journal_matches(const Journal* j, const char* filename) {
+    size_t len = strlen(filename);
+    return strncmp(j->path, filename, len) == 0 && strcmp(j->path + len, JOURNAL_SUFFIX) == 0;
+}
+
+/* Called after filename was rewritten as snapshot_id: its journal is obsolete.
+ * Saving to another file leaves the old file's journal in place */
+static void journal_rebase(Journal* j, const char* filename, uint32_t payload_size, uint32_t snapshot_id) {
+    if (!journal_matches(j, filename)) {
+        journal_close(j);
+        journal_init(j, filename, payload_size, 0);
+    }
+    journal_discard(j, snapshot_id);
+}
+
 int save_schedule(DailySchedule* schedule, const char* filename) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot open %s for writing\n", filename);
+    Task* packed = (Task*)malloc(sizeof(Task) * (size_t)(schedule->task_count > 0 ? schedule->task_count : 1));
+    if (!packed) {
+        fprintf(stderr, "Error: Failed to allocate save buffer\n");
         return -1;
     }
+    for (int i = 0; i < schedule->task_count; i++) {
+        pack_task(&packed[i], &schedule->tasks[i]);
+    }
     
-    /* Write metadata */
-    fwrite(&schedule->task_count, sizeof(int), 1, fp);
-    fwrite(&schedule->gap_count, sizeof(int), 1, fp);
-    
-    /* Write tasks */
-    fwrite(schedule->tasks, sizeof(Task), schedule->task_count, fp);
-    
-    /* Write gaps */
-    fwrite(schedule->gaps, sizeof(ScheduleGap), schedule->gap_count, fp);
-    
-    fclose(fp);
+    uint32_t snapshot_id = 0;
+    DataFileStatus status = datafile_save(filename, DATAFILE_TASKS, sizeof(Task),
+                                          packed, (uint32_t)schedule->task_count, &snapshot_id);
+    free(packed);
+    if (status != DATAFILE_OK) {
+        fprintf(stderr, "Error: Cannot write %s\n", filename);
+        return -1;
+    }
+    journal_rebase(&schedule->journal, filename, sizeof(Task), snapshot_id);
     printf("Schedule saved to %s\n", filename);
     return 0;
 }
 
 DailySchedule* load_schedule(const char* filename) {
+    return load_schedule_in(NULL, filename);
+}
+
+/* Original layout: task and gap counts, then raw tasks and gaps */
+static DailySchedule* load_schedule_legacy(Arena* arena, const char* filename) {
     FILE* fp = fopen(filename, "rb");
     if (!fp) {
         fprintf(stderr, "Error: Cannot open %s for reading\n", filename);
         return NULL;
     }
     
-    int task_count, gap_count;
-    fread(&task_count, sizeof(int), 1, fp);
-    fread(&gap_count, sizeof(int), 1, fp);
+    int task_count = 0, gap_count = 0;
+    if (fread(&task_count, sizeof(int), 1, fp) != 1 ||
+        fread(&gap_count, sizeof(int), 1, fp) != 1 ||
+        task_count < 0 || gap_count < 0 || gap_count > task_count + 1) {
+        fprintf(stderr, "Error: %s is corrupt\n", filename);
+        fclose(fp);
+        return NULL;
+    }
     
-    DailySchedule* schedule = schedule_create(MAX_TASKS);
+    /* Sized from the file header, so every stored task is loaded */
+    DailySchedule* schedule = schedule_create_in(arena, task_count);
     if (!schedule) {
         fclose(fp);
         return NULL;
     }
     
-    fread(schedule->tasks, sizeof(Task), task_count, fp);
-    schedule->task_count = task_count;
-    
-    fread(schedule->gaps, sizeof(ScheduleGap), gap_count, fp);
-    schedule->gap_count = gap_count;
+    schedule->task_count = (int)fread(schedule->tasks, sizeof(Task), task_count, fp);
+    schedule->gap_count = (int)fread(schedule->gaps, sizeof(ScheduleGap), gap_count, fp);
+    if (schedule->task_count != task_count) {
+        fprintf(stderr, "Warning: %s is truncated, loaded %d of %d tasks\n",
+                filename, schedule->task_count, task_count);
+    }
     
     fclose(fp);
+    if (schedule_index(schedule) != 0) {
+        fprintf(stderr, "Error: Failed to index %s\n", filename);
+        schedule_destroy(schedule);
+        return NULL;
+    }
     printf("Schedule loaded from %s\n", filename);
     return schedule;
 }
 
-int save_lab_queue(PriorityQueue* pq, const char* filename) {
-    FILE* fp = fopen(filename, "wb");
-    if (!fp) {
-        fprintf(stderr, "Error: Cannot open %s for writing\n", filename);
+/* Redo one journaled schedule edit: adds keep the id they were given */
+static int replay_task(void* ctx, uint32_t op, const void* payload) {
+    DailySchedule* schedule = (DailySchedule*)ctx;
+    Task task;
+    memcpy(&task, payload, sizeof(task));
+    if (schedule_require_index(schedule) != 0) {
         return -1;
     }
+    switch (op) {
+    case JOURNAL_TASK_ADD:
+        if (task.id < 1 || (task.id < schedule->position_capacity && schedule->position[task.id] >= 0)) {
+            task.id = schedule->next_id;
+        }
+        return schedule_insert(schedule, task) < 0 ? -1 : 0;
+    case JOURNAL_TASK_REMOVE:
+        schedule_remove_task(schedule, task.id);
+        return 0;
+    }
+    return -1;
+}
+
+/* Tasks are used from the mapping in place, then the journal is replayed
+ * over them; gaps are recomputed, not stored. Only the header is read
+ * unless the journal has entries */
+DailySchedule* load_schedule_in(Arena* arena, const char* filename) {
+    DataFileMap map;
+    DataFileStatus status = datafile_map(filename, DATAFILE_TASKS, sizeof(Task), INITIAL_CAPACITY, &map);
+    if (status == DATAFILE_LEGACY) {
+        return load_schedule_legacy(arena, filename);
+    }
+    if (status == DATAFILE_OK && map.room > INT_MAX - 1) {
+        datafile_unmap(&map);
+        status = DATAFILE_CORRUPT;
+    }
+    if (status != DATAFILE_OK) {
+        report_file_error(filename, status);
+        return NULL;
+    }
     
-    fwrite(&pq->size, sizeof(int), 1, fp);
-    fwrite(pq->reports, sizeof(LabReport), pq->size, fp);
+    /* The mapping has spare room after the records, so a few adds grow in place */
+    int count = (int)map.record_count;
+    int capacity = (int)map.room;
+    DailySchedule* schedule = schedule_create_in(arena, 1);
+    ScheduleGap* gaps = schedule ? (ScheduleGap*)cli_grow(arena, schedule->gaps, sizeof(ScheduleGap) * 2,
+                                                          sizeof(ScheduleGap) * ((size_t)capacity + 1))
+                                 : NULL;
+    if (gaps) {
+        schedule->gaps = gaps;
+    }
+    int* order = gaps ? (int*)cli_grow(arena, schedule->order, sizeof(int), sizeof(int) * (size_t)capacity) : NULL;
+    if (order) {
+        schedule->order = order;
+    }
+    if (!order) {
+        datafile_unmap(&map);
+        schedule_destroy(schedule);
+        return NULL;
+    }
     
-    fclose(fp);
+    cli_free(arena, schedule->tasks);
+    schedule->tasks = (Task*)map.records;
+    schedule->task_count = count;
+    schedule->capacity = capacity;
+    schedule->source = map;
+    schedule->sorted = false;
+    schedule->indexed = false;     /* Built by the first edit: loading reads no record */
+    if (map.record_count != map.stored_count) {
+        fprintf(stderr, "Warning: %s is truncated, loaded %d of %u tasks\n",
+                filename, count, (unsigned)map.stored_count);
+    }
+    
+    journal_init(&schedule->journal, filename, sizeof(Task), map.snapshot_id);
+    if (journal_replay(&schedule->journal, replay_task, schedule) < 0) {
+        fprintf(stderr, "Warning: %s has an unknown entry, replayed %u\n",
+                schedule->journal.path, (unsigned)schedule->journal.entries);
+    }
+    
+    printf("Schedule loaded from %s\n", filename);
+    return schedule;
+}
+
+int save_lab_queue(PriorityQueue* pq, const char* filename) {
+    LabReport* packed = (LabReport*)malloc(sizeof(LabReport) * (size_t)(pq->size > 0 ? pq->size : 1));
+    if (!packed) {
+        fprintf(stderr, "Error: Failed to allocate save buffer\n");
+        return -1;
+    }
+    for (int i = 0; i < pq->size; i++) {
+        pack_report(&packed[i], &pq->reports[i]);
+    }
+    
+    uint32_t snapshot_id = 0;
+    DataFileStatus status = datafile_save(filename, DATAFILE_LABS, sizeof(LabReport),
+                                          packed, (uint32_t)pq->size, &snapshot_id);
+    free(packed);
+    if (status != DATAFILE_OK) {
+        fprintf(stderr, "Error: Cannot write %s\n", filename);
+        return -1;
+    }
+    journal_rebase(&pq->journal, filename, sizeof(LabReport), snapshot_id);
     return 0;
 }
 
 PriorityQueue* load_lab_queue(const char* filename) {
+    return load_lab_queue_in(NULL, filename);
+}
+
+/* Original layout: report count, then raw reports in heap order */
+static PriorityQueue* load_lab_queue_legacy(Arena* arena, const char* filename) {
     FILE* fp = fopen(filename, "rb");
     if (!fp) {
         return NULL;
     }
     
-    int size;
-    fread(&size, sizeof(int), 1, fp);
+    int size = 0;
+    if (fread(&size, sizeof(int), 1, fp) != 1 || size < 0) {
+        fprintf(stderr, "Error: %s is corrupt\n", filename);
+        fclose(fp);
+        return NULL;
+    }
     
-    PriorityQueue* pq = pq_create(MAX_TASKS);
+    PriorityQueue* pq = pq_create_in(arena, size);
     if (!pq) {
         fclose(fp);
         return NULL;
     }
     
-    fread(pq->reports, sizeof(LabReport), size, fp);
-    pq->size = size;
-    
+    pq->size = (int)fread(pq->reports, sizeof(LabReport), size, fp);
     fclose(fp);
+    
+    if (pq_heapify(pq) != 0) {
+        fprintf(stderr, "Error: Failed to index %s\n", filename);
+        pq_destroy(pq);
+        return NULL;
+    }
+    return pq;
+}
+
+/* Inserts carry the id the report was given, so the replay hands out
+ * the same ones (earlier journals logged 0 and get a fresh id) */
+static int replay_report(void* ctx, uint32_t op, const void* payload) {
+    PriorityQueue* pq = (PriorityQueue*)ctx;
+    LabReport report;
+    memcpy(&report, payload, sizeof(report));
+    
+    switch (op) {
+    case JOURNAL_LAB_INSERT:
+        if (report.id < 1 || pq_find(pq, report.id)) {
+            report.id = pq->next_id;
+        }
+        return pq_insert_id(pq, report) < 0 ? -1 : 0;
+    case JOURNAL_LAB_REMOVE:
+        pq_remove(pq, report.id, NULL);
+        return 0;
+    case JOURNAL_LAB_UPDATE:
+        if (pq_update_deadline(pq, report.id, report.deadline) == 0) {
+            pq_set_completed(pq, report.id, report.completed);
+        }
+        return 0;
+    }
+    return -1;
+}
+
+PriorityQueue* load_lab_queue_in(Arena* arena, const char* filename) {
+    DataFileMap map;
+    DataFileStatus status = datafile_map(filename, DATAFILE_LABS, sizeof(LabReport), INITIAL_CAPACITY, &map);
+    if (status == DATAFILE_LEGACY) {
+        return load_lab_queue_legacy(arena, filename);
+    }
+    if (status == DATAFILE_OK && map.room > INT_MAX) {
+        datafile_unmap(&map);
+        status = DATAFILE_CORRUPT;
+    }
+    if (status != DATAFILE_OK) {
+        /* A missing queue is normal: the caller starts an empty one */
+        if (status != DATAFILE_MISSING) {
+            report_file_error(filename, status);
+        }
+        return NULL;
+    }
+    
+    PriorityQueue* pq = pq_create_in(arena, 1);
+    if (!pq) {
+        datafile_unmap(&map);
+        return NULL;
+    }
+    
+    cli_free(arena, pq->reports);
+    pq->reports = (LabReport*)map.records;
+    pq->size = (int)map.record_count;
+    pq->capacity = (int)map.room;
+    pq->source = map;
+    pq->ordered = false;           /* Built on first use: loading reads no record */
+    
+    journal_init(&pq->journal, filename, sizeof(LabReport), map.snapshot_id);
+    if (journal_replay(&pq->journal, replay_report, pq) < 0) {
+        fprintf(stderr, "Warning: %s has an unknown entry, replayed %u\n",
+                pq->journal.path, (unsigned)pq->journal.entries);
+    }
     return pq;
 }
 
+/* Print the state of both files; 0 if neither is damaged */
+int verify_data_files(const char* schedule_file, const char* lab_file) {
+    const char* names[2] = { schedule_file, lab_file };
+    DataFileStatus status[2] = {
+        datafile_verify(schedule_file, DATAFILE_TASKS, sizeof(Task)),
+        datafile_verify(lab_file, DATAFILE_LABS, sizeof(LabReport))
+    };
+    int failed = 0;
+    
+    for (int i = 0; i < 2; i++) {
+        printf("%s: %s\n", names[i], datafile_status_name(status[i]));
+        if (status[i] != DATAFILE_OK && status[i] != DATAFILE_MISSING && status[i] != DATAFILE_LEGACY) {
+            failed = 1;
+        }
+    }
+    return failed ? -1 : 0;
+}
+
+/* ============================================
+ * JOURNALED EDITS
+ * ============================================ */
+
+/* Append one edit, or rewrite the file when the journal cannot take it */
+static int schedule_log(DailySchedule* schedule, const char* filename, uint32_t op, const Task* task) {
+    if (schedule->journal.base == 0 || !journal_matches(&schedule->journal, filename)) {
+        return save_schedule(schedule, filename);
+    }
+    Task packed;
+    pack_task(&packed, task);
+    if (journal_append(&schedule->journal, op, &packed) != 0) {
+        fprintf(stderr, "Warning: Cannot append to %s, rewriting %s\n", schedule->journal.path, filename);
+        return save_schedule(schedule, filename);
+    }
+    return 0;
+}
+
+int schedule_log_add(DailySchedule* schedule, const char* filename) {
+    if (schedule->task_count == 0) {
+        return -1;
+    }
+    return schedule_log(schedule, filename, JOURNAL_TASK_ADD, &schedule->tasks[schedule->task_count - 1]);
+}
+
+int schedule_log_remove(DailySchedule* schedule, const char* filename, int task_id) {
+    Task task = {0};
+    task.id = task_id;
+    return schedule_log(schedule, filename, JOURNAL_TASK_REMOVE, &task);
+}
+
+int schedule_sync(DailySchedule* schedule, const char* filename) {
+    if (!journal_matches(&schedule->journal, filename)) {
+        return 0;
+    }
+    if (schedule->journal.entries >= JOURNAL_COMPACT_ENTRIES) {
+        return save_schedule(schedule, filename);
+    }
+    if (journal_sync(&schedule->journal) != 0) {
+        fprintf(stderr, "Error: Cannot sync %s\n", schedule->journal.path);
+        return -1;
+    }
+    return 0;
+}
+
+static int pq_log(PriorityQueue* pq, const char* filename, uint32_t op, const LabReport* report) {
+    if (pq->journal.base == 0 || !journal_matches(&pq->journal, filename)) {
+        return save_lab_queue(pq, filename);
+    }
+    LabReport packed;
+    pack_report(&packed, report);
+    if (journal_append(&pq->journal, op, &packed) != 0) {
+        fprintf(stderr, "Warning: Cannot append to %s, rewriting %s\n", pq->journal.path, filename);
+        return save_lab_queue(pq, filename);
+    }
+    return 0;
+}
+
+int pq_log_insert(PriorityQueue* pq, const char* filename, int id) {
+    LabReport* report = pq_find(pq, id);
+    return report ? pq_log(pq, filename, JOURNAL_LAB_INSERT, report) : -1;
+}
+
+int pq_log_remove(PriorityQueue* pq, const char* filename, int id) {
+    LabReport report = {0};
+    report.id = id;
+    return pq_log(pq, filename, JOURNAL_LAB_REMOVE, &report);
+}
+
+int pq_log_update(PriorityQueue* pq, const char* filename, int id) {
+    LabReport* report = pq_find(pq, id);
+    return report ? pq_log(pq, filename, JOURNAL_LAB_UPDATE, report) : -1;
+}
+
+int pq_sync(PriorityQueue* pq, const char* filename) {
+    if (!journal_matches(&pq->journal, filename)) {
+        return 0;
+    }
+    if (pq->journal.entries >= JOURNAL_COMPACT_ENTRIES) {
+        return save_lab_queue(pq, filename);
+    }
+    if (journal_sync(&pq->journal) != 0) {
+        fprintf(stderr, "Error: Cannot sync %s\n", pq->journal.path);
+        return -1;
+    }
+    return 0;
+}
+
 /* ============================================
  * PRINT FUNCTIONS
  * ============================================ */
@@ -418,9 +1350,8 @@ void print_schedule(DailySchedule* schedule) {
         return;
     }
     
-    schedule_sort_by_time(schedule);
     for (int i = 0; i < schedule->task_count; i++) {
-        print_task(&schedule->tasks[i]);
+        print_task(schedule_task_at(schedule, i));
     }
 }
 
@@ -438,81 +1369,195 @@ void print_lab_report(LabReport* report) {
            report->completed ? "[DONE]" : "");
 }
 
-void print_queue(PriorityQueue* pq) {
-    printf("\n=== Lab Report Queue (Priority Order) ===\n");
-    
-    if (pq->size == 0) {
-        printf("No lab reports in queue.\n");
-        return;
+/* Which reports a listing covers, and where they go */
+typedef struct {
+    int limit;              /* At most this many, or -1 for all */
+    const time_t* before;   /* Only those due before this, if not NULL */
+    JsonWriter* w;          /* JSON array to append to, or NULL for text */
+    int count;
+} QueueListing;
+
+static bool list_report(void* ctx, const LabReport* report) {
+    QueueListing* listing = (QueueListing*)ctx;
+    if (listing->count == listing->limit || (listing->before && report->deadline >= *listing->before)) {
+        return false;
+    }
+    if (listing->w) {
+        JsonWriter* w = listing->w;
+        json_begin_object(w);
+        json_key(w, "id");
+        json_int(w, report->id);
+        json_key(w, "title");
+        json_string(w, report->title, sizeof(report->title));
+        json_key(w, "subject");
+        json_string(w, report->subject, sizeof(report->subject));
+        json_key(w, "deadline");
+        json_local_time(w, report->deadline);
+        json_key(w, "credits");
+        json_int(w, report->credits);
+        json_key(w, "completed");
+        json_bool(w, report->completed);
+        json_end_object(w);
+    } else {
+        print_lab_report((LabReport*)report);
+    }
+    listing->count++;
+    return true;
+}
+
+void print_queue_listing(PriorityQueue* pq, int limit, const time_t* before) {
+    if (before) {
+        char when[20];
+        strftime(when, sizeof(when), "%Y-%m-%d %H:%M", localtime(before));
+        printf("\n=== Lab Reports Due Before %s ===\n", when);
+    } else if (limit >= 0) {
+        printf("\n=== Next %d Lab Reports (Priority Order) ===\n", limit);
+    } else {
+        printf("\n=== Lab Report Queue (Priority Order) ===\n");
     }
     
-    /* Create temp queue to peek all */
-    for (int i = 0; i < pq->size; i++) {
-        print_lab_report(&pq->reports[i]);
+    QueueListing listing = { limit, before, NULL, 0 };
+    if (pq_walk(pq, list_report, &listing) < 0) {
+        fprintf(stderr, "Error: Failed to allocate queue listing\n");
+    } else if (listing.count == 0) {
+        printf(pq->size == 0 ? "No lab reports in queue.\n" : "No matching lab reports.\n");
     }
 }
 
+void print_queue(PriorityQueue* pq) {
+    print_queue_listing(pq, -1, NULL);
+}
+
 /* ============================================
  * JSON OUTPUT (for Python integration)
  * ============================================ */
 
-void print_gaps_json(DailySchedule* schedule) {
-    printf("{\"gaps\": [");
-    
+void write_gaps_json(JsonWriter* w, DailySchedule* schedule) {
+    json_begin_object(w);
+    json_key(w, "gaps");
+    json_begin_array(w);
     for (int i = 0; i < schedule->gap_count; i++) {
         ScheduleGap* gap = &schedule->gaps[i];
-        printf("{\"start\": \"%02d:%02d\", \"end\": \"%02d:%02d\", \"duration_mins\": %d}",
-               gap->start.hour, gap->start.minute,
-               gap->end.hour, gap->end.minute,
-               gap->duration_mins);
-        if (i < schedule->gap_count - 1) printf(", ");
+        json_begin_object(w);
+        json_key(w, "start");
+        json_clock(w, gap->start.hour, gap->start.minute);
+        json_key(w, "end");
+        json_clock(w, gap->end.hour, gap->end.minute);
+        json_key(w, "duration_mins");
+        json_int(w, gap->duration_mins);
+        json_end_object(w);
     }
-    
-    printf("], \"count\": %d}\n", schedule->gap_count);
+    json_end_array(w);
+    json_key(w, "count");
+    json_int(w, schedule->gap_count);
+    json_end_object(w);
 }
 
-void print_schedule_json(DailySchedule* schedule) {
-    printf("{\"tasks\": [");
-    
+void write_schedule_json(JsonWriter* w, DailySchedule* schedule) {
+    json_begin_object(w);
+    json_key(w, "tasks");
+    json_begin_array(w);
     for (int i = 0; i < schedule->task_count; i++) {
-        Task* t = &schedule->tasks[i];
-        printf("{\"id\": %d, \"title\": \"%s\", \"subject\": \"%s\", "
-               "\"start\": \"%02d:%02d\", \"end\": \"%02d:%02d\", "
-               "\"duration\": %d, \"priority\": %d, \"deep_work\": %s}",
-               t->id, t->title, t->subject,
-               t->start_time.hour, t->start_time.minute,
-               t->end_time.hour, t->end_time.minute,
-               t->duration_mins, t->priority,
-               t->is_deep_work ? "true" : "false");
-        if (i < schedule->task_count - 1) printf(", ");
+        Task* t = schedule_task_at(schedule, i);
+        json_begin_object(w);
+        json_key(w, "id");
+        json_int(w, t->id);
+        json_key(w, "title");
+        json_string(w, t->title, sizeof(t->title));
+        json_key(w, "subject");
+        json_string(w, t->subject, sizeof(t->subject));
+        json_key(w, "start");
+        json_clock(w, t->start_time.hour, t->start_time.minute);
+        json_key(w, "end");
+        json_clock(w, t->end_time.hour, t->end_time.minute);
+        json_key(w, "duration");
+        json_int(w, t->duration_mins);
+        json_key(w, "priority");
+        json_int(w, t->priority);
+        json_key(w, "deep_work");
+        json_bool(w, t->is_deep_work);
+        json_end_object(w);
     }
-    
-    printf("], \"count\": %d}\n", schedule->task_count);
+    json_end_array(w);
+    json_key(w, "count");
+    json_int(w, schedule->task_count);
+    json_end_object(w);
+}
+
+/* "count" is the number listed; a walk that runs out of memory ends the
+ * array early but still leaves a valid document */
+void write_queue_listing_json(JsonWriter* w, PriorityQueue* pq, int limit, const time_t* before) {
+    QueueListing listing = { limit, before, w, 0 };
+    json_begin_object(w);
+    json_key(w, "reports");
+    json_begin_array(w);
+    pq_walk(pq, list_report, &listing);
+    json_end_array(w);
+    json_key(w, "count");
+    json_int(w, listing.count);
+    json_end_object(w);
+}
+
+void write_queue_json(JsonWriter* w, PriorityQueue* pq) {
+    write_queue_listing_json(w, pq, -1, NULL);
+}
+
+void print_gaps_json(DailySchedule* schedule) {
+    JsonWriter w;
+    json_writer_to_file(&w, stdout);
+    write_gaps_json(&w, schedule);
+    json_raw(&w, "\n", 1);
+    json_writer_finish(&w);
+}
+
+void print_schedule_json(DailySchedule* schedule) {
+    JsonWriter w;
+    json_writer_to_file(&w, stdout);
+    write_schedule_json(&w, schedule);
+    json_raw(&w, "\n", 1);
+    json_writer_finish(&w);
 }
 
 void print_queue_json(PriorityQueue* pq) {
-    printf("{\"reports\": [");
-    
-    for (int i = 0; i < pq->size; i++) {
-        LabReport* r = &pq->reports[i];
-        char deadline_str[26];
-        struct tm* tm_info = localtime(&r->deadline);
-        strftime(deadline_str, 26, "%Y-%m-%dT%H:%M:%S", tm_info);
-        
-        printf("{\"id\": %d, \"title\": \"%s\", \"subject\": \"%s\", "
-               "\"deadline\": \"%s\", \"credits\": %d, \"completed\": %s}",
-               r->id, r->title, r->subject, deadline_str, r->credits,
-               r->completed ? "true" : "false");
-        if (i < pq->size - 1) printf(", ");
-    }
-    
-    printf("], \"count\": %d}\n", pq->size);
+    print_queue_listing_json(pq, -1, NULL);
+}
+
+void print_queue_listing_json(PriorityQueue* pq, int limit, const time_t* before) {
+    JsonWriter w;
+    json_writer_to_file(&w, stdout);
+    write_queue_listing_json(&w, pq, limit, before);
+    json_raw(&w, "\n", 1);
+    json_writer_finish(&w);
+}
+
+size_t gaps_to_json(DailySchedule* schedule, char* buf, size_t cap) {
+    JsonWriter w;
+    json_writer_to_memory(&w, buf, cap);
+    write_gaps_json(&w, schedule);
+    return json_writer_finish(&w);
+}
+
+size_t schedule_to_json(DailySchedule* schedule, char* buf, size_t cap) {
+    JsonWriter w;
+    json_writer_to_memory(&w, buf, cap);
+    write_schedule_json(&w, schedule);
+    return json_writer_finish(&w);
+}
+
+size_t queue_to_json(PriorityQueue* pq, char* buf, size_t cap) {
+    JsonWriter w;
+    json_writer_to_memory(&w, buf, cap);
+    write_queue_json(&w, pq);
+    return json_writer_finish(&w);
 }
 
 /* ============================================
  * MAIN - CLI Interface
  * ============================================ */
 
+/* Benchmarks link this file for the queue and schedule code alone */
+#ifndef SCHEDULER_NO_MAIN
+
 void print_usage(const char* program) {
     printf("\nPersonal Engineering OS - Scheduler Engine v1.0.1\n");
     printf("=================================================\n\n");
@@ -521,8 +1566,12 @@ void print_usage(const char* program) {
     printf("  --analyze-gaps        Find deep work gaps (>90 mins)\n");
     printf("  --list-schedule       Show current schedule\n");
     printf("  --list-queue          Show lab report queue\n");
+    printf("  --next N              Show the N most urgent lab reports\n");
+    printf("  --due-before TIME     Show lab reports due before \"YYYY-MM-DD HH:MM\"\n");
     printf("  --add-task            Add a task (interactive)\n");
     printf("  --add-lab             Add a lab report (interactive)\n");
+    printf("  --verify              Check data file checksums\n");
+    printf("  --serve [socket]      Answer JSON requests on a Unix socket (default %s)\n", SOCKET_FILE);
     printf("  --json                Output in JSON format\n");
     printf("  --help                Show this help\n");
     printf("\nExamples:\n");
@@ -532,6 +1581,7 @@ void print_usage(const char* program) {
 
 int main(int argc, char* argv[]) {
     bool json_output = false;
+    int exit_code = 0;
     
     /* Check for JSON flag */
     for (int i = 1; i < argc; i++) {
@@ -545,16 +1595,23 @@ int main(int argc, char* argv[]) {
         return 0;
     }
     
+    /* One arena holds everything for this run */
+    Arena* arena = arena_create(0);
+    if (!arena) {
+        fprintf(stderr, "Error: Failed to allocate memory arena\n");
+        return 1;
+    }
+    
     /* Load or create schedule */
-    DailySchedule* schedule = load_schedule(DATA_FILE);
+    DailySchedule* schedule = load_schedule_in(arena, DATA_FILE);
     if (!schedule) {
-        schedule = schedule_create(MAX_TASKS);
+        schedule = schedule_create_in(arena, INITIAL_CAPACITY);
     }
     
     /* Load or create lab queue */
-    PriorityQueue* pq = load_lab_queue("labs.dat");
+    PriorityQueue* pq = load_lab_queue_in(arena, LAB_FILE);
     if (!pq) {
-        pq = pq_create(MAX_TASKS);
+        pq = pq_create_in(arena, INITIAL_CAPACITY);
     }
     
     /* Process commands */
@@ -584,6 +1641,35 @@ int main(int argc, char* argv[]) {
                 print_queue(pq);
             }
         }
+        else if (strcmp(argv[i], "--next") == 0) {
+            int limit;
+            char extra;
+            if (i + 1 >= argc || sscanf(argv[i + 1], "%d%c", &limit, &extra) != 1 || limit < 0) {
+                fprintf(stderr, "Error: --next needs a count\n");
+                exit_code = 1;
+                continue;
+            }
+            i++;
+            if (json_output) {
+                print_queue_listing_json(pq, limit, NULL);
+            } else {
+                print_queue_listing(pq, limit, NULL);
+            }
+        }
+        else if (strcmp(argv[i], "--due-before") == 0) {
+            time_t before;
+            if (i + 1 >= argc || !parse_local_time(argv[i + 1], &before)) {
+                fprintf(stderr, "Error: --due-before needs \"YYYY-MM-DD HH:MM\"\n");
+                exit_code = 1;
+                continue;
+            }
+            i++;
+            if (json_output) {
+                print_queue_listing_json(pq, -1, &before);
+            } else {
+                print_queue_listing(pq, -1, &before);
+            }
+        }
         else if (strcmp(argv[i], "--add-task") == 0) {
             Task task = {0};
             printf("Title: ");
@@ -609,10 +1695,26 @@ int main(int argc, char* argv[]) {
             
             task.is_deep_work = (task.duration_mins >= DEEP_WORK_MIN_MINUTES);
             
-            schedule_add_task(schedule, task);
-            save_schedule(schedule, DATA_FILE);
+            if (schedule_add_task(schedule, task) < 0 ||
+                schedule_log_add(schedule, DATA_FILE) != 0) {
+                exit_code = 1;
+            }
             printf("Task added!\n");
         }
+        else if (strcmp(argv[i], "--serve") == 0) {
+            const char* socket_path = SOCKET_FILE;
+            if (i + 1 < argc && strncmp(argv[i + 1], "--", 2) != 0) {
+                socket_path = argv[++i];
+            }
+            if (serve_requests(socket_path, schedule, DATA_FILE, pq, LAB_FILE) != 0) {
+                exit_code = 1;
+            }
+        }
+        else if (strcmp(argv[i], "--verify") == 0) {
+            if (verify_data_files(DATA_FILE, LAB_FILE) != 0) {
+                exit_code = 1;
+            }
+        }
         else if (strcmp(argv[i], "--add-lab") == 0) {
             LabReport report = {0};
             printf("Title: ");
@@ -635,15 +1737,28 @@ int main(int argc, char* argv[]) {
             tm.tm_mon -= 1;
             report.deadline = mktime(&tm);
             
-            pq_insert(pq, report);
-            save_lab_queue(pq, "labs.dat");
+            int id = pq_insert(pq, report);
+            if (id < 0 || pq_log_insert(pq, LAB_FILE, id) != 0) {
+                exit_code = 1;
+            }
             printf("Lab report added to queue!\n");
         }
     }
     
+    /* Group commit: one sync covers every edit made above */
+    if (schedule_sync(schedule, DATA_FILE) != 0) {
+        exit_code = 1;
+    }
+    if (pq_sync(pq, LAB_FILE) != 0) {
+        exit_code = 1;
+    }
+    
     /* Cleanup */
     schedule_destroy(schedule);
     pq_destroy(pq);
+    arena_destroy(arena);
     
-    return 0;
+    return exit_code;
 }
+
+#endif /* SCHEDULER_NO_MAIN */
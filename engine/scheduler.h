@@ -12,19 +12,39 @@
 #include <string.h>
 #include <time.h>
 #include <stdbool.h>
+#include <limits.h>
+
+#include "arena.h"
+#include "datafile.h"
+#include "journal.h"
+#include "json_writer.h"
 
 /* ============================================
  * CONSTANTS
  * ============================================ */
 
 #define MAX_TITLE_LEN 200
-#define MAX_TASKS 100
+#define INITIAL_CAPACITY 16     /* Starting size of growable arrays */
 #define DEEP_WORK_MIN_MINUTES 90
 #define WAKE_HOUR 4
 #define WAKE_MIN 30
 #define SLEEP_HOUR 22
 #define SLEEP_MIN 30
 #define DATA_FILE "schedule.dat"
+#define LAB_FILE "labs.dat"
+#define JOURNAL_COMPACT_ENTRIES 256 /* Sync rewrites the snapshot past this */
+
+/* Journal operations; the payload is one packed Task or LabReport */
+#define JOURNAL_TASK_ADD 1
+#define JOURNAL_TASK_REMOVE 2       /* Only the id is used */
+#define JOURNAL_LAB_INSERT 3
+#define JOURNAL_LAB_REMOVE 4        /* Only the id is used */
+#define JOURNAL_LAB_UPDATE 5        /* The report's new deadline and completion */
+
+#define PQ_DEFAULT_ARITY 4          /* Children per heap node; 4 measured faster (make bench-pq) */
+#define PQ_MAX_ARITY 8
+#define ID_INDEX_MIN_LIMIT (1 << 20) /* Loaded ids up to this (or 16 * count) are kept */
+#define ID_INDEX_MAX (INT_MAX / 2)
 
 /* ============================================
  * STRUCTURES
@@ -66,68 +86,159 @@ typedef struct {
     bool completed;
 } LabReport;
 
-/* Priority queue (min-heap by deadline & credits) */
+/* Priority queue (min-heap by deadline & credits) with an id index */
 typedef struct {
     LabReport* reports;
     int size;
-    int capacity;
+    int capacity;           /* Grows by doubling on insert */
+    int* position;          /* Heap index of each id, -1 if absent */
+    int position_capacity;  /* Ids below this have a position entry */
+    int next_id;            /* Id the next pq_insert hands out */
+    int* frontier;          /* Scratch heap for ordered traversals */
+    int frontier_capacity;
+    int arity;              /* Children per node: 2 (binary) or more */
+    bool ordered;           /* Heap order, position and next_id are built (loading defers them) */
+    Arena* arena;           /* Owner of reports, or NULL for the heap */
+    DataFileMap source;     /* File reports are mapped from until they grow */
+    Journal journal;        /* Edits since the snapshot was written */
 } PriorityQueue;
 
 /* Daily schedule container */
 typedef struct {
     Task* tasks;
     int task_count;
-    int capacity;
+    int capacity;           /* Grows by doubling; gaps hold capacity + 1 */
     ScheduleGap* gaps;
     int gap_count;
+    int* order;             /* Task indices by start time (capacity entries) */
+    bool sorted;            /* order is current; edits keep it so once built */
+    int* position;          /* Index in tasks of each id, -1 if absent */
+    int position_capacity;  /* Ids below this have a position entry */
+    int next_id;            /* Id the next schedule_add_task hands out */
+    bool indexed;           /* position and next_id are built (loading defers them) */
+    Arena* arena;           /* Owner of all memory, or NULL for the heap */
+    DataFileMap source;     /* File tasks are mapped from until they grow */
+    Journal journal;        /* Edits since the snapshot was written */
 } DailySchedule;
 
 /* ============================================
  * FUNCTION PROTOTYPES
  * ============================================ */
 
-/* Memory management */
+/* Memory management (the _in variants allocate from an arena; destroy
+ * then only unmaps a loaded file and the memory goes back on
+ * arena_reset). capacity is only the starting size; _reserve grows to
+ * at least n, 0 or -1 */
 DailySchedule* schedule_create(int capacity);
+DailySchedule* schedule_create_in(Arena* arena, int capacity);
+int schedule_reserve(DailySchedule* schedule, int n);
 void schedule_destroy(DailySchedule* schedule);
 PriorityQueue* pq_create(int capacity);
+PriorityQueue* pq_create_in(Arena* arena, int capacity);
+int pq_reserve(PriorityQueue* pq, int n);
 void pq_destroy(PriorityQueue* pq);
 
-/* Schedule operations */
+/* Schedule operations. Tasks stay in the order they were added; order
+ * indexes them by start time. schedule_sort_by_time builds it in
+ * O(n log n) when it is not current, and from then on add and remove
+ * keep it with a binary search (an id lookup for remove) and a shift
+ * of int indices. schedule_task_at is the i-th task by start time */
 int schedule_add_task(DailySchedule* schedule, Task task);
 int schedule_remove_task(DailySchedule* schedule, int task_id);
 void schedule_sort_by_time(DailySchedule* schedule);
+Task* schedule_task_at(DailySchedule* schedule, int i);
 
-/* Deep work gap analysis */
+/* Deep work gap analysis: a linear sweep in start-time order that
+ * tolerates overlapping tasks */
 int analyze_gaps(DailySchedule* schedule);
 void print_gaps(DailySchedule* schedule);
 int get_deep_work_gaps(DailySchedule* schedule, ScheduleGap** out_gaps);
 
-/* Priority queue (min-heap) */
-void pq_insert(PriorityQueue* pq, LabReport report);
+/* Priority queue (d-ary min-heap). Reports are found by id through the
+ * position index in O(1); remove and deadline updates are O(log n).
+ * pq_heapify rebuilds order and index in O(n), which a loaded queue
+ * leaves to its first use, and pq_set_arity rebuilds for another node
+ * width. -1 if id is unknown */
+int pq_insert(PriorityQueue* pq, LabReport report);
 LabReport pq_extract_min(PriorityQueue* pq);
 LabReport pq_peek(PriorityQueue* pq);
 bool pq_is_empty(PriorityQueue* pq);
+LabReport* pq_find(PriorityQueue* pq, int id);
+int pq_remove(PriorityQueue* pq, int id, LabReport* out);
+int pq_update_deadline(PriorityQueue* pq, int id, time_t deadline);
+int pq_set_completed(PriorityQueue* pq, int id, bool completed);
+int pq_heapify(PriorityQueue* pq);
+int pq_set_arity(PriorityQueue* pq, int arity);
 void pq_heapify_up(PriorityQueue* pq, int index);
 void pq_heapify_down(PriorityQueue* pq, int index);
 
-/* Binary file I/O */
+/* Ordered reads that leave the heap as it is, walking it from the root:
+ * the first k reports in O(k log k) and those due before a time (at
+ * most max) in O(m log m) for m results. Both copy in priority order
+ * and return the count, or -1 */
+int pq_top_k(PriorityQueue* pq, int k, LabReport* out);
+int pq_due_before(PriorityQueue* pq, time_t before, LabReport* out, int max);
+
+/* Binary file I/O (see datafile.h). Loading maps the file and uses its
+ * records in place without reading them: the schedule's id index and the
+ * queue's heap are built on first use, so a command that does not touch
+ * a file's records does not pay for them (replaying a non-empty journal
+ * does). Files in the original headerless layout are still
+ * read, and the next save rewrites them in the new format. save_*
+ * atomically rewrite the whole file and drop its journal (compaction).
+ * verify_data_files checksums both */
 int save_schedule(DailySchedule* schedule, const char* filename);
 DailySchedule* load_schedule(const char* filename);
+DailySchedule* load_schedule_in(Arena* arena, const char* filename);
 int save_lab_queue(PriorityQueue* pq, const char* filename);
 PriorityQueue* load_lab_queue(const char* filename);
+PriorityQueue* load_lab_queue_in(Arena* arena, const char* filename);
+int verify_data_files(const char* schedule_file, const char* lab_file);
+
+/* Journaled edits (see journal.h). Loading replays filename's journal
+ * over the snapshot. The _log calls record an edit already made in
+ * memory (schedule_log_add the last task added, pq_log_* the report
+ * with that id); edits are durable once _sync returns,
+ * and _sync compacts the journal into the snapshot when it has grown
+ * past JOURNAL_COMPACT_ENTRIES. Without a snapshot in the current
+ * format to extend, _log rewrites the file instead */
+int schedule_log_add(DailySchedule* schedule, const char* filename);
+int schedule_log_remove(DailySchedule* schedule, const char* filename, int task_id);
+int schedule_sync(DailySchedule* schedule, const char* filename);
+int pq_log_insert(PriorityQueue* pq, const char* filename, int id);
+int pq_log_remove(PriorityQueue* pq, const char* filename, int id);
+int pq_log_update(PriorityQueue* pq, const char* filename, int id);
+int pq_sync(PriorityQueue* pq, const char* filename);
 
 /* Utility functions */
 int time_to_minutes(TimeSlot t);
 TimeSlot minutes_to_time(int minutes);
 int compare_time(TimeSlot a, TimeSlot b);
+bool parse_local_time(const char* text, time_t* out);
 void print_task(Task* task);
 void print_schedule(DailySchedule* schedule);
 void print_lab_report(LabReport* report);
 void print_queue(PriorityQueue* pq);
 
-/* JSON output for Python integration */
+/* Queue listings in priority order: at most limit reports (-1 for no
+ * limit) and, with before, only those due before it. The plain
+ * versions list the whole queue */
+void print_queue_listing(PriorityQueue* pq, int limit, const time_t* before);
+
+/* JSON output for Python integration (see json_writer.h). _to_json
+ * write the same document, without the trailing newline, into buf and
+ * return its length; a result >= cap means buf was too small. write_*
+ * emit the document as one value into any writer */
+void write_gaps_json(JsonWriter* w, DailySchedule* schedule);
+void write_schedule_json(JsonWriter* w, DailySchedule* schedule);
+void write_queue_json(JsonWriter* w, PriorityQueue* pq);
+void write_queue_listing_json(JsonWriter* w, PriorityQueue* pq, int limit, const time_t* before);
 void print_gaps_json(DailySchedule* schedule);
 void print_schedule_json(DailySchedule* schedule);
 void print_queue_json(PriorityQueue* pq);
+void print_queue_listing_json(PriorityQueue* pq, int limit, const time_t* before);
+size_t gaps_to_json(DailySchedule* schedule, char* buf, size_t cap);
+size_t schedule_to_json(DailySchedule* schedule, char* buf, size_t cap);
+size_t queue_to_json(PriorityQueue* pq, char* buf, size_t cap);
 
 #endif /* SCHEDULER_H */
@@ -2,127 +2,122 @@
  * AI Engineering Study Assistant - Scheduler Engine
  * scheduler_engine.c - Constraint Satisfaction Solver for Timeline Optimization
  * 
- * This module implements a backtracking CSP solver for optimizing
- * weekly study schedules. It respects hard constraints (sleep, classes)
- * and applies heuristics for concept/practice placement.
+ * This module implements a greedy solver, an optional branch-and-bound
+ * CSP search and an optional local-search pass, which a portfolio solve
+ * races across threads, for optimizing weekly study schedules. It
+ * respects hard constraints (sleep, classes) and applies heuristics for
+ * concept/practice placement.
  * 
  * Compiled as a shared library for Python ctypes integration.
  */
 
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L     /* clock_gettime */
+#endif
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
 #include <time.h>
-
-/* ============================================
- * PLATFORM-SPECIFIC EXPORTS
- * ============================================ */
+#include <pthread.h>
 
 #ifdef _WIN32
-    #define EXPORT __declspec(dllexport)
-#else
-    #define EXPORT __attribute__((visibility("default")))
+    #include <windows.h>
 #endif
 
-/* ============================================
- * CONSTANTS
- * ============================================ */
+#include "scheduler_engine.h"
+#include "thread_pool.h"
+#include "score_simd.h"
+#include "json_writer.h"
 
-#define MAX_TITLE_LEN 200
-#define MAX_SUBJECT_LEN 20
-#define MAX_TASKS 100
-#define SLOTS_PER_DAY 48       /* 30-minute slots */
-#define WEEK_SLOTS 336         /* 7 days * 48 slots */
-#define EMPTY_SLOT -1
-#define BLOCKED_SLOT -2        /* Sleep or other blocked time */
+#if defined(_MSC_VER)
+    #define THREAD_LOCAL __declspec(thread)
+#else
+    #define THREAD_LOCAL __thread
+#endif
 
 /* ============================================
- * ENUMS
+ * CONSTANTS
  * ============================================ */
 
-typedef enum {
-    TASK_FIXED_CLASS = 0,      /* University lectures (immutable) */
-    TASK_STUDY_CONCEPT = 1,    /* Conceptual learning (morning priority) */
-    TASK_STUDY_PRACTICE = 2,   /* Practice problems (evening priority) */
-    TASK_MICRO_GAP = 3,        /* 15-30 min tasks */
-    TASK_SLEEP = 4,            /* Rest blocks */
-    TASK_BREAK = 5,            /* Break periods */
-    TASK_MEAL = 6,             /* Meal times */
-    TASK_REVISION = 7,         /* Spaced repetition */
-    TASK_ASSIGNMENT = 8,       /* Assignment work */
-    TASK_LAB_WORK = 9          /* Lab report work */
-} TaskCategory;
+#define SCORE_CACHE_SIZE 8     /* Configs whose score tables are kept */
 
 /* ============================================
  * STRUCTURES
  * ============================================ */
 
-/* Task to be placed in timeline */
-typedef struct {
-    int id;
-    int duration_slots;        /* Duration in 30-min slots */
-    int priority;              /* 1-10, higher = more important */
-    int category;              /* TaskCategory enum value */
-    int deadline_slot;         /* Absolute slot index for deadline */
-    bool is_locked;            /* If true, cannot be moved */
-    char title[MAX_TITLE_LEN];
-    char subject[MAX_SUBJECT_LEN];
-    int preferred_slot;        /* Preferred placement (-1 for none) */
-    int assigned_slot;         /* Assigned slot after optimization */
-} TimelineTask;
-
-/* Optimization configuration */
+/*
+ * Solver-side task list: only the fields placement reads, one array per
+ * field, in priority order. Titles and subjects stay in the caller's
+ * TimelineTask array, which the solver never reorders; source[i] is
+ * entry i's index there.
+ */
 typedef struct {
-    int sleep_start_slot;      /* Slot when sleep begins (22:00 = 44) */
-    int sleep_end_slot;        /* Slot when sleep ends (06:00 = 12) */
-    int concept_peak_start;    /* Morning peak start (08:00 = 16) */
-    int concept_peak_end;      /* Morning peak end (12:00 = 24) */
-    int practice_peak_start;   /* Evening peak start (16:00 = 32) */
-    int practice_peak_end;     /* Evening peak end (20:00 = 40) */
-    int deep_work_min_slots;   /* Min slots for deep work (3 = 90 min) */
-    int micro_gap_max_slots;   /* Max slots for micro-gaps (1 = 30 min) */
-    bool enable_heuristics;    /* Enable energy-based placement */
-} OptimizationConfig;
-
-/* Weekly timeline result */
+    int count;
+    int capacity;
+    int* id;
+    int* duration;
+    int* priority;
+    int* category;
+    int* deadline;
+    int* preferred;
+    int* assigned;
+    int* source;
+    bool* locked;
+} TaskSet;
+
+/* Best objective shared by the workers of a portfolio solve */
 typedef struct {
-    int slots[WEEK_SLOTS];     /* Task ID in each slot (-1 = empty) */
-    int slot_count;
-    TimelineTask* tasks;
-    int task_count;
-    int optimization_status;   /* 0=success, -1=unsolvable, -2=timeout */
-    int error_code;
-    int total_gaps_filled;
-    int total_conflicts;
-} WeeklyTimeline;
+    int64_t best_value;        /* Highest objective any worker has reached (atomic) */
+    int proven;                /* Set once a search completes: best_value is optimal */
+} SharedIncumbent;
 
-/* Gap in schedule */
+/* Slot geometry of one solve, derived from the config */
 typedef struct {
-    int start_slot;
-    int end_slot;
-    int duration_slots;
-    int day_index;
-    int gap_type;              /* 0=micro, 1=standard, 2=deep_work */
-} ScheduleGap;
+    int slots_per_day;
+    int slot_count;            /* slots_per_day * 7 * horizon_weeks */
+    int words;                 /* 64-bit words per bitmap actually used */
+} SlotGrid;
 
 /* ============================================
  * UTILITY FUNCTIONS
  * ============================================ */
 
 /* Get day index from absolute slot */
-static int get_day_index(int slot) {
-    return slot / SLOTS_PER_DAY;
+static int get_day_index(int slot, int slots_per_day) {
+    return slot / slots_per_day;
 }
 
 /* Get slot within day from absolute slot */
-static int get_day_slot(int slot) {
-    return slot % SLOTS_PER_DAY;
+static int get_day_slot(int slot, int slots_per_day) {
+    return slot % slots_per_day;
+}
+
+/*
+ * Geometry for a config; zero horizon_weeks / slot_minutes mean the
+ * default week of 30-minute slots. False if the combination is unsupported.
+ */
+static bool grid_from_config(const OptimizationConfig* config, SlotGrid* grid) {
+    int weeks = config->horizon_weeks ? config->horizon_weeks : 1;
+    int minutes = config->slot_minutes ? config->slot_minutes : MINUTES_PER_DAY / SLOTS_PER_DAY;
+    
+    if (weeks < 1 || weeks > MAX_HORIZON_WEEKS ||
+        (minutes != 15 && minutes != 30 && minutes != 60)) {
+        return false;
+    }
+    grid->slots_per_day = MINUTES_PER_DAY / minutes;
+    grid->slot_count = grid->slots_per_day * 7 * weeks;
+    grid->words = (grid->slot_count + 63) / 64;
+    return true;
 }
 
 /* Check if slot is in a time range (handles overnight ranges) */
-static bool is_in_range(int slot, int start, int end) {
-    int day_slot = get_day_slot(slot);
+static bool is_in_range(int slot, int start, int end, int slots_per_day) {
+    int day_slot = get_day_slot(slot, slots_per_day);
     
     if (start <= end) {
         /* Normal range (e.g., 16-24 for concept hours) */
@@ -134,365 +129,4688 @@ static bool is_in_range(int slot, int start, int end) {
 }
 
 /* Check if a slot is blocked for sleep */
-static bool is_sleep_slot(int slot, OptimizationConfig* config) {
-    return is_in_range(slot, config->sleep_start_slot, config->sleep_end_slot);
+static bool is_sleep_slot(int slot, const OptimizationConfig* config, int slots_per_day) {
+    return is_in_range(slot, config->sleep_start_slot, config->sleep_end_slot, slots_per_day);
 }
 
 /* Check if a slot is in concept study peak hours */
-static bool is_concept_peak(int slot, OptimizationConfig* config) {
-    return is_in_range(slot, config->concept_peak_start, config->concept_peak_end);
+static bool is_concept_peak(int slot, const OptimizationConfig* config, int slots_per_day) {
+    return is_in_range(slot, config->concept_peak_start, config->concept_peak_end, slots_per_day);
 }
 
 /* Check if a slot is in practice peak hours */
-static bool is_practice_peak(int slot, OptimizationConfig* config) {
-    return is_in_range(slot, config->practice_peak_start, config->practice_peak_end);
+static bool is_practice_peak(int slot, const OptimizationConfig* config, int slots_per_day) {
+    return is_in_range(slot, config->practice_peak_start, config->practice_peak_end, slots_per_day);
 }
 
-/* Compare tasks by priority (descending) then deadline (ascending) */
-static int compare_tasks(const void* a, const void* b) {
-    TimelineTask* ta = (TimelineTask*)a;
-    TimelineTask* tb = (TimelineTask*)b;
+/* Sort key for priority order */
+typedef struct {
+    int locked;
+    int priority;
+    int deadline;
+    int index;                 /* Input position, so equal keys keep input order */
+} TaskKey;
+
+/* Locked first, then priority (descending), then deadline (ascending) */
+static int compare_task_keys(const void* a, const void* b) {
+    const TaskKey* ka = (const TaskKey*)a;
+    const TaskKey* kb = (const TaskKey*)b;
     
-    /* Locked tasks first */
-    if (ta->is_locked != tb->is_locked) {
-        return ta->is_locked ? -1 : 1;
+    if (ka->locked != kb->locked) {
+        return ka->locked ? -1 : 1;
     }
-    
-    /* Higher priority first */
-    if (ta->priority != tb->priority) {
-        return tb->priority - ta->priority;
+    if (ka->priority != kb->priority) {
+        return ka->priority > kb->priority ? -1 : 1;
     }
-    
-    /* Earlier deadline first */
-    return ta->deadline_slot - tb->deadline_slot;
+    if (ka->deadline != kb->deadline) {
+        return ka->deadline < kb->deadline ? -1 : 1;
+    }
+    return (ka->index > kb->index) - (ka->index < kb->index);
+}
+
+static TaskKey task_key(const TimelineTask* task, int index) {
+    TaskKey key = { task->is_locked, task->priority, task->deadline_slot, index };
+    return key;
+}
+
+/* Locked tasks with a usable preferred slot are force-placed before search */
+static bool is_force_placed(const TaskSet* set, int i, int slot_count) {
+    return set->locked[i] && set->preferred[i] >= 0 &&
+           set->preferred[i] + set->duration[i] <= slot_count;
+}
+
+/* Monotonic clock in microseconds */
+static int64_t monotonic_us(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (int64_t)(now.QuadPart / freq.QuadPart) * 1000000 +
+           (int64_t)(now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/* Scratch memory: from the arena when there is one, else the heap */
+static void* scratch_alloc(Arena* arena, size_t size) {
+    return arena ? arena_alloc(arena, size) : malloc(size);
+}
+
+static void* scratch_calloc(Arena* arena, size_t count, size_t size) {
+    return arena ? arena_calloc(arena, count, size) : calloc(count, size);
 }
 
 /* ============================================
- * CONSTRAINT CHECKING
+ * ENGINE STATS
  * ============================================ */
 
-/* Check if task can be placed at given slot */
-static bool can_place_task(WeeklyTimeline* timeline, int slot, TimelineTask* task, OptimizationConfig* config) {
-    int duration = task->duration_slots;
-    
-    /* Check bounds */
-    if (slot < 0 || slot + duration > WEEK_SLOTS) {
-        return false;
-    }
-    
-    /* Check deadline constraint */
-    if (slot + duration > task->deadline_slot) {
-        return false;
+/*
+ * Counters for the calling thread's current solve, folded into process
+ * totals when it returns. Hot paths only bump a thread-local; the clock is
+ * read once per phase. Building with -DENGINE_NO_STATS turns every STAT_
+ * macro into nothing, so the counters cost nothing at all.
+ */
+#ifndef ENGINE_NO_STATS
+
+#define STATS_FIELDS ((int)(sizeof(EngineStats) / sizeof(int64_t)))
+
+static THREAD_LOCAL EngineStats g_solve_stats;
+static pthread_mutex_t g_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static EngineStats g_total_stats;
+
+#define STAT_ADD(field, n) (g_solve_stats.field += (n))
+#define STAT_CLOCK(lap) int64_t lap = monotonic_us()
+#define STAT_LAP(field, lap) stats_lap(&g_solve_stats.field, &(lap))
+#define STAT_SNAPSHOT(var) EngineStats var = g_solve_stats
+#define STAT_HAND_OVER(to, before) stats_hand_over(to, &(before))
+
+static void stats_add(EngineStats* to, const EngineStats* from) {
+    int64_t* dst = (int64_t*)to;
+    const int64_t* src = (const int64_t*)from;
+    for (int f = 0; f < STATS_FIELDS; f++) {
+        dst[f] += src[f];
     }
-    
-    /* Check all slots are available */
-    for (int i = 0; i < duration; i++) {
-        int check_slot = slot + i;
-        
-        /* Slot must be empty */
-        if (timeline->slots[check_slot] != EMPTY_SLOT) {
-            return false;
-        }
-        
-        /* Slot must not be during sleep (unless it's a sleep task) */
-        if (task->category != TASK_SLEEP && is_sleep_slot(check_slot, config)) {
-            return false;
-        }
+}
+
+/* Charge the time since *lap to a phase and restart the lap */
+static void stats_lap(int64_t* field, int64_t* lap) {
+    int64_t now = monotonic_us();
+    *field += now - *lap;
+    *lap = now;
+}
+
+static void stats_begin(void) {
+    memset(&g_solve_stats, 0, sizeof(g_solve_stats));
+    g_solve_stats.solves = 1;
+}
+
+static void stats_end(Arena* arena) {
+    if (arena) {
+        ArenaStats used;
+        arena_get_stats(arena, &used);
+        g_solve_stats.arena_bytes = (int64_t)used.bytes_used;
     }
-    
-    return true;
+    pthread_mutex_lock(&g_stats_lock);
+    stats_add(&g_total_stats, &g_solve_stats);
+    pthread_mutex_unlock(&g_stats_lock);
 }
 
-/* Calculate heuristic score for placing task at slot */
-static int get_placement_score(int slot, TimelineTask* task, OptimizationConfig* config) {
-    int score = 0;
-    
-    if (!config->enable_heuristics) {
-        return 0;
+/* A gap scan counts towards the last solve and the totals */
+static void stats_gap_scan(int64_t since) {
+    int64_t us = monotonic_us() - since;
+    g_solve_stats.gap_scan_us += us;
+    pthread_mutex_lock(&g_stats_lock);
+    g_total_stats.gap_scan_us += us;
+    pthread_mutex_unlock(&g_stats_lock);
+}
+
+/*
+ * Move what this thread counted since before into a solve's shared
+ * counters, so portfolio workers report to the solving thread whichever
+ * thread they ran on
+ */
+static void stats_hand_over(EngineStats* to, const EngineStats* before) {
+    int64_t* dst = (int64_t*)to;
+    const int64_t* now = (const int64_t*)&g_solve_stats;
+    const int64_t* then = (const int64_t*)before;
+    for (int f = 0; f < STATS_FIELDS; f++) {
+        __atomic_fetch_add(&dst[f], now[f] - then[f], __ATOMIC_RELAXED);
     }
-    
-    /* Bonus for placing concept tasks in morning peak */
-    if (task->category == TASK_STUDY_CONCEPT && is_concept_peak(slot, config)) {
-        score += 20;
+    g_solve_stats = *before;
+}
+
+#else
+
+#define STAT_ADD(field, n) ((void)0)
+#define STAT_CLOCK(lap) ((void)0)
+#define STAT_LAP(field, lap) ((void)0)
+#define STAT_SNAPSHOT(var) ((void)0)
+#define STAT_HAND_OVER(to, before) ((void)0)
+#define stats_add(to, from) ((void)0)
+#define stats_begin() ((void)0)
+#define stats_end(arena) ((void)0)
+#define stats_gap_scan(since) ((void)0)
+
+#endif /* ENGINE_NO_STATS */
+
+/*
+ * Counters of the calling thread's last solve (with any gap scans since)
+ * and totals over every solve in the process; either may be NULL. Returns
+ * 1, or 0 with both zeroed when built with ENGINE_NO_STATS.
+ */
+EXPORT int get_engine_stats(EngineStats* last_solve, EngineStats* totals) {
+#ifndef ENGINE_NO_STATS
+    if (last_solve) {
+        *last_solve = g_solve_stats;
     }
-    
-    /* Bonus for placing practice tasks in evening peak */
-    if (task->category == TASK_STUDY_PRACTICE && is_practice_peak(slot, config)) {
-        score += 20;
+    if (totals) {
+        pthread_mutex_lock(&g_stats_lock);
+        *totals = g_total_stats;
+        pthread_mutex_unlock(&g_stats_lock);
     }
-    
-    /* Penalty for placing concept tasks in evening */
-    if (task->category == TASK_STUDY_CONCEPT && is_practice_peak(slot, config)) {
-        score -= 10;
+    return 1;
+#else
+    if (last_solve) {
+        memset(last_solve, 0, sizeof(*last_solve));
     }
-    
-    /* Penalty for placing practice tasks in morning */
-    if (task->category == TASK_STUDY_PRACTICE && is_concept_peak(slot, config)) {
-        score -= 10;
+    if (totals) {
+        memset(totals, 0, sizeof(*totals));
     }
-    
-    /* Bonus for earlier placement (more buffer) */
-    int days_before_deadline = (task->deadline_slot - slot) / SLOTS_PER_DAY;
-    score += days_before_deadline * 2;
-    
-    return score;
+    return 0;
+#endif
+}
+
+/* Zero the process totals and the calling thread's last solve */
+EXPORT void reset_engine_stats(void) {
+#ifndef ENGINE_NO_STATS
+    memset(&g_solve_stats, 0, sizeof(g_solve_stats));
+    pthread_mutex_lock(&g_stats_lock);
+    memset(&g_total_stats, 0, sizeof(g_total_stats));
+    pthread_mutex_unlock(&g_stats_lock);
+#endif
 }
 
 /* ============================================
- * CSP SOLVER (Backtracking)
+ * SOLVE CONTROL
  * ============================================ */
 
-/* Place a task in the timeline */
-static void place_task(WeeklyTimeline* timeline, int slot, TimelineTask* task) {
-    for (int i = 0; i < task->duration_slots; i++) {
-        timeline->slots[slot + i] = task->id;
-    }
-    task->assigned_slot = slot;
+/*
+ * Deadline, cancel flag and progress callback of the calling thread's
+ * call (see SolveOptions), or NULL. Every phase polls it where it would
+ * read the clock anyway. Once it trips it stays tripped, and each phase
+ * stops with the best assignment it has. Portfolio and batch workers poll
+ * their own copy, which shares the trip flag but not the callback, so
+ * progress is only ever reported on the thread that made the call.
+ */
+#define CONTROL_REPORT_MS 100      /* Default time between progress reports */
+#define CONTROL_GREEDY_STRIDE 32   /* Greedy placements between polls */
+
+typedef struct {
+    int64_t start_us;
+    int64_t deadline_us;           /* 0 = none */
+    const int32_t* cancel;         /* NULL = none */
+    EngineProgressFn progress;     /* NULL = no reports (always on worker copies) */
+    void* progress_user;
+    int64_t interval_us;
+    int64_t next_report_us;
+    int task_count;                /* Tasks, or users for a batch */
+    int forced;                    /* Locked tasks placed by the current solve */
+    int* batch_done;               /* Users solved so far, or NULL outside a batch */
+    int* tripped;                  /* 0, or the EngineError that stopped the call */
+    int trip;                      /* What tripped points at on the calling thread */
+} SolveControl;
+
+static THREAD_LOCAL SolveControl* g_control = NULL;
+
+/* Engine time in microseconds, the clock of SolveOptions.deadline_us */
+EXPORT int64_t engine_clock_us(void) {
+    return monotonic_us();
 }
 
-/* Remove a task from the timeline */
-static void remove_task(WeeklyTimeline* timeline, int slot, TimelineTask* task) {
-    for (int i = 0; i < task->duration_slots; i++) {
-        timeline->slots[slot + i] = EMPTY_SLOT;
-    }
-    task->assigned_slot = -1;
+/* Does a call with these options need a control? */
+static bool control_wanted(const SolveOptions* options) {
+    return options && (options->deadline_us > 0 || options->cancel || options->progress);
 }
 
-/* Find best slot for a task using heuristics */
-static int find_best_slot(WeeklyTimeline* timeline, TimelineTask* task, OptimizationConfig* config) {
-    int best_slot = -1;
-    int best_score = -999999;
-    
-    /* If task has preferred slot and it's valid, use it */
-    if (task->preferred_slot >= 0 && can_place_task(timeline, task->preferred_slot, task, config)) {
-        return task->preferred_slot;
+static void control_init(SolveControl* c, const SolveOptions* options, int task_count) {
+    int interval_ms = options->progress_interval_ms > 0 ? options->progress_interval_ms
+                                                        : CONTROL_REPORT_MS;
+    memset(c, 0, sizeof(*c));
+    c->start_us = monotonic_us();
+    c->deadline_us = options->deadline_us;
+    c->cancel = options->cancel;
+    c->progress = options->progress;
+    c->progress_user = options->progress_user;
+    c->interval_us = (int64_t)interval_ms * 1000;
+    c->next_report_us = c->start_us + c->interval_us;
+    c->task_count = task_count;
+    c->tripped = &c->trip;
+}
+
+/* A worker thread's copy: same deadline, flag and trip, no callback */
+static void control_worker_copy(SolveControl* copy, const SolveControl* from) {
+    memset(copy, 0, sizeof(*copy));
+    copy->start_us = from->start_us;
+    copy->deadline_us = from->deadline_us;
+    copy->cancel = from->cancel;
+    copy->task_count = from->task_count;
+    copy->tripped = from->tripped;     /* Not from->trip: other workers may be setting it */
+}
+
+static int control_tripped(void) {
+    return g_control ? __atomic_load_n(g_control->tripped, __ATOMIC_RELAXED) : 0;
+}
+
+/*
+ * Checkpoint of a phase: trips the control if the flag is set or the
+ * deadline has passed, and reports progress when it is due. Returns 0 to
+ * keep going, or the EngineError of the trip.
+ */
+static int control_poll(int phase, int64_t work, int placed) {
+    SolveControl* c = g_control;
+    if (!c) {
+        return 0;
     }
-    
-    /* Search for best slot */
-    int search_limit = task->deadline_slot - task->duration_slots + 1;
-    if (search_limit > WEEK_SLOTS - task->duration_slots + 1) {
-        search_limit = WEEK_SLOTS - task->duration_slots + 1;
+    int trip = __atomic_load_n(c->tripped, __ATOMIC_RELAXED);
+    if (trip) {
+        return trip;
     }
-    
-    for (int slot = 0; slot < search_limit; slot++) {
-        if (can_place_task(timeline, slot, task, config)) {
-            int score = get_placement_score(slot, task, config);
-            
-            if (score > best_score) {
-                best_score = score;
-                best_slot = slot;
-            }
-        }
+    if (c->cancel && __atomic_load_n(c->cancel, __ATOMIC_RELAXED)) {
+        trip = ENGINE_ERROR_CANCELLED;
     }
-    
-    return best_slot;
-}
-
-/* Greedy solver with heuristics */
-static bool greedy_solve(WeeklyTimeline* timeline, TimelineTask* tasks, int task_count, OptimizationConfig* config) {
-    int placed = 0;
-    int conflicts = 0;
-    
-    /* Sort tasks by priority and deadline */
-    qsort(tasks, task_count, sizeof(TimelineTask), compare_tasks);
-    
-    /* Place each task */
-    for (int i = 0; i < task_count; i++) {
-        TimelineTask* task = &tasks[i];
-        
-        /* Find best slot */
-        int slot = find_best_slot(timeline, task, config);
-        
-        if (slot >= 0) {
-            place_task(timeline, slot, task);
-            placed++;
-        } else {
-            /* Could not place task */
-            conflicts++;
-            task->assigned_slot = -1;
+    int64_t now = (c->deadline_us > 0 || c->progress) ? monotonic_us() : 0;
+    if (!trip && c->deadline_us > 0 && now >= c->deadline_us) {
+        trip = ENGINE_ERROR_DEADLINE;
+    }
+    if (!trip && c->progress && now >= c->next_report_us) {
+        EngineProgress report = { phase, now - c->start_us, work, c->forced + placed, c->task_count };
+        if (c->batch_done) {
+            report.phase = ENGINE_PHASE_BATCH;
+            report.work = __atomic_load_n(c->batch_done, __ATOMIC_RELAXED);
+            report.placed = 0;
+        }
+        if (c->progress(&report, c->progress_user)) {
+            trip = ENGINE_ERROR_CANCELLED;
         }
+        c->next_report_us = monotonic_us() + c->interval_us;
     }
-    
-    timeline->total_conflicts = conflicts;
-    timeline->total_gaps_filled = placed;
-    
-    return conflicts == 0;
+    if (trip) {
+        __atomic_store_n(c->tripped, trip, __ATOMIC_RELAXED);
+    }
+    return trip;
 }
 
 /* ============================================
- * EXPORTED FUNCTIONS
+ * TASK SET
  * ============================================ */
 
-EXPORT WeeklyTimeline* optimize_timeline(TimelineTask* tasks, int count, OptimizationConfig* config) {
-    /* Allocate timeline */
-    WeeklyTimeline* timeline = (WeeklyTimeline*)malloc(sizeof(WeeklyTimeline));
-    if (!timeline) {
-        return NULL;
-    }
-    
-    /* Initialize all slots as empty */
-    for (int i = 0; i < WEEK_SLOTS; i++) {
-        timeline->slots[i] = EMPTY_SLOT;
+#define TASK_SET_INT_FIELDS 8
+
+/* Point every field array into one block sized by task_set_bytes */
+static void task_set_bind(TaskSet* set, void* block, int capacity) {
+    int* ints = (int*)block;
+    set->capacity = capacity;
+    set->id = ints;
+    set->duration = ints + capacity;
+    set->priority = ints + 2 * capacity;
+    set->category = ints + 3 * capacity;
+    set->deadline = ints + 4 * capacity;
+    set->preferred = ints + 5 * capacity;
+    set->assigned = ints + 6 * capacity;
+    set->source = ints + 7 * capacity;
+    set->locked = (bool*)(ints + TASK_SET_INT_FIELDS * capacity);
+}
+
+static size_t task_set_bytes(int capacity) {
+    return (sizeof(int) * TASK_SET_INT_FIELDS + sizeof(bool)) * (size_t)(capacity > 0 ? capacity : 1);
+}
+
+/* Copy entry src of one set into entry dst of another (or the same) set */
+static void task_set_copy_entry(TaskSet* to, int dst, const TaskSet* from, int src) {
+    to->id[dst] = from->id[src];
+    to->duration[dst] = from->duration[src];
+    to->priority[dst] = from->priority[src];
+    to->category[dst] = from->category[src];
+    to->deadline[dst] = from->deadline[src];
+    to->preferred[dst] = from->preferred[src];
+    to->assigned[dst] = from->assigned[src];
+    to->source[dst] = from->source[src];
+    to->locked[dst] = from->locked[src];
+}
+
+/* Move entries [src, src + n) to [dst, dst + n) within one set */
+static void task_set_move(TaskSet* set, int dst, int src, int n) {
+    if (n <= 0) {
+        return;
     }
-    
-    timeline->slot_count = WEEK_SLOTS;
-    timeline->tasks = tasks;
-    timeline->task_count = count;
-    timeline->optimization_status = 0;
-    timeline->error_code = 0;
-    timeline->total_gaps_filled = 0;
-    timeline->total_conflicts = 0;
-    
-    /* Use default config if none provided */
-    OptimizationConfig default_config = {
-        .sleep_start_slot = 46,      /* 23:00 */
-        .sleep_end_slot = 12,        /* 06:00 */
-        .concept_peak_start = 16,    /* 08:00 */
-        .concept_peak_end = 24,      /* 12:00 */
-        .practice_peak_start = 32,   /* 16:00 */
-        .practice_peak_end = 40,     /* 20:00 */
-        .deep_work_min_slots = 3,    /* 90 min */
-        .micro_gap_max_slots = 1,    /* 30 min */
-        .enable_heuristics = true
-    };
-    
-    OptimizationConfig* cfg = config ? config : &default_config;
-    
-    /* Mark sleep slots as blocked */
-    for (int day = 0; day < 7; day++) {
-        int day_offset = day * SLOTS_PER_DAY;
-        
-        /* Handle overnight sleep (e.g., 23:00 to 06:00) */
-        if (cfg->sleep_start_slot > cfg->sleep_end_slot) {
-            /* Evening portion */
-            for (int s = cfg->sleep_start_slot; s < SLOTS_PER_DAY; s++) {
-                timeline->slots[day_offset + s] = BLOCKED_SLOT;
-            }
-            /* Morning portion (next day logic handled by wrapping) */
-            int next_day_offset = ((day + 1) % 7) * SLOTS_PER_DAY;
-            for (int s = 0; s < cfg->sleep_end_slot; s++) {
-                if (next_day_offset + s < WEEK_SLOTS) {
-                    timeline->slots[next_day_offset + s] = BLOCKED_SLOT;
-                }
-            }
-        } else {
-            /* Normal range */
-            for (int s = cfg->sleep_start_slot; s < cfg->sleep_end_slot; s++) {
-                timeline->slots[day_offset + s] = BLOCKED_SLOT;
-            }
+    size_t bytes = sizeof(int) * (size_t)n;
+    memmove(set->id + dst, set->id + src, bytes);
+    memmove(set->duration + dst, set->duration + src, bytes);
+    memmove(set->priority + dst, set->priority + src, bytes);
+    memmove(set->category + dst, set->category + src, bytes);
+    memmove(set->deadline + dst, set->deadline + src, bytes);
+    memmove(set->preferred + dst, set->preferred + src, bytes);
+    memmove(set->assigned + dst, set->assigned + src, bytes);
+    memmove(set->source + dst, set->source + src, bytes);
+    memmove(set->locked + dst, set->locked + src, sizeof(bool) * (size_t)n);
+}
+
+static void task_set_fill(TaskSet* set, int i, const TimelineTask* task, int source) {
+    set->id[i] = task->id;
+    set->duration[i] = task->duration_slots;
+    set->priority[i] = task->priority;
+    set->category[i] = task->category;
+    set->deadline[i] = task->deadline_slot;
+    set->preferred[i] = task->preferred_slot;
+    set->assigned[i] = -1;
+    set->source[i] = source;
+    set->locked[i] = task->is_locked;
+}
+
+/*
+ * Build the priority-ordered set for tasks[0 .. count), with room for
+ * capacity (>= count) entries. Only a 16-byte
+ * key per task is sorted; the TimelineTask array is read once and left
+ * in the caller's order. Returns false if memory runs out.
+ */
+static bool task_set_build(TaskSet* set, const TimelineTask* tasks, int count, int capacity,
+                           Arena* arena) {
+    void* block = scratch_alloc(arena, task_set_bytes(capacity));
+    TaskKey* keys = (TaskKey*)scratch_alloc(arena, sizeof(TaskKey) * (count > 0 ? count : 1));
+    if (!block || !keys) {
+        if (!arena) {
+            free(block);
+            free(keys);
         }
+        return false;
     }
     
-    /* Place locked/fixed tasks first */
+    task_set_bind(set, block, capacity);
+    set->count = count;
+    
     for (int i = 0; i < count; i++) {
-        if (tasks[i].is_locked && tasks[i].preferred_slot >= 0) {
-            if (tasks[i].preferred_slot + tasks[i].duration_slots <= WEEK_SLOTS) {
-                /* Force place locked tasks */
-                for (int j = 0; j < tasks[i].duration_slots; j++) {
-                    timeline->slots[tasks[i].preferred_slot + j] = tasks[i].id;
-                }
-                tasks[i].assigned_slot = tasks[i].preferred_slot;
-            }
-        }
+        keys[i] = task_key(&tasks[i], i);
     }
-    
-    /* Run greedy solver on remaining tasks */
-    if (!greedy_solve(timeline, tasks, count, cfg)) {
-        /* Some tasks could not be placed */
-        if (timeline->total_conflicts > count / 2) {
-            timeline->optimization_status = -1; /* Unsolvable */
-        } else {
-            timeline->optimization_status = 0;  /* Partial success */
-        }
+    qsort(keys, count, sizeof(TaskKey), compare_task_keys);
+    for (int i = 0; i < count; i++) {
+        task_set_fill(set, i, &tasks[keys[i].index], keys[i].index);
     }
     
-    return timeline;
-}
-
-EXPORT void free_timeline_memory(WeeklyTimeline* timeline) {
-    if (timeline) {
-        /* Note: tasks array is owned by caller, don't free it */
-        free(timeline);
+    if (!arena) {
+        free(keys);
     }
+    return true;
 }
 
-EXPORT int validate_constraints(WeeklyTimeline* timeline) {
-    if (!timeline) return -1;
-    
-    int violations = 0;
-    
-    /* Check for overlaps */
-    for (int i = 0; i < WEEK_SLOTS; i++) {
-        if (timeline->slots[i] >= 0) {
-            /* Valid task ID - check consistency */
-        }
+/* Release a set built by task_set_build (arena memory goes on reset) */
+static void task_set_release(TaskSet* set, Arena* arena) {
+    if (!arena) {
+        free(set->id);
     }
-    
-    return violations;
+    set->id = NULL;
 }
 
-EXPORT int find_gaps(WeeklyTimeline* timeline, ScheduleGap* gaps, int max_gaps) {
-    if (!timeline || !gaps) return 0;
-    
-    int gap_count = 0;
-    int gap_start = -1;
-    
-    for (int i = 0; i < WEEK_SLOTS && gap_count < max_gaps; i++) {
-        if (timeline->slots[i] == EMPTY_SLOT) {
-            if (gap_start < 0) {
-                gap_start = i;
-            }
-        } else {
-            if (gap_start >= 0) {
-                /* End of gap */
-                int duration = i - gap_start;
-                
-                gaps[gap_count].start_slot = gap_start;
-                gaps[gap_count].end_slot = i;
-                gaps[gap_count].duration_slots = duration;
-                gaps[gap_count].day_index = get_day_index(gap_start);
-                
-                /* Classify gap type */
-                if (duration <= 1) {
-                    gaps[gap_count].gap_type = 0; /* micro */
-                } else if (duration <= 2) {
-                    gaps[gap_count].gap_type = 1; /* standard */
-                } else {
-                    gaps[gap_count].gap_type = 2; /* deep_work */
-                }
-                
-                gap_count++;
-                gap_start = -1;
-            }
-        }
+/* Copy every assignment back to its TimelineTask */
+static void task_set_write_back(const TaskSet* set, TimelineTask* tasks) {
+    for (int i = 0; i < set->count; i++) {
+        tasks[set->source[i]].assigned_slot = set->assigned[i];
     }
-    
-    /* Handle trailing gap */
-    if (gap_start >= 0 && gap_count < max_gaps) {
-        int duration = WEEK_SLOTS - gap_start;
-        gaps[gap_count].start_slot = gap_start;
-        gaps[gap_count].end_slot = WEEK_SLOTS;
-        gaps[gap_count].duration_slots = duration;
-        gaps[gap_count].day_index = get_day_index(gap_start);
-        gaps[gap_count].gap_type = duration <= 1 ? 0 : (duration <= 2 ? 1 : 2);
-        gap_count++;
-    }
-    
-    return gap_count;
 }
 
 /* ============================================
- * VERSION INFO
+ * OCCUPANCY BITMAP
  * ============================================ */
 
-EXPORT const char* get_engine_version(void) {
-    return "1.0.0";
+/*
+ * Slot sets are stored as 64-bit words, bit (slot % 64) of word
+ * (slot / 64). Buffers are sized for the largest grid (OCC_WORDS), but
+ * only the timeline's occ_words words are used. Padding bits past the
+ * horizon are always zero, so a run that would spill past the end never
+ * matches.
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define OCC_CTZ(x) __builtin_ctzll(x)
+    #define OCC_POPCOUNT(x) __builtin_popcountll(x)
+    #define OCC_INLINE static inline __attribute__((always_inline))
+#else
+static int occ_ctz_portable(uint64_t x) {
+    int n = 0;
+    while (!(x & 1)) { x >>= 1; n++; }
+    return n;
+}
+static int occ_popcount_portable(uint64_t x) {
+    int n = 0;
+    while (x) { x &= x - 1; n++; }
+    return n;
+}
+    #define OCC_CTZ(x) occ_ctz_portable(x)
+    #define OCC_POPCOUNT(x) occ_popcount_portable(x)
+    #define OCC_INLINE static inline
+#endif
+
+/* Mask of bits [lo, hi) within a single word (0 <= lo < hi <= 64) */
+static inline uint64_t occ_word_mask(int lo, int hi) {
+    uint64_t upper = (hi >= 64) ? ~0ULL : ((1ULL << hi) - 1);
+    return upper & ~((1ULL << lo) - 1);
 }
 
-EXPORT int get_slots_per_day(void) {
-    return SLOTS_PER_DAY;
+static inline void occ_clear_all(uint64_t* mask, int words) {
+    memset(mask, 0, sizeof(uint64_t) * words);
 }
 
-EXPORT int get_week_slots(void) {
-    return WEEK_SLOTS;
+static inline void occ_set_bit(uint64_t* mask, int slot) {
+    mask[slot >> 6] |= 1ULL << (slot & 63);
+}
+
+static inline void occ_clear_bit(uint64_t* mask, int slot) {
+    mask[slot >> 6] &= ~(1ULL << (slot & 63));
+}
+
+static inline bool occ_test_bit(const uint64_t* mask, int slot, int words) {
+    return slot >= 0 && slot < words * 64 && (mask[slot >> 6] >> (slot & 63)) & 1;
+}
+
+static inline int occ_count(const uint64_t* mask, int words) {
+    int n = 0;
+    for (int w = 0; w < words; w++) {
+        n += OCC_POPCOUNT(mask[w]);
+    }
+    return n;
+}
+
+/* Set bits [start, start + len) */
+static inline void occ_set_range(uint64_t* mask, int start, int len) {
+    int end = start + len;
+    while (start < end) {
+        int w = start >> 6;
+        int hi = (end - (w << 6) < 64) ? end - (w << 6) : 64;
+        mask[w] |= occ_word_mask(start & 63, hi);
+        start = (w + 1) << 6;
+    }
+}
+
+/* Clear bits [start, start + len) */
+static inline void occ_clear_range(uint64_t* mask, int start, int len) {
+    int end = start + len;
+    while (start < end) {
+        int w = start >> 6;
+        int hi = (end - (w << 6) < 64) ? end - (w << 6) : 64;
+        mask[w] &= ~occ_word_mask(start & 63, hi);
+        start = (w + 1) << 6;
+    }
+}
+
+/* True if every bit in [start, start + len) is set */
+static inline bool occ_range_all_set(const uint64_t* mask, int start, int len) {
+    int end = start + len;
+    while (start < end) {
+        int w = start >> 6;
+        int hi = (end - (w << 6) < 64) ? end - (w << 6) : 64;
+        uint64_t m = occ_word_mask(start & 63, hi);
+        if ((mask[w] & m) != m) {
+            return false;
+        }
+        start = (w + 1) << 6;
+    }
+    return true;
+}
+
+/* True if any bit in [start, start + len) is set */
+static inline bool occ_range_any_set(const uint64_t* mask, int start, int len) {
+    int end = start + len;
+    while (start < end) {
+        int w = start >> 6;
+        int hi = (end - (w << 6) < 64) ? end - (w << 6) : 64;
+        if (mask[w] & occ_word_mask(start & 63, hi)) {
+            return true;
+        }
+        start = (w + 1) << 6;
+    }
+    return false;
+}
+
+/* Keep only bits below limit */
+OCC_INLINE void occ_truncate(uint64_t* mask, int limit, int words) {
+    for (int w = 0; w < words; w++) {
+        int base = w << 6;
+        if (limit <= base) {
+            mask[w] = 0;
+        } else if (limit < base + 64) {
+            mask[w] &= occ_word_mask(0, limit - base);
+        }
+    }
+}
+
+/* dst bit i = src bit (i + k), for k >= 0; dst may alias src */
+OCC_INLINE void occ_shift_down(uint64_t* dst, const uint64_t* src, int k, int words) {
+    int q = k >> 6;
+    int r = k & 63;
+    for (int w = 0; w < words; w++) {
+        int s = w + q;
+        uint64_t lo = (s < words) ? src[s] : 0;
+        uint64_t hi = (s + 1 < words) ? src[s + 1] : 0;
+        dst[w] = r ? (lo >> r) | (hi << (64 - r)) : lo;
+    }
+}
+
+/*
+ * Compute the set of slots where a run of `len` consecutive set bits of
+ * `avail` begins. Uses doubling, so it costs O(log len) passes over the
+ * words instead of one check per (start, offset) pair.
+ */
+OCC_INLINE void occ_run_starts(uint64_t* out, const uint64_t* avail, int len, int words) {
+    uint64_t shifted[OCC_WORDS];
+    int have = 1;
+
+    memcpy(out, avail, sizeof(uint64_t) * words);
+
+    /* out marks runs of `have`; AND-ing with itself shifted by step <= have
+     * extends that to runs of have + step */
+    while (have < len) {
+        int step = (len - have < have) ? len - have : have;
+        occ_shift_down(shifted, out, step, words);
+        for (int w = 0; w < words; w++) {
+            out[w] &= shifted[w];
+        }
+        have += step;
+    }
+}
+
+/* Index of the first set bit at or after `from`, or -1 */
+static inline int occ_next_set(const uint64_t* mask, int from, int words) {
+    if (from < 0) {
+        from = 0;
+    }
+    int w = from >> 6;
+    if (w >= words) {
+        return -1;
+    }
+
+    uint64_t word = mask[w] & (~0ULL << (from & 63));
+    while (true) {
+        if (word) {
+            return (w << 6) + OCC_CTZ(word);
+        }
+        if (++w >= words) {
+            return -1;
+        }
+        word = mask[w];
+    }
+}
+
+/* Index of the first clear bit at or after from, or words * 64 if there is none */
+static inline int occ_next_clear(const uint64_t* mask, int from, int words) {
+    int w = from >> 6;
+    if (w >= words) {
+        return words << 6;
+    }
+
+    uint64_t word = ~mask[w] & (~0ULL << (from & 63));
+    while (true) {
+        if (word) {
+            return (w << 6) + OCC_CTZ(word);
+        }
+        if (++w >= words) {
+            return words << 6;
+        }
+        word = ~mask[w];
+    }
+}
+
+/* Index of the n-th set bit (0-based), or -1 if fewer are set */
+static int occ_nth_set(const uint64_t* mask, int n, int words) {
+    for (int w = 0; w < words; w++) {
+        int bits = OCC_POPCOUNT(mask[w]);
+        if (n < bits) {
+            uint64_t word = mask[w];
+            while (n-- > 0) {
+                word &= word - 1;
+            }
+            return (w << 6) + OCC_CTZ(word);
+        }
+        n -= bits;
+    }
+    return -1;
+}
+
+/* Build the sleep window mask for a config (once per solve) */
+static void build_sleep_mask(uint64_t* mask, const OptimizationConfig* config, const SlotGrid* grid) {
+    occ_clear_all(mask, grid->words);
+    for (int slot = 0; slot < grid->slot_count; slot++) {
+        if (is_sleep_slot(slot, config, grid->slots_per_day)) {
+            occ_set_bit(mask, slot);
+        }
+    }
+}
+
+/* Write a value into a slot range, keeping free_mask in sync */
+static void mark_slots(WeeklyTimeline* timeline, int start, int len, int value) {
+    for (int i = 0; i < len; i++) {
+        timeline->slots[start + i] = value;
+    }
+    if (value == EMPTY_SLOT) {
+        occ_set_range(timeline->free_mask, start, len);
+    } else {
+        occ_clear_range(timeline->free_mask, start, len);
+    }
+}
+
+/* Point a timeline at capacity ints of slot storage */
+static void timeline_bind(WeeklyTimeline* timeline, int* slots, int capacity) {
+    timeline->slots = slots;
+    timeline->slot_capacity = capacity;
+}
+
+/*
+ * n timelines with room for slot_count slots each, in one block from the
+ * arena or the heap: the structs first, then their slots. Without an
+ * arena one free releases them all.
+ */
+static WeeklyTimeline* timeline_alloc(Arena* arena, int n, int slot_count) {
+    size_t bytes = (sizeof(WeeklyTimeline) + sizeof(int) * (size_t)slot_count) * (size_t)n;
+    WeeklyTimeline* timelines = (WeeklyTimeline*)scratch_alloc(arena, bytes);
+    if (timelines) {
+        int* slots = (int*)(timelines + n);
+        for (int k = 0; k < n; k++) {
+            timeline_bind(&timelines[k], slots + (size_t)k * slot_count, slot_count);
+        }
+    }
+    return timelines;
+}
+
+/* Copy src into dst's own storage, which must hold src->slot_count slots */
+static void timeline_copy(WeeklyTimeline* dst, const WeeklyTimeline* src) {
+    int* slots = dst->slots;
+    int capacity = dst->slot_capacity;
+    *dst = *src;
+    timeline_bind(dst, slots, capacity);
+    memcpy(slots, src->slots, sizeof(int) * (size_t)src->slot_count);
+}
+
+/* Does a caller-built timeline have storage for its slot_count? */
+static bool timeline_slots_valid(const WeeklyTimeline* timeline) {
+    return timeline->slot_count >= 0 && timeline->slot_count <= MAX_SLOTS &&
+           timeline->slot_count <= timeline->slot_capacity && (timeline->slots || timeline->slot_count == 0);
+}
+
+/* Slots a task may occupy: empty, and outside sleep unless it is a sleep task */
+static void task_available_mask(WeeklyTimeline* timeline, int category, uint64_t* out) {
+    for (int w = 0; w < timeline->occ_words; w++) {
+        out[w] = timeline->free_mask[w];
+        if (category != TASK_SLEEP) {
+            out[w] &= ~timeline->sleep_mask[w];
+        }
+    }
+}
+
+/*
+ * Starts of free runs of len slots below limit. With a constant word
+ * count the loops above unroll completely, so the common grids get
+ * their own copies of this kernel (see task_valid_starts).
+ */
+OCC_INLINE void occ_valid_starts(uint64_t* out, const uint64_t* free_mask, const uint64_t* sleep_mask,
+                                 bool sleep_ok, int len, int limit, int words) {
+    uint64_t avail[OCC_WORDS];
+    for (int w = 0; w < words; w++) {
+        avail[w] = sleep_ok ? free_mask[w] : free_mask[w] & ~sleep_mask[w];
+    }
+    occ_run_starts(out, avail, len, words);
+    occ_truncate(out, limit, words);
+}
+
+/* ============================================
+ * CONSTRAINT CHECKING
+ * ============================================ */
+
+/* Check if task i can be placed at given slot */
+static bool can_place_task(WeeklyTimeline* timeline, const TaskSet* set, int i, int slot) {
+    int duration = set->duration[i];
+    STAT_ADD(can_place_calls, 1);
+    
+    /* Check bounds */
+    if (slot < 0 || slot + duration > timeline->slot_count) {
+        return false;
+    }
+    
+    /* Check deadline constraint */
+    if (slot + duration > set->deadline[i]) {
+        return false;
+    }
+    
+    /* All slots must be empty, and outside sleep unless it's a sleep task */
+    if (!occ_range_all_set(timeline->free_mask, slot, duration)) {
+        return false;
+    }
+    if (set->category[i] != TASK_SLEEP &&
+        occ_range_any_set(timeline->sleep_mask, slot, duration)) {
+        return false;
+    }
+    
+    return true;
+}
+
+/*
+ * Bitmap of every valid start slot for a task (bounds, deadline, free run)
+ * against a free and a sleep mask of slot_count slots in words words
+ */
+static void mask_valid_starts(const uint64_t* free_mask, const uint64_t* sleep_mask, int slot_count,
+                              int words, const TaskSet* set, int i, uint64_t* out) {
+    int limit = set->deadline[i] - set->duration[i] + 1;
+    
+    if (set->duration[i] <= 0) {
+        /* Zero-length tasks fit anywhere before the deadline */
+        occ_clear_all(out, words);
+        occ_set_range(out, 0, slot_count);
+        occ_truncate(out, limit, words);
+        return;
+    }
+    
+    bool sleep_ok = set->category[i] == TASK_SLEEP;
+    int len = set->duration[i];
+    
+    /* Specialized word counts for the common horizon/granularity pairs */
+    switch (words) {
+    case 3:     /* 1 week of 60-minute slots */
+        occ_valid_starts(out, free_mask, sleep_mask, sleep_ok, len, limit, 3);
+        break;
+    case 6:     /* 1 week of 30-minute slots (the default), 2 weeks of 60 */
+        occ_valid_starts(out, free_mask, sleep_mask, sleep_ok, len, limit, 6);
+        break;
+    case 11:    /* 1 week of 15-minute slots, 2 weeks of 30, 4 weeks of 60 */
+        occ_valid_starts(out, free_mask, sleep_mask, sleep_ok, len, limit, 11);
+        break;
+    case 21:    /* 2 weeks of 15-minute slots, 4 weeks of 30 */
+        occ_valid_starts(out, free_mask, sleep_mask, sleep_ok, len, limit, 21);
+        break;
+    default:
+        occ_valid_starts(out, free_mask, sleep_mask, sleep_ok, len, limit, words);
+        break;
+    }
+}
+
+/* mask_valid_starts on a timeline's own masks */
+static void task_valid_starts(WeeklyTimeline* timeline, const TaskSet* set, int i, uint64_t* out) {
+    mask_valid_starts(timeline->free_mask, timeline->sleep_mask, timeline->slot_count,
+                      timeline->occ_words, set, i, out);
+}
+
+/* Energy-peak bonus or penalty for a category at a slot */
+static int peak_bonus(int slot, int category, const OptimizationConfig* config, int slots_per_day) {
+    int score = 0;
+    
+    /* Bonus for placing concept tasks in morning peak */
+    if (category == TASK_STUDY_CONCEPT && is_concept_peak(slot, config, slots_per_day)) {
+        score += 20;
+    }
+    
+    /* Bonus for placing practice tasks in evening peak */
+    if (category == TASK_STUDY_PRACTICE && is_practice_peak(slot, config, slots_per_day)) {
+        score += 20;
+    }
+    
+    /* Penalty for placing concept tasks in evening */
+    if (category == TASK_STUDY_CONCEPT && is_practice_peak(slot, config, slots_per_day)) {
+        score -= 10;
+    }
+    
+    /* Penalty for placing practice tasks in morning */
+    if (category == TASK_STUDY_PRACTICE && is_concept_peak(slot, config, slots_per_day)) {
+        score -= 10;
+    }
+    
+    return score;
+}
+
+/* ============================================
+ * SCORE TABLES
+ * ============================================ */
+
+/*
+ * The placement score of a task at a start slot s (with s <= deadline d) is
+ *
+ *     peak_bonus(s) + 2 * floor((d - s) / slots_per_day)
+ *
+ * Writing d = n qd + rd and s = n qs + rs (n = slots_per_day), the buffer term is
+ * 2 qd - 2 qs - 2 [rs > rd]. The per-slot parts (peak bonus and -2 qs)
+ * go into one row per category, built once per config; 2 qd is a
+ * constant per task, and [rs > rd] is a compare against day_slot[].
+ *
+ * Rows are padded to whole bitmap words so the vector kernels never need
+ * a partial last word; padding lanes are zero and never in a mask. Only
+ * the first grid.words * 64 lanes are filled.
+ */
+#define SCORE_LANES (OCC_WORDS * 64)
+
+typedef struct {
+    bool heuristics;               /* false: every score is 0 */
+    SlotGrid grid;
+    int row[TASK_CATEGORY_COUNT][SCORE_LANES];
+    int day_slot[SCORE_LANES];     /* slot % slots_per_day */
+} ScoreTable;
+
+typedef struct {
+    ScoreTable table;
+    OptimizationConfig key;
+    bool valid;
+    int refs;                      /* Solves currently using the table */
+    unsigned long last_used;
+} ScoreCacheEntry;
+
+static pthread_mutex_t g_score_lock = PTHREAD_MUTEX_INITIALIZER;
+static ScoreCacheEntry g_score_cache[SCORE_CACHE_SIZE];
+static unsigned long g_score_clock = 0;
+
+static void build_score_table(ScoreTable* table, const OptimizationConfig* config, const SlotGrid* grid) {
+    int lanes = grid->words * 64;
+    int spd = grid->slots_per_day;
+    
+    table->heuristics = config->enable_heuristics;
+    table->grid = *grid;
+    for (int slot = 0; slot < lanes; slot++) {
+        table->day_slot[slot] = slot < grid->slot_count ? get_day_slot(slot, spd) : 0;
+    }
+    for (int c = 0; c < TASK_CATEGORY_COUNT; c++) {
+        for (int slot = 0; slot < lanes; slot++) {
+            table->row[c][slot] = slot < grid->slot_count
+                                ? peak_bonus(slot, c, config, spd) - 2 * get_day_index(slot, spd) : 0;
+        }
+    }
+}
+
+/* Only the fields that feed the score decide whether tables can be shared */
+static bool score_config_equal(const OptimizationConfig* a, const OptimizationConfig* b) {
+    SlotGrid ga = { 0, 0, 0 }, gb = { 0, 0, 0 };       /* Stay zero if unsupported */
+    grid_from_config(a, &ga);
+    grid_from_config(b, &gb);
+    return ga.slot_count == gb.slot_count && ga.slots_per_day == gb.slots_per_day &&
+           a->enable_heuristics == b->enable_heuristics &&
+           a->concept_peak_start == b->concept_peak_start &&
+           a->concept_peak_end == b->concept_peak_end &&
+           a->practice_peak_start == b->practice_peak_start &&
+           a->practice_peak_end == b->practice_peak_end;
+}
+
+/*
+ * Shared table for a config, built on first use. Returns NULL when every
+ * cache entry is in use by a different config; the caller then builds a
+ * private table. Pair with release_score_table.
+ */
+static const ScoreTable* acquire_score_table(const OptimizationConfig* config, const SlotGrid* grid) {
+    ScoreCacheEntry* found = NULL;
+    ScoreCacheEntry* victim = NULL;
+    
+    pthread_mutex_lock(&g_score_lock);
+    for (int i = 0; i < SCORE_CACHE_SIZE && !found; i++) {
+        ScoreCacheEntry* e = &g_score_cache[i];
+        if (e->valid && score_config_equal(&e->key, config)) {
+            found = e;
+        } else if (e->refs == 0 && (!victim || !e->valid ||
+                   (victim->valid && e->last_used < victim->last_used))) {
+            victim = e;
+        }
+    }
+    
+    if (!found && victim) {
+        /* Built under the lock; it is only a few thousand additions */
+        build_score_table(&victim->table, config, grid);
+        victim->key = *config;
+        victim->valid = true;
+        found = victim;
+    }
+    if (found) {
+        found->refs++;
+        found->last_used = ++g_score_clock;
+    }
+    pthread_mutex_unlock(&g_score_lock);
+    
+    return found ? &found->table : NULL;
+}
+
+static void release_score_table(const ScoreTable* table) {
+    pthread_mutex_lock(&g_score_lock);
+    for (int i = 0; i < SCORE_CACHE_SIZE; i++) {
+        if (&g_score_cache[i].table == table) {
+            g_score_cache[i].refs--;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_score_lock);
+}
+
+static const int* score_row(const ScoreTable* table, int category) {
+    /* Unknown categories get no peak bonus, like TASK_FIXED_CLASS */
+    if (category < 0 || category >= TASK_CATEGORY_COUNT) {
+        category = TASK_FIXED_CLASS;
+    }
+    return table->row[category];
+}
+
+/* Heuristic score for placing task i at slot (slot <= its deadline) */
+static int get_placement_score(int slot, const TaskSet* set, int i, const ScoreTable* table) {
+    if (!table->heuristics) {
+        return 0;
+    }
+    
+    int deadline = set->deadline[i];
+    int spd = table->grid.slots_per_day;
+    int penalty = table->day_slot[slot] > get_day_slot(deadline, spd) ? 2 : 0;
+    return score_row(table, set->category[i])[slot] + 2 * get_day_index(deadline, spd) - penalty;
+}
+
+/*
+ * Highest scoring set bit of mask for task i, earliest slot on ties;
+ * -1 if the mask is empty. The maximum comes from the vectorized
+ * reduction; the earliest slot reaching it is then found with ctz.
+ */
+static int best_scored_slot(const uint64_t* mask, const TaskSet* set, int i,
+                            const ScoreTable* table, int* out_score) {
+    int words = table->grid.words;
+    int spd = table->grid.slots_per_day;
+    STAT_ADD(slots_scanned, occ_count(mask, words));
+    
+    if (!table->heuristics) {
+        *out_score = 0;
+        return occ_next_set(mask, 0, words);
+    }
+    
+    const int* row = score_row(table, set->category[i]);
+    int deadline_slot = get_day_slot(set->deadline[i], spd);
+    int best = score_masked_max(row, table->day_slot, deadline_slot, mask, words);
+    int best_slot = -1;
+    
+    if (best != INT_MIN) {
+        for (int slot = occ_next_set(mask, 0, words); slot >= 0; slot = occ_next_set(mask, slot + 1, words)) {
+            if (row[slot] - (table->day_slot[slot] > deadline_slot ? 2 : 0) == best) {
+                best_slot = slot;
+                break;
+            }
+        }
+    }
+    
+    *out_score = best_slot >= 0 ? best + 2 * get_day_index(set->deadline[i], spd) : 0;
+    return best_slot;
+}
+
+/* ============================================
+ * GREEDY SOLVER
+ * ============================================ */
+
+/* Place task i in the timeline */
+static void place_task(WeeklyTimeline* timeline, TaskSet* set, int i, int slot) {
+    STAT_ADD(placements, 1);
+    mark_slots(timeline, slot, set->duration[i], set->id[i]);
+    set->assigned[i] = slot;
+}
+
+/* Remove task i from the timeline */
+static void remove_task(WeeklyTimeline* timeline, TaskSet* set, int i) {
+    mark_slots(timeline, set->assigned[i], set->duration[i], EMPTY_SLOT);
+    set->assigned[i] = -1;
+}
+
+/* Find best slot for task i using heuristics */
+static int find_best_slot(WeeklyTimeline* timeline, const TaskSet* set, int i, const ScoreTable* scores) {
+    int best_score;
+    
+    /* If task has preferred slot and it's valid, use it */
+    if (set->preferred[i] >= 0 && can_place_task(timeline, set, i, set->preferred[i])) {
+        return set->preferred[i];
+    }
+    
+    /* Score only the slots where a long-enough free run begins */
+    uint64_t starts[OCC_WORDS];
+    task_valid_starts(timeline, set, i, starts);
+    
+    return best_scored_slot(starts, set, i, scores, &best_score);
+}
+
+/* Greedy solver with heuristics (the set is already in priority order).
+ * Entries with skip[i] set (skip may be NULL) are left unplaced */
+static bool greedy_solve(WeeklyTimeline* timeline, TaskSet* set, const ScoreTable* scores, const bool* skip) {
+    int placed = 0;
+    int conflicts = 0;
+    int tried = 0;
+    bool stopped = false;
+    
+    /* Place each task */
+    for (int i = 0; i < set->count; i++) {
+        /* Locked tasks were already force-placed at their preferred slot */
+        if (is_force_placed(set, i, timeline->slot_count)) {
+            placed++;
+            continue;
+        }
+        
+        if (skip && skip[i]) {
+            conflicts++;
+            set->assigned[i] = -1;
+            continue;
+        }
+        
+        /* Once the control trips the remaining tasks stay unplaced */
+        if (!stopped && tried % CONTROL_GREEDY_STRIDE == 0) {
+            stopped = control_poll(ENGINE_PHASE_GREEDY, tried, tried - conflicts) != 0;
+        }
+        tried++;
+        
+        /* Find best slot */
+        int slot = stopped ? -1 : find_best_slot(timeline, set, i, scores);
+        
+        if (slot >= 0) {
+            place_task(timeline, set, i, slot);
+            placed++;
+        } else {
+            /* Could not place task */
+            conflicts++;
+            set->assigned[i] = -1;
+        }
+    }
+    
+    timeline->total_conflicts = conflicts;
+    timeline->total_gaps_filled = placed;
+    
+    return conflicts == 0;
+}
+
+/* ============================================
+ * BRANCH AND BOUND SEARCH
+ * ============================================ */
+
+/*
+ * Objective, maximized lexicographically via a weight: number of tasks
+ * placed, then the sum of get_placement_score. Preferred slots only break
+ * ties: they are tried first and an incumbent is only replaced by a
+ * strictly better one. Force-placed locked tasks are constants and are
+ * left out of the search entirely.
+ */
+#define BNB_W_PLACED    ((int64_t)1 << 44)
+#define BNB_CLOCK_INTERVAL 256     /* Nodes between clock reads (small task sets) */
+
+/* One level of the explicit DFS stack */
+typedef struct {
+    int task;                      /* Index into the task set */
+    int stage;                     /* 0 = preferred, 1 = scored slots, 2 = unplaced, 3 = exhausted */
+    int slot;                      /* Current placement, -1 if none */
+    int64_t gain;                  /* Objective contributed by the current value */
+    uint64_t domain[OCC_WORDS];    /* Start slots not tried yet */
+} SearchFrame;
+
+typedef struct {
+    WeeklyTimeline* timeline;      /* Working timeline mutated by the search */
+    TaskSet* set;
+    const ScoreTable* scores;
+    bool* decided;                 /* Force-placed, or assigned on the current path */
+    int64_t* bound;                /* Best gain each task could ever contribute */
+    int64_t upper;                 /* Sum of bound: no assignment can beat it */
+    int* best_slots;               /* assigned_slot of every task in the incumbent */
+    int64_t best_value;
+    int64_t value;                 /* Objective of the current partial assignment */
+    bool improved;                 /* Incumbent beaten at least once */
+    int64_t nodes;
+    int64_t node_limit;            /* 0 = unlimited */
+    int64_t deadline_us;           /* 0 = unlimited */
+    int clock_interval;            /* Nodes between clock reads */
+    bool timed_out;
+    bool optimal;                  /* The incumbent reached upper */
+    SharedIncumbent* shared;       /* Portfolio incumbent, or NULL */
+} SearchState;
+
+/* Objective contributed by task t placed at slot (local search uses it too) */
+static int64_t objective_gain(const TaskSet* set, const ScoreTable* scores, int t, int slot) {
+    return BNB_W_PLACED + get_placement_score(slot, set, t, scores);
+}
+
+static int64_t placement_gain(SearchState* st, int t, int slot) {
+    return objective_gain(st->set, st->scores, t, slot);
+}
+
+/* Objective of the assignment stored in a set (force-placed tasks excluded) */
+static int64_t set_objective(const TaskSet* set, const ScoreTable* scores, int slot_count) {
+    int64_t value = 0;
+    for (int t = 0; t < set->count; t++) {
+        if (!is_force_placed(set, t, slot_count) && set->assigned[t] >= 0) {
+            value += objective_gain(set, scores, t, set->assigned[t]);
+        }
+    }
+    return value;
+}
+
+/* Raise the shared best value to at least value */
+static void share_incumbent(SharedIncumbent* shared, int64_t value) {
+    if (!shared) {
+        return;
+    }
+    int64_t seen = __atomic_load_n(&shared->best_value, __ATOMIC_RELAXED);
+    while (value > seen &&
+           !__atomic_compare_exchange_n(&shared->best_value, &seen, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static bool incumbent_proven(const SharedIncumbent* shared) {
+    return shared && __atomic_load_n(&shared->proven, __ATOMIC_RELAXED);
+}
+
+/* What a subtree must beat: this search's incumbent or any worker's */
+static int64_t incumbent_bound(SearchState* st) {
+    if (!st->shared) {
+        return st->best_value;
+    }
+    int64_t shared = __atomic_load_n(&st->shared->best_value, __ATOMIC_RELAXED);
+    return shared > st->best_value ? shared : st->best_value;
+}
+
+/* Highest scoring start in a domain (earliest wins ties), or -1 */
+static int best_scored_start(SearchState* st, int t, const uint64_t* domain) {
+    int score;
+    return best_scored_slot(domain, st->set, t, st->scores, &score);
+}
+
+/*
+ * Forward check every undecided task against the current occupancy and
+ * pick the one with the fewest valid starts (MRV); its domain goes to
+ * out_domain. Tasks whose domain is empty are certain conflicts on this
+ * branch and add nothing to *optimistic, the best gain still reachable.
+ * Returns -1 when no undecided task can be placed any more.
+ */
+static int select_task(SearchState* st, uint64_t* out_domain, int64_t* optimistic) {
+    int best = -1;
+    int best_size = INT_MAX;
+    int64_t reachable = 0;
+    uint64_t domain[OCC_WORDS];
+    
+    for (int t = 0; t < st->set->count; t++) {
+        if (st->decided[t]) {
+            continue;
+        }
+        
+        task_valid_starts(st->timeline, st->set, t, domain);
+        int size = occ_count(domain, st->timeline->occ_words);
+        if (size == 0) {
+            continue;
+        }
+        
+        reachable += st->bound[t];
+        if (size < best_size) {
+            best_size = size;
+            best = t;
+            memcpy(out_domain, domain, sizeof(uint64_t) * st->timeline->occ_words);
+        }
+    }
+    
+    *optimistic = reachable;
+    return best;
+}
+
+static void push_frame(SearchState* st, SearchFrame* frame, int t) {
+    frame->task = t;
+    frame->stage = 0;
+    frame->slot = -1;
+    frame->gain = 0;
+    st->decided[t] = true;
+}
+
+static bool search_budget_exhausted(SearchState* st) {
+    st->nodes++;
+    if (incumbent_proven(st->shared)) {
+        return true;
+    }
+    if (st->node_limit > 0 && st->nodes >= st->node_limit) {
+        return true;
+    }
+    if (st->nodes % st->clock_interval == 0) {
+        if (st->deadline_us > 0 && monotonic_us() >= st->deadline_us) {
+            return true;
+        }
+        if (control_poll(ENGINE_PHASE_SEARCH, st->nodes, (int)(st->best_value / BNB_W_PLACED))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Depth-first branch and bound over the undecided tasks */
+static void bnb_search(SearchState* st, SearchFrame* stack) {
+    int64_t optimistic;
+    int t = select_task(st, stack[0].domain, &optimistic);
+    
+    if (t < 0 || st->value + optimistic <= incumbent_bound(st)) {
+        return;
+    }
+    push_frame(st, &stack[0], t);
+    int depth = 1;
+    
+    while (depth > 0) {
+        SearchFrame* f = &stack[depth - 1];
+        int preferred = st->set->preferred[f->task];
+        
+        /* Undo this level's previous value */
+        if (f->slot >= 0) {
+            remove_task(st->timeline, st->set, f->task);
+            f->slot = -1;
+        }
+        st->value -= f->gain;
+        f->gain = 0;
+        
+        /* Next value: preferred slot, then by descending score, then unplaced */
+        int slot = -1;
+        bool have_value = false;
+        
+        if (f->stage == 0) {
+            f->stage = 1;
+            if (occ_test_bit(f->domain, preferred, st->timeline->occ_words)) {
+                slot = preferred;
+                occ_clear_bit(f->domain, slot);
+                have_value = true;
+            }
+        }
+        if (!have_value && f->stage == 1) {
+            slot = best_scored_start(st, f->task, f->domain);
+            if (slot >= 0) {
+                occ_clear_bit(f->domain, slot);
+                have_value = true;
+            } else {
+                f->stage = 2;
+            }
+        }
+        if (!have_value && f->stage == 2) {
+            f->stage = 3;
+            have_value = true;     /* slot stays -1: leave the task unplaced */
+        }
+        if (!have_value) {
+            st->decided[f->task] = false;
+            depth--;
+            STAT_ADD(backtracks, 1);
+            continue;
+        }
+        
+        if (slot >= 0) {
+            place_task(st->timeline, st->set, f->task, slot);
+            f->slot = slot;
+            f->gain = placement_gain(st, f->task, slot);
+            st->value += f->gain;
+        }
+        
+        if (search_budget_exhausted(st)) {
+            st->timed_out = true;
+            return;
+        }
+        
+        t = select_task(st, stack[depth].domain, &optimistic);
+        if (st->value + optimistic <= incumbent_bound(st)) {
+            continue;              /* Bound: this subtree cannot beat the incumbent */
+        }
+        if (t < 0) {
+            /* Leaf that beats the incumbent */
+            memcpy(st->best_slots, st->set->assigned, sizeof(int) * st->set->count);
+            st->best_value = st->value;
+            st->improved = true;
+            share_incumbent(st->shared, st->value);
+            if (st->value >= st->upper) {
+                st->optimal = true;    /* Nothing can beat the static bound */
+                return;
+            }
+            continue;
+        }
+        
+        push_frame(st, &stack[depth], t);
+        depth++;
+    }
+}
+
+/*
+ * Greedy pass for the incumbent, then branch and bound from the
+ * pre-greedy timeline. Stops early once the incumbent reaches the sum of
+ * the per-task bounds. Returns false if the budget ran out before the
+ * search space was exhausted; the timeline then holds the best
+ * assignment found so far, which is never worse than greedy. With a
+ * shared incumbent, subtrees that cannot beat any worker's best are
+ * pruned too, and finishing marks that best proven.
+ */
+static bool branch_and_bound_solve(WeeklyTimeline* timeline, TaskSet* set,
+                                   const ScoreTable* scores, const SolveOptions* options,
+                                   Arena* arena, SharedIncumbent* shared) {
+    int64_t start_us = monotonic_us();
+    int count = set->count;
+    ArenaMark mark = arena_mark(arena);
+    
+    WeeklyTimeline* base = timeline_alloc(arena, 2, timeline->slot_count);
+    SearchFrame* stack = (SearchFrame*)scratch_alloc(arena, sizeof(SearchFrame) * (count + 1));
+    bool* decided = (bool*)scratch_calloc(arena, count + 1, sizeof(bool));
+    int64_t* bound = (int64_t*)scratch_calloc(arena, count + 1, sizeof(int64_t));
+    int* best_slots = (int*)scratch_alloc(arena, sizeof(int) * (count + 1));
+    
+    if (!base || !stack || !decided || !bound || !best_slots) {
+        /* Not enough memory to search: greedy result only */
+        if (arena) {
+            arena_rewind(arena, mark);
+        } else {
+            free(base); free(stack); free(decided); free(bound); free(best_slots);
+        }
+        greedy_solve(timeline, set, scores, NULL);
+        return true;
+    }
+    
+    WeeklyTimeline* work = base + 1;
+    timeline_copy(base, timeline);
+    timeline_copy(work, base);
+    greedy_solve(timeline, set, scores, NULL);
+    
+    SearchState st = {
+        .timeline = work,
+        .set = set,
+        .scores = scores,
+        .decided = decided,
+        .bound = bound,
+        .best_slots = best_slots,
+        .node_limit = options->node_limit,
+        .deadline_us = options->time_limit_ms > 0
+                       ? start_us + (int64_t)options->time_limit_ms * 1000 : 0,
+        /* A node costs O(count), so big sets read the clock more often */
+        .clock_interval = count > 64 ? (BNB_CLOCK_INTERVAL * 64 / count > 1
+                                        ? BNB_CLOCK_INTERVAL * 64 / count : 1)
+                                     : BNB_CLOCK_INTERVAL,
+        .shared = shared
+    };
+    
+    /* Greedy result is the incumbent */
+    st.best_value = set_objective(set, scores, timeline->slot_count);
+    memcpy(best_slots, set->assigned, sizeof(int) * count);
+    share_incumbent(shared, st.best_value);
+    
+    /* Static per-task bounds over the pre-greedy domain (work is still base) */
+    uint64_t domain[OCC_WORDS];
+    for (int t = 0; t < count; t++) {
+        if (is_force_placed(set, t, timeline->slot_count)) {
+            decided[t] = true;
+            continue;
+        }
+        set->assigned[t] = -1;
+        task_valid_starts(work, set, t, domain);
+        
+        /* Best scored start anywhere in the empty week */
+        int64_t best_gain = 0;
+        int score;
+        if (best_scored_slot(domain, set, t, scores, &score) >= 0) {
+            best_gain = BNB_W_PLACED + score;
+        }
+        bound[t] = best_gain;
+        st.upper += best_gain;
+        decided[t] = (best_gain == 0);     /* Can never be placed */
+    }
+    
+    if (control_tripped()) {
+        st.timed_out = true;       /* Stopped during the greedy pass */
+    } else if (st.best_value < st.upper) {
+        bnb_search(&st, stack);    /* Otherwise greedy is already optimal */
+    }
+    
+    /* Rebuild the timeline from the best assignment found */
+    if (st.improved) {
+        timeline_copy(timeline, base);
+        int placed = 0;
+        int conflicts = 0;
+        for (int t = 0; t < count; t++) {
+            set->assigned[t] = best_slots[t];
+            if (is_force_placed(set, t, timeline->slot_count)) {
+                placed++;
+            } else if (best_slots[t] >= 0) {
+                mark_slots(timeline, best_slots[t], set->duration[t], set->id[t]);
+                placed++;
+            } else {
+                conflicts++;
+            }
+        }
+        timeline->total_gaps_filled = placed;
+        timeline->total_conflicts = conflicts;
+    } else {
+        memcpy(set->assigned, best_slots, sizeof(int) * count);
+    }
+    
+    bool complete = !st.timed_out;
+    if (complete && shared) {
+        __atomic_store_n(&shared->proven, 1, __ATOMIC_RELAXED);
+    }
+    if (arena) {
+        arena_rewind(arena, mark);
+    } else {
+        free(base); free(stack); free(decided); free(bound); free(best_slots);
+    }
+    return complete;
+}
+
+/* ============================================
+ * LOCAL SEARCH
+ * ============================================ */
+
+/*
+ * Simulated annealing from a solved timeline. The moves are: shift a task
+ * a few slots, relocate it to a random valid start, or swap the starts of
+ * two tasks. A move only changes the moved tasks' gains, so its delta is
+ * scored from those alone, and its validity is checked against the
+ * free and sleep bitmaps over the slots it touches. Every accepted move
+ * frees slots, so unplaced tasks are retried after it. The objective is
+ * the branch-and-bound one, tasks placed and then total
+ * get_placement_score, so the walk never trades score for preferred-slot
+ * hits. The best assignment seen is restored at the end: the result
+ * places at least as many tasks as the timeline it started from, and
+ * scores at least as much when it places the same number.
+ */
+#define LS_SEED 0x9e3779b9u
+#define LS_SHIFT_RANGE 4           /* Max slots a shift moves a task */
+#define LS_TEMP_START 8.0          /* Losing a full peak bonus (-30) is accepted ~2% of the time */
+#define LS_TEMP_END 0.05
+#define LS_CLOCK_INTERVAL 64       /* Moves between clock reads */
+
+typedef struct {
+    WeeklyTimeline* timeline;
+    TaskSet* set;
+    const ScoreTable* scores;
+    int* movable;                  /* Placed tasks that are not force-placed */
+    int movable_count;
+    int* unplaced;
+    int unplaced_count;
+    int* best_slots;               /* assigned of every task at best_value */
+    int64_t value;                 /* Objective of the current assignment */
+    int64_t best_value;
+    uint32_t rng;
+} LocalSearch;
+
+/* Tasks changed by the last move and their previous starts */
+typedef struct {
+    int n;
+    int task[2];
+    int from[2];
+} LocalMove;
+
+static uint32_t ls_random(LocalSearch* ls) {
+    uint32_t x = ls->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    ls->rng = x;
+    return x;
+}
+
+/* In score units within one placed count, so LS_TEMP_ reads as score lost */
+static int64_t ls_gain(LocalSearch* ls, int t, int slot) {
+    return objective_gain(ls->set, ls->scores, t, slot);
+}
+
+/* Put back the tasks of a move (all are lifted before any is placed) */
+static void ls_undo(LocalSearch* ls, const LocalMove* move) {
+    for (int k = 0; k < move->n; k++) {
+        remove_task(ls->timeline, ls->set, move->task[k]);
+    }
+    for (int k = 0; k < move->n; k++) {
+        place_task(ls->timeline, ls->set, move->task[k], move->from[k]);
+    }
+}
+
+/* Move t to slot if it fits there once lifted; the delta goes to *delta */
+static bool ls_shift_to(LocalSearch* ls, int t, int slot, LocalMove* move, int64_t* delta) {
+    int from = ls->set->assigned[t];
+    remove_task(ls->timeline, ls->set, t);
+    if (slot == from || !can_place_task(ls->timeline, ls->set, t, slot)) {
+        place_task(ls->timeline, ls->set, t, from);
+        return false;
+    }
+    place_task(ls->timeline, ls->set, t, slot);
+    move->n = 1;
+    move->task[0] = t;
+    move->from[0] = from;
+    *delta = ls_gain(ls, t, slot) - ls_gain(ls, t, from);
+    return true;
+}
+
+static bool ls_shift(LocalSearch* ls, LocalMove* move, int64_t* delta) {
+    int t = ls->movable[ls_random(ls) % (uint32_t)ls->movable_count];
+    int offset = 1 + (int)(ls_random(ls) % LS_SHIFT_RANGE);
+    if (ls_random(ls) & 1) {
+        offset = -offset;
+    }
+    return ls_shift_to(ls, t, ls->set->assigned[t] + offset, move, delta);
+}
+
+static bool ls_relocate(LocalSearch* ls, LocalMove* move, int64_t* delta) {
+    int t = ls->movable[ls_random(ls) % (uint32_t)ls->movable_count];
+    int from = ls->set->assigned[t];
+    uint64_t starts[OCC_WORDS];
+    
+    remove_task(ls->timeline, ls->set, t);
+    task_valid_starts(ls->timeline, ls->set, t, starts);
+    place_task(ls->timeline, ls->set, t, from);
+    
+    /* from is always among the starts, so there is at least one */
+    int n = occ_count(starts, ls->timeline->occ_words);
+    int slot = occ_nth_set(starts, (int)(ls_random(ls) % (uint32_t)n), ls->timeline->occ_words);
+    return ls_shift_to(ls, t, slot, move, delta);
+}
+
+static bool ls_swap(LocalSearch* ls, LocalMove* move, int64_t* delta) {
+    if (ls->movable_count < 2) {
+        return false;
+    }
+    int a = ls->movable[ls_random(ls) % (uint32_t)ls->movable_count];
+    int b = ls->movable[ls_random(ls) % (uint32_t)ls->movable_count];
+    int from_a = ls->set->assigned[a];
+    int from_b = ls->set->assigned[b];
+    if (a == b || from_a == from_b) {
+        return false;
+    }
+    
+    move->n = 2;
+    move->task[0] = a;
+    move->from[0] = from_a;
+    move->task[1] = b;
+    move->from[1] = from_b;
+    remove_task(ls->timeline, ls->set, a);
+    remove_task(ls->timeline, ls->set, b);
+    if (!can_place_task(ls->timeline, ls->set, a, from_b)) {
+        place_task(ls->timeline, ls->set, a, from_a);
+        place_task(ls->timeline, ls->set, b, from_b);
+        return false;
+    }
+    place_task(ls->timeline, ls->set, a, from_b);
+    if (!can_place_task(ls->timeline, ls->set, b, from_a)) {
+        remove_task(ls->timeline, ls->set, a);
+        place_task(ls->timeline, ls->set, a, from_a);
+        place_task(ls->timeline, ls->set, b, from_b);
+        return false;
+    }
+    place_task(ls->timeline, ls->set, b, from_a);
+    *delta = ls_gain(ls, a, from_b) + ls_gain(ls, b, from_a) -
+             ls_gain(ls, a, from_a) - ls_gain(ls, b, from_b);
+    return true;
+}
+
+/* Place whichever unplaced tasks now fit; each one raises the objective */
+static void ls_fill_unplaced(LocalSearch* ls) {
+    for (int k = 0; k < ls->unplaced_count; k++) {
+        int t = ls->unplaced[k];
+        int slot = find_best_slot(ls->timeline, ls->set, t, ls->scores);
+        if (slot < 0) {
+            continue;
+        }
+        place_task(ls->timeline, ls->set, t, slot);
+        ls->value += ls_gain(ls, t, slot);
+        ls->movable[ls->movable_count++] = t;
+        ls->unplaced[k--] = ls->unplaced[--ls->unplaced_count];
+    }
+}
+
+/* Acceptance for a worsening move at the given temperature */
+static bool ls_accept(LocalSearch* ls, int64_t delta, double temperature) {
+    if (delta >= 0) {
+        return true;
+    }
+    double p = exp((double)delta / temperature);
+    return (double)ls_random(ls) < p * 4294967296.0;
+}
+
+/*
+ * Improve the assignment in set/timeline for up to options->improve_iterations
+ * moves and options->improve_time_us microseconds (either may be 0 for no
+ * limit, not both). Improvements go to shared, and a proven shared best
+ * ends the walk. Leaves the solve untouched if scratch memory runs out.
+ */
+static void local_search_improve(WeeklyTimeline* timeline, TaskSet* set, const ScoreTable* scores,
+                                 const SolveOptions* options, SharedIncumbent* shared, uint32_t seed,
+                                 Arena* arena) {
+    int count = set->count;
+    int64_t start_us = monotonic_us();
+    ArenaMark mark = arena_mark(arena);
+    int* scratch = (int*)scratch_alloc(arena, sizeof(int) * 3 * (count + 1));
+    if (!scratch) {
+        return;
+    }
+    
+    LocalSearch ls = {
+        .timeline = timeline,
+        .set = set,
+        .scores = scores,
+        .movable = scratch,
+        .unplaced = scratch + (count + 1),
+        .best_slots = scratch + 2 * (count + 1),
+        .rng = (seed ^ (uint32_t)count) ? seed ^ (uint32_t)count : LS_SEED
+    };
+    for (int t = 0; t < count; t++) {
+        if (is_force_placed(set, t, timeline->slot_count)) {
+            continue;
+        }
+        if (set->assigned[t] >= 0) {
+            ls.movable[ls.movable_count++] = t;
+            ls.value += ls_gain(&ls, t, set->assigned[t]);
+        } else {
+            ls.unplaced[ls.unplaced_count++] = t;
+        }
+    }
+    ls.best_value = ls.value;
+    memcpy(ls.best_slots, set->assigned, sizeof(int) * count);
+    share_incumbent(shared, ls.value);
+    
+    int64_t iterations = options->improve_iterations;
+    int64_t budget_us = options->improve_time_us;
+    double cooling = log(LS_TEMP_END / LS_TEMP_START);
+    double temperature = LS_TEMP_START;
+    
+    for (int64_t it = 0; ls.movable_count > 0 && (iterations <= 0 || it < iterations); it++) {
+        /* Geometric cooling over whichever budget is further along */
+        if (it % LS_CLOCK_INTERVAL == 0) {
+            if (incumbent_proven(shared) ||
+                control_poll(ENGINE_PHASE_LOCAL_SEARCH, it, (int)(ls.best_value / BNB_W_PLACED))) {
+                break;
+            }
+            double progress = iterations > 0 ? (double)it / (double)iterations : 0.0;
+            if (budget_us > 0) {
+                int64_t elapsed = monotonic_us() - start_us;
+                if (elapsed >= budget_us) {
+                    break;
+                }
+                double used = (double)elapsed / (double)budget_us;
+                progress = used > progress ? used : progress;
+            }
+            temperature = LS_TEMP_START * exp(cooling * progress);
+        }
+        
+        /* 50% shift, 30% relocate, 20% swap */
+        LocalMove move;
+        int64_t delta = 0;
+        uint32_t kind = ls_random(&ls) % 10;
+        bool moved = kind < 5 ? ls_shift(&ls, &move, &delta)
+                   : kind < 8 ? ls_relocate(&ls, &move, &delta)
+                              : ls_swap(&ls, &move, &delta);
+        if (!moved) {
+            continue;
+        }
+        if (!ls_accept(&ls, delta, temperature)) {
+            ls_undo(&ls, &move);
+            continue;
+        }
+        
+        ls.value += delta;
+        if (ls.unplaced_count > 0) {
+            ls_fill_unplaced(&ls);
+        }
+        if (ls.value > ls.best_value) {
+            ls.best_value = ls.value;
+            memcpy(ls.best_slots, set->assigned, sizeof(int) * count);
+            share_incumbent(shared, ls.value);
+        }
+    }
+    
+    /* Go back to the best assignment (never below the start) if the walk ended below it */
+    if (ls.value != ls.best_value) {
+        for (int t = 0; t < count; t++) {
+            if (!is_force_placed(set, t, timeline->slot_count) && set->assigned[t] >= 0) {
+                remove_task(timeline, set, t);
+            }
+        }
+        for (int t = 0; t < count; t++) {
+            if (!is_force_placed(set, t, timeline->slot_count) && ls.best_slots[t] >= 0) {
+                place_task(timeline, set, t, ls.best_slots[t]);
+            }
+        }
+    }
+    
+    int placed = 0;
+    for (int t = 0; t < count; t++) {
+        placed += set->assigned[t] >= 0;
+    }
+    timeline->total_gaps_filled = placed;
+    timeline->total_conflicts = count - placed;
+    
+    if (arena) {
+        arena_rewind(arena, mark);
+    } else {
+        free(scratch);
+    }
+}
+
+/* ============================================
+ * THREAD POOL
+ * ============================================ */
+
+/* Pool shared by batch and portfolio calls; g_pool_lock is held for a whole call */
+static pthread_mutex_t g_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static ThreadPool* g_pool = NULL;
+static int g_thread_setting = 0;       /* 0 = one thread per CPU */
+
+/* Create the pool on first use; caller holds g_pool_lock */
+static ThreadPool* acquire_pool(void) {
+    if (!g_pool) {
+        g_pool = pool_create(g_thread_setting > 0 ? g_thread_setting : pool_cpu_count());
+    }
+    return g_pool;
+}
+
+/* ============================================
+ * PORTFOLIO SEARCH
+ * ============================================ */
+
+/*
+ * A single solve with threads to spare runs a different task order and
+ * search on each pool thread. Every worker starts from a copy of the same
+ * pre-placed timeline and they all share one best value. Branch and bound
+ * prunes against that value, so a worker that finds a good assignment
+ * speeds up the others. A search that finishes proves the shared best
+ * optimal and stops the rest. The objective does not depend on the order,
+ * so the results compare directly.
+ */
+#define PORTFOLIO_MOVES 20000      /* Local-search moves when no budget is given */
+
+typedef enum {
+    ORDER_PRIORITY = 0,            /* As built: priority, then deadline */
+    ORDER_DEADLINE = 1,            /* Earliest deadline first */
+    ORDER_MRV = 2,                 /* Fewest valid starts on the pre-placed week first */
+    ORDER_SHORTEST = 3             /* Shortest first, for weeks of micro-gaps */
+} TaskOrder;
+
+typedef struct {
+    const char* name;
+    int order;                     /* TaskOrder */
+    int search_mode;               /* SEARCH_BRANCH_AND_BOUND, or SEARCH_GREEDY plus local search */
+} PortfolioStrategy;
+
+/* In launch order: with n threads the first n run */
+static const PortfolioStrategy g_portfolio[] = {
+    { "priority/branch_and_bound", ORDER_PRIORITY, SEARCH_BRANCH_AND_BOUND },
+    { "deadline/local_search",     ORDER_DEADLINE, SEARCH_GREEDY },
+    { "mrv/branch_and_bound",      ORDER_MRV,      SEARCH_BRANCH_AND_BOUND },
+    { "shortest/local_search",     ORDER_SHORTEST, SEARCH_GREEDY },
+    { "priority/local_search",     ORDER_PRIORITY, SEARCH_GREEDY },
+    { "deadline/branch_and_bound", ORDER_DEADLINE, SEARCH_BRANCH_AND_BOUND },
+    { "mrv/local_search",          ORDER_MRV,      SEARCH_GREEDY },
+    { "shortest/branch_and_bound", ORDER_SHORTEST, SEARCH_BRANCH_AND_BOUND }
+};
+
+#define PORTFOLIO_SIZE ((int)(sizeof(g_portfolio) / sizeof(g_portfolio[0])))
+
+typedef struct {
+    int locked;
+    int primary;                   /* Order-specific key, ascending */
+    int priority;
+    int deadline;
+    int index;                     /* Position in the priority-ordered set */
+} OrderKey;
+
+/* Locked first, then the order's key, then as compare_task_keys */
+static int compare_order_keys(const void* a, const void* b) {
+    const OrderKey* ka = (const OrderKey*)a;
+    const OrderKey* kb = (const OrderKey*)b;
+    
+    if (ka->locked != kb->locked) {
+        return ka->locked ? -1 : 1;
+    }
+    if (ka->primary != kb->primary) {
+        return ka->primary < kb->primary ? -1 : 1;
+    }
+    if (ka->priority != kb->priority) {
+        return ka->priority > kb->priority ? -1 : 1;
+    }
+    if (ka->deadline != kb->deadline) {
+        return ka->deadline < kb->deadline ? -1 : 1;
+    }
+    return (ka->index > kb->index) - (ka->index < kb->index);
+}
+
+/* Fill to (already bound) with the entries of from in the given order */
+static void task_set_order(TaskSet* to, const TaskSet* from, int order, WeeklyTimeline* base,
+                           OrderKey* keys) {
+    uint64_t starts[OCC_WORDS];
+    int count = from->count;
+    
+    for (int i = 0; i < count; i++) {
+        int primary = 0;
+        if (order == ORDER_DEADLINE) {
+            primary = from->deadline[i];
+        } else if (order == ORDER_SHORTEST) {
+            primary = from->duration[i];
+        } else if (order == ORDER_MRV) {
+            task_valid_starts(base, from, i, starts);
+            primary = occ_count(starts, base->occ_words);
+        }
+        OrderKey key = { from->locked[i], primary, from->priority[i], from->deadline[i], i };
+        keys[i] = key;
+    }
+    qsort(keys, count, sizeof(OrderKey), compare_order_keys);
+    
+    to->count = count;
+    for (int i = 0; i < count; i++) {
+        task_set_copy_entry(to, i, from, keys[i].index);
+    }
+}
+
+/* Shared by the workers of one portfolio solve */
+typedef struct {
+    const WeeklyTimeline* base;    /* Reset, with locked tasks force-placed */
+    const TaskSet* set;            /* Priority order, as built */
+    const ScoreTable* scores;
+    SolveOptions search;           /* Budget of the branch-and-bound workers */
+    SolveOptions local;            /* Budget of the local-search workers */
+    SharedIncumbent shared;
+    WeeklyTimeline* timelines;     /* One per worker */
+    TaskSet* sets;
+    OrderKey* keys;                /* set->count per worker */
+    int64_t* values;               /* Objective each worker ended with */
+    EngineStats stats;             /* Counted by the workers, for the solving thread */
+    const SolveControl* control;   /* The solving thread's, or NULL */
+} PortfolioJob;
+
+/* Pool job: run strategy k on its own copy of the week */
+static void portfolio_worker(void* raw, int k, int worker) {
+    PortfolioJob* job = (PortfolioJob*)raw;
+    const PortfolioStrategy* strategy = &g_portfolio[k];
+    WeeklyTimeline* timeline = &job->timelines[k];
+    TaskSet* set = &job->sets[k];
+    STAT_SNAPSHOT(before);
+    
+    /* Worker 0 is the solving thread, which already polls the control */
+    SolveControl* saved = g_control;
+    SolveControl copy;
+    if (worker != 0 && job->control) {
+        control_worker_copy(&copy, job->control);
+        g_control = &copy;
+    }
+    
+    timeline_copy(timeline, job->base);
+    task_set_order(set, job->set, strategy->order, timeline, job->keys + (size_t)k * job->set->count);
+    
+    /* Scratch comes from the heap: the caller's arena is not thread-safe */
+    if (strategy->search_mode == SEARCH_BRANCH_AND_BOUND) {
+        branch_and_bound_solve(timeline, set, job->scores, &job->search, NULL, &job->shared);
+    } else {
+        greedy_solve(timeline, set, job->scores, NULL);
+        local_search_improve(timeline, set, job->scores, &job->local, &job->shared,
+                             LS_SEED + (uint32_t)k * 0x01000193u, NULL);
+    }
+    job->values[k] = set_objective(set, job->scores, timeline->slot_count);
+    g_control = saved;
+    STAT_HAND_OVER(&job->stats, before);
+}
+
+/*
+ * Race the first n portfolio strategies, n being the pool's thread count,
+ * and keep the best result (the earliest strategy on ties). Its index
+ * goes to timeline->solve_strategy. With one thread, with the pool busy
+ * in another call or without memory, only the first strategy runs.
+ * Returns false if the budget ran out before any search finished.
+ */
+static bool portfolio_solve(WeeklyTimeline* timeline, TaskSet* set, const ScoreTable* scores,
+                            const SolveOptions* options, Arena* arena) {
+    int count = set->count;
+    SolveOptions search = {
+        .search_mode = SEARCH_BRANCH_AND_BOUND,
+        .time_limit_ms = options->time_limit_ms,
+        .node_limit = options->node_limit
+    };
+    SolveOptions local = {
+        .search_mode = SEARCH_GREEDY,
+        .improve_iterations = options->improve_iterations,
+        .improve_time_us = options->improve_time_us
+    };
+    if (local.improve_iterations <= 0 && local.improve_time_us <= 0) {
+        if (options->time_limit_ms > 0) {
+            local.improve_time_us = (int64_t)options->time_limit_ms * 1000;
+        } else {
+            local.improve_iterations = PORTFOLIO_MOVES;
+        }
+    }
+    
+    bool pool_held = pthread_mutex_trylock(&g_pool_lock) == 0;
+    ThreadPool* pool = pool_held ? acquire_pool() : NULL;
+    int n = pool_thread_count(pool);
+    n = n < PORTFOLIO_SIZE ? n : PORTFOLIO_SIZE;
+    
+    ArenaMark mark = arena_mark(arena);
+    size_t set_stride = (task_set_bytes(count) + 7) & ~(size_t)7;
+    WeeklyTimeline* timelines = NULL;
+    TaskSet* sets = NULL;
+    char* blocks = NULL;
+    OrderKey* keys = NULL;
+    int64_t* values = NULL;
+    if (n > 1) {
+        timelines = timeline_alloc(arena, n, timeline->slot_count);
+        sets = (TaskSet*)scratch_alloc(arena, sizeof(TaskSet) * n);
+        blocks = (char*)scratch_alloc(arena, set_stride * n);
+        keys = (OrderKey*)scratch_alloc(arena, sizeof(OrderKey) * (size_t)n * (count + 1));
+        values = (int64_t*)scratch_alloc(arena, sizeof(int64_t) * n);
+    }
+    
+    bool complete;
+    if (n <= 1 || !timelines || !sets || !blocks || !keys || !values) {
+        if (pool_held) {
+            pthread_mutex_unlock(&g_pool_lock);
+        }
+        complete = branch_and_bound_solve(timeline, set, scores, &search, arena, NULL);
+        timeline->solve_strategy = 0;
+    } else {
+        PortfolioJob job = {
+            .base = timeline,
+            .set = set,
+            .scores = scores,
+            .search = search,
+            .local = local,
+            .shared = { INT64_MIN, 0 },
+            .timelines = timelines,
+            .sets = sets,
+            .keys = keys,
+            .values = values,
+            .stats = { 0 },
+            .control = g_control
+        };
+        for (int k = 0; k < n; k++) {
+            task_set_bind(&sets[k], blocks + set_stride * k, count);
+        }
+        pool_run(pool, n, portfolio_worker, &job);
+        pthread_mutex_unlock(&g_pool_lock);
+        stats_add(&g_solve_stats, &job.stats);
+        
+        int winner = 0;
+        for (int k = 1; k < n; k++) {
+            if (values[k] > values[winner]) {
+                winner = k;
+            }
+        }
+        
+        /* The winner's set is in its own order; map back through source */
+        int* by_source = (int*)keys;
+        const TaskSet* best = &sets[winner];
+        for (int i = 0; i < count; i++) {
+            by_source[best->source[i]] = best->assigned[i];
+        }
+        for (int i = 0; i < count; i++) {
+            set->assigned[i] = by_source[set->source[i]];
+        }
+        timeline_copy(timeline, &timelines[winner]);
+        timeline->solve_strategy = winner;
+        complete = job.shared.proven != 0;
+    }
+    
+    if (arena) {
+        arena_rewind(arena, mark);
+    } else {
+        free(timelines); free(sets); free(blocks); free(keys); free(values);
+    }
+    return complete;
+}
+
+/* ============================================
+ * FEASIBILITY CHECK
+ * ============================================ */
+
+/*
+ * A necessary condition for placing every task, in O(n log n) after one
+ * pass over the slots. In deadline order, the tasks due by each deadline d
+ * must fit in the free slots before d: awake slots for most tasks, any
+ * free slot for sleep tasks (checked on their own). A task with no free
+ * run long enough before its deadline is dropped outright. On overflow the
+ * longest task admitted so far goes (Moore-Hodgson, lowest priority on
+ * ties), which drops the fewest tasks the relaxation allows, so no search
+ * can place more than count - drop_count of them. By priority, the
+ * lowest-priority task admitted so far goes instead (longest on ties): more
+ * drops, but the ones a priority-ordered solve would give up first.
+ */
+
+typedef struct {
+    int deadline;              /* Clamped to the horizon */
+    int index;                 /* Set index */
+} DeadlineKey;
+
+/* Binary max-heap of set indices in drop order */
+typedef struct {
+    int* items;
+    int count;
+    int64_t demand;            /* Total duration of the tasks held */
+    bool by_priority;          /* Drop lowest priority first, not longest */
+} DropHeap;
+
+static int compare_deadline_keys(const void* a, const void* b) {
+    const DeadlineKey* ka = (const DeadlineKey*)a;
+    const DeadlineKey* kb = (const DeadlineKey*)b;
+    
+    if (ka->deadline != kb->deadline) {
+        return ka->deadline < kb->deadline ? -1 : 1;
+    }
+    return (ka->index > kb->index) - (ka->index < kb->index);
+}
+
+/* Drop order: longer first, then lower priority (the other way round by
+ * priority), then later in set order */
+static bool drops_before(const DropHeap* heap, const TaskSet* set, int a, int b) {
+    if (heap->by_priority && set->priority[a] != set->priority[b]) {
+        return set->priority[a] < set->priority[b];
+    }
+    if (set->duration[a] != set->duration[b]) {
+        return set->duration[a] > set->duration[b];
+    }
+    if (set->priority[a] != set->priority[b]) {
+        return set->priority[a] < set->priority[b];
+    }
+    return a > b;
+}
+
+static void drop_heap_push(DropHeap* heap, const TaskSet* set, int t) {
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!drops_before(heap, set, t, heap->items[parent])) {
+            break;
+        }
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = t;
+    heap->demand += set->duration[t];
+}
+
+static int drop_heap_pop(DropHeap* heap, const TaskSet* set) {
+    int top = heap->items[0];
+    int last = heap->items[--heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) {
+            break;
+        }
+        if (child + 1 < heap->count && drops_before(heap, set, heap->items[child + 1], heap->items[child])) {
+            child++;
+        }
+        if (!drops_before(heap, set, heap->items[child], last)) {
+            break;
+        }
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) {
+        heap->items[i] = last;
+    }
+    heap->demand -= set->duration[top];
+    return top;
+}
+
+/*
+ * Cheap gate for the check inside a solve: more slots wanted than the
+ * awake free time holds. Weeks that pass it rarely lose half their tasks,
+ * and skipping the check there keeps it off the common path.
+ */
+static bool over_capacity(const WeeklyTimeline* timeline, const TaskSet* set) {
+    int64_t demand = 0;
+    for (int i = 0; i < set->count; i++) {
+        if (set->duration[i] > 0 && !is_force_placed(set, i, timeline->slot_count)) {
+            demand += set->duration[i];
+        }
+    }
+    int64_t capacity = 0;
+    for (int w = 0; w < timeline->occ_words; w++) {
+        capacity += OCC_POPCOUNT(timeline->free_mask[w] & ~timeline->sleep_mask[w]);
+    }
+    return demand > capacity;
+}
+
+/*
+ * Check a set against a timeline holding only its force-placed tasks.
+ * The ids of dropped tasks go to drop_ids, up to max_drop of them, and
+ * dropped[i] is set for each dropped entry; report and dropped may be
+ * NULL. by_priority picks the drop order described above. Returns the
+ * drop count, or -1 if scratch memory runs out.
+ */
+static int feasibility_check(WeeklyTimeline* timeline, const TaskSet* set, FeasibilityReport* report,
+                             int* drop_ids, int max_drop, bool* dropped, bool by_priority, Arena* arena) {
+    int count = set->count;
+    int slot_count = timeline->slot_count;
+    int words = timeline->occ_words;
+    size_t n = (size_t)(count > 0 ? count : 1);
+    ArenaMark mark = arena_mark(arena);
+    
+    DeadlineKey* keys = (DeadlineKey*)scratch_alloc(arena, sizeof(DeadlineKey) * n);
+    int* heap_items = (int*)scratch_alloc(arena, sizeof(int) * 2 * n);
+    int* awake = (int*)scratch_alloc(arena, sizeof(int) * 4 * (size_t)(slot_count + 1));
+    if (!keys || !heap_items || !awake) {
+        if (arena) {
+            arena_rewind(arena, mark);
+        } else {
+            free(keys); free(heap_items); free(awake);
+        }
+        return -1;
+    }
+    
+    /* Free slots before each slot, awake ones and any (for sleep tasks),
+     * and the longest free run before it of each kind */
+    int* any = awake + slot_count + 1;
+    int* awake_run = any + slot_count + 1;
+    int* any_run = awake_run + slot_count + 1;
+    int awake_len = 0;
+    int any_len = 0;
+    awake[0] = any[0] = awake_run[0] = any_run[0] = 0;
+    for (int slot = 0; slot < slot_count; slot++) {
+        bool open = occ_test_bit(timeline->free_mask, slot, words);
+        bool up = open && !occ_test_bit(timeline->sleep_mask, slot, words);
+        any_len = open ? any_len + 1 : 0;
+        awake_len = up ? awake_len + 1 : 0;
+        any[slot + 1] = any[slot] + open;
+        awake[slot + 1] = awake[slot] + up;
+        any_run[slot + 1] = any_len > any_run[slot] ? any_len : any_run[slot];
+        awake_run[slot + 1] = awake_len > awake_run[slot] ? awake_len : awake_run[slot];
+    }
+    
+    FeasibilityReport rep = { 0, 0, awake[slot_count], 0, -1, 0 };
+    int drops = 0;
+    int keyed = 0;
+    for (int i = 0; i < count; i++) {
+        if (is_force_placed(set, i, slot_count) || set->duration[i] <= 0) {
+            continue;
+        }
+        int deadline = set->deadline[i] < slot_count ? set->deadline[i] : slot_count;
+        const int* longest = set->category[i] == TASK_SLEEP ? any_run : awake_run;
+        rep.demand_slots += set->duration[i];
+        if (longest[deadline] < set->duration[i]) {
+            /* Cannot fit even on its own */
+            if (drops < max_drop && drop_ids) {
+                drop_ids[drops] = set->id[i];
+            }
+            if (dropped) {
+                dropped[i] = true;
+            }
+            drops++;
+            continue;
+        }
+        DeadlineKey key = { deadline, i };
+        keys[keyed++] = key;
+    }
+    qsort(keys, (size_t)keyed, sizeof(DeadlineKey), compare_deadline_keys);
+    
+    DropHeap heaps[2] = { { heap_items, 0, 0, by_priority }, { heap_items + n, 0, 0, by_priority } };
+    int64_t raw[2] = { 0, 0 };
+    for (int k = 0; k < keyed; k++) {
+        int t = keys[k].index;
+        int d = keys[k].deadline;
+        int kind = set->category[t] == TASK_SLEEP;
+        const int* capacity = kind ? any : awake;
+        DropHeap* heap = &heaps[kind];
+        
+        raw[kind] += set->duration[t];
+        if (raw[kind] - capacity[d] > rep.shortfall_slots) {
+            rep.shortfall_slots = (int)(raw[kind] - capacity[d]);
+        }
+        drop_heap_push(heap, set, t);
+        if (heap->demand > capacity[d] && rep.first_overflow_slot < 0) {
+            rep.first_overflow_slot = d;
+        }
+        while (heap->demand > capacity[d]) {
+            int out = drop_heap_pop(heap, set);
+            if (drops < max_drop && drop_ids) {
+                drop_ids[drops] = set->id[out];
+            }
+            if (dropped) {
+                dropped[out] = true;
+            }
+            drops++;
+        }
+    }
+    
+    rep.drop_count = drops;
+    rep.feasible = drops == 0;
+    if (report) {
+        *report = rep;
+    }
+    if (arena) {
+        arena_rewind(arena, mark);
+    } else {
+        free(keys); free(heap_items); free(awake);
+    }
+    return drops;
+}
+
+/* ============================================
+ * RESULT CACHE
+ * ============================================ */
+
+/*
+ * Solved results keyed by a 128-bit hash over everything the solver reads:
+ * each task's placement fields in input order (titles and subjects are
+ * never read, so they are left out), the config with its defaults filled
+ * in, and the search options. A repeat solve copies the slot grid and
+ * the assigned slots back instead of solving. Shared by every thread
+ * under one lock; least recently used entries are replaced.
+ */
+#define RESULT_CACHE_DEFAULT 64
+#define RESULT_CACHE_MAX 1024
+
+typedef struct {
+    uint64_t key[2];
+    bool valid;
+    unsigned long last_used;
+    int task_count;
+    int slot_count;
+    int slots_per_day;
+    int occ_words;
+    int status;
+    int error_code;
+    int gaps_filled;
+    int conflicts;
+    int strategy;
+    uint64_t* masks;               /* occ_words free_mask words, then sleep_mask (owns data too) */
+    int* data;                     /* After the masks: slot_count slots, then task_count assigned slots */
+} ResultCacheEntry;
+
+static pthread_mutex_t g_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static ResultCacheEntry* g_cache = NULL;
+static int g_cache_capacity = RESULT_CACHE_DEFAULT;
+static unsigned long g_cache_clock = 0;
+static EngineCacheStats g_cache_stats = { 0, 0, 0, 0, 0 };
+
+/* Two multiply-xorshift lanes with different constants */
+static void hash_word(uint64_t* h, uint64_t v) {
+    h[0] = (h[0] ^ v) * 0x9e3779b97f4a7c15ULL;
+    h[0] ^= h[0] >> 32;
+    h[1] = (h[1] + v) * 0xc2b2ae3d27d4eb4fULL;
+    h[1] ^= h[1] >> 29;
+}
+
+static uint64_t hash_pair(int a, int b) {
+    return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+}
+
+/* splitmix64 finalizer, so that nearby inputs spread over the whole key */
+static uint64_t hash_finish(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/* cfg must already be resolved (not NULL); options may be NULL (greedy) */
+static void result_cache_key(const TimelineTask* tasks, int count, const OptimizationConfig* cfg,
+                             const SolveOptions* options, const uint64_t* base_key, uint64_t* key) {
+    SlotGrid grid = { 0, 0, 0 };           /* Stays zero if unsupported */
+    grid_from_config(cfg, &grid);
+    uint64_t h[2] = { 0x243f6a8885a308d3ULL, 0x13198a2e03707344ULL };
+    
+    hash_word(h, hash_pair(count, grid.slot_count));
+    hash_word(h, hash_pair(grid.slots_per_day, cfg->enable_heuristics ? 1 : 0));
+    hash_word(h, hash_pair(cfg->sleep_start_slot, cfg->sleep_end_slot));
+    hash_word(h, hash_pair(cfg->concept_peak_start, cfg->concept_peak_end));
+    hash_word(h, hash_pair(cfg->practice_peak_start, cfg->practice_peak_end));
+    hash_word(h, hash_pair(cfg->deep_work_min_slots, cfg->micro_gap_max_slots));
+    if (options) {
+        hash_word(h, hash_pair(options->search_mode + 1, options->time_limit_ms));
+        hash_word(h, (uint64_t)options->node_limit);
+        hash_word(h, (uint64_t)options->improve_iterations);
+        hash_word(h, (uint64_t)options->improve_time_us);
+    } else {
+        hash_word(h, 0);
+    }
+    if (base_key) {
+        hash_word(h, base_key[0]);
+        hash_word(h, base_key[1]);
+    }
+    
+    for (int i = 0; i < count; i++) {
+        const TimelineTask* t = &tasks[i];
+        hash_word(h, hash_pair(t->id, t->duration_slots));
+        hash_word(h, hash_pair(t->priority, t->category));
+        hash_word(h, hash_pair(t->deadline_slot, t->preferred_slot));
+        hash_word(h, t->is_locked ? 1 : 0);
+    }
+    
+    key[0] = hash_finish(h[0]);
+    key[1] = hash_finish(h[1] ^ key[0]);
+}
+
+static ResultCacheEntry* result_cache_find(const uint64_t* key, int count) {
+    for (int i = 0; g_cache && i < g_cache_capacity; i++) {
+        ResultCacheEntry* e = &g_cache[i];
+        if (e->valid && e->key[0] == key[0] && e->key[1] == key[1] && e->task_count == count) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Fill timeline (and result's assigned slots) from a cached solve; false on a miss */
+static bool result_cache_lookup(const uint64_t* key, WeeklyTimeline* timeline, TimelineTask* result,
+                                int count) {
+    pthread_mutex_lock(&g_cache_lock);
+    ResultCacheEntry* e = result_cache_find(key, count);
+    if (!e) {
+        g_cache_stats.misses++;
+        pthread_mutex_unlock(&g_cache_lock);
+        return false;
+    }
+    
+    g_cache_stats.hits++;
+    e->last_used = ++g_cache_clock;
+    memcpy(timeline->slots, e->data, sizeof(int) * e->slot_count);
+    memcpy(timeline->free_mask, e->masks, sizeof(uint64_t) * e->occ_words);
+    memcpy(timeline->sleep_mask, e->masks + e->occ_words, sizeof(uint64_t) * e->occ_words);
+    timeline->slot_count = e->slot_count;
+    timeline->slots_per_day = e->slots_per_day;
+    timeline->occ_words = e->occ_words;
+    timeline->task_count = count;
+    timeline->optimization_status = e->status;
+    timeline->error_code = e->error_code;
+    timeline->total_gaps_filled = e->gaps_filled;
+    timeline->total_conflicts = e->conflicts;
+    timeline->solve_strategy = e->strategy;
+    timeline->tasks = result;
+    for (int i = 0; result && i < count; i++) {
+        result[i].assigned_slot = e->data[e->slot_count + i];
+    }
+    pthread_mutex_unlock(&g_cache_lock);
+    return true;
+}
+
+/* Remember a solve; skipped if the cache is off or memory runs out */
+static void result_cache_store(const uint64_t* key, const WeeklyTimeline* timeline, const TaskSet* set) {
+    int count = set->count;
+    int slots = timeline->slot_count;
+    int words = timeline->occ_words;
+    
+    /* Copied outside the lock; assigned slots go back into input order */
+    uint64_t* masks = (uint64_t*)malloc(sizeof(uint64_t) * 2 * (size_t)words +
+                                        sizeof(int) * (size_t)(slots + count + 1));
+    if (!masks) {
+        return;
+    }
+    int* data = (int*)(masks + 2 * words);
+    memcpy(masks, timeline->free_mask, sizeof(uint64_t) * words);
+    memcpy(masks + words, timeline->sleep_mask, sizeof(uint64_t) * words);
+    memcpy(data, timeline->slots, sizeof(int) * slots);
+    for (int i = 0; i < count; i++) {
+        data[slots + set->source[i]] = set->assigned[i];
+    }
+    
+    pthread_mutex_lock(&g_cache_lock);
+    if (!g_cache && g_cache_capacity > 0) {
+        g_cache = (ResultCacheEntry*)calloc(g_cache_capacity, sizeof(ResultCacheEntry));
+    }
+    ResultCacheEntry* e = g_cache ? result_cache_find(key, count) : NULL;
+    for (int i = 0; g_cache && !e && i < g_cache_capacity; i++) {
+        if (!g_cache[i].valid) {
+            e = &g_cache[i];
+        }
+    }
+    if (g_cache && !e) {
+        /* Full: replace the least recently used entry */
+        e = &g_cache[0];
+        for (int i = 1; i < g_cache_capacity; i++) {
+            if (g_cache[i].last_used < e->last_used) {
+                e = &g_cache[i];
+            }
+        }
+        g_cache_stats.evictions++;
+    }
+    if (!e) {
+        pthread_mutex_unlock(&g_cache_lock);
+        free(masks);
+        return;
+    }
+    
+    free(e->masks);
+    e->key[0] = key[0];
+    e->key[1] = key[1];
+    e->valid = true;
+    e->last_used = ++g_cache_clock;
+    e->task_count = count;
+    e->slot_count = slots;
+    e->slots_per_day = timeline->slots_per_day;
+    e->occ_words = timeline->occ_words;
+    e->status = timeline->optimization_status;
+    e->error_code = timeline->error_code;
+    e->gaps_filled = timeline->total_gaps_filled;
+    e->conflicts = timeline->total_conflicts;
+    e->strategy = timeline->solve_strategy;
+    e->masks = masks;
+    e->data = data;
+    pthread_mutex_unlock(&g_cache_lock);
+}
+
+/* Drop every entry; caller holds g_cache_lock */
+static void result_cache_clear(void) {
+    for (int i = 0; g_cache && i < g_cache_capacity; i++) {
+        free(g_cache[i].masks);
+        g_cache[i].masks = NULL;
+        g_cache[i].data = NULL;
+        g_cache[i].valid = false;
+    }
+}
+
+static bool result_cache_enabled(void) {
+    pthread_mutex_lock(&g_cache_lock);
+    bool enabled = g_cache_capacity > 0;
+    pthread_mutex_unlock(&g_cache_lock);
+    return enabled;
+}
+
+/*
+ * Resize the result cache to hold capacity solves (0 turns it off,
+ * at most RESULT_CACHE_MAX). Cached results are dropped; the counters
+ * are kept. Returns the capacity now in use.
+ */
+EXPORT int engine_cache_configure(int capacity) {
+    capacity = capacity < 0 ? 0 : capacity > RESULT_CACHE_MAX ? RESULT_CACHE_MAX : capacity;
+    
+    pthread_mutex_lock(&g_cache_lock);
+    result_cache_clear();
+    free(g_cache);
+    g_cache = NULL;
+    g_cache_capacity = capacity;
+    pthread_mutex_unlock(&g_cache_lock);
+    return capacity;
+}
+
+/* Forget every cached result, e.g. after a change the key cannot see */
+EXPORT void engine_cache_invalidate(void) {
+    pthread_mutex_lock(&g_cache_lock);
+    result_cache_clear();
+    pthread_mutex_unlock(&g_cache_lock);
+}
+
+EXPORT void engine_cache_stats(EngineCacheStats* out) {
+    if (!out) {
+        return;
+    }
+    pthread_mutex_lock(&g_cache_lock);
+    *out = g_cache_stats;
+    out->entries = 0;
+    for (int i = 0; g_cache && i < g_cache_capacity; i++) {
+        out->entries += g_cache[i].valid;
+    }
+    out->capacity = g_cache_capacity;
+    pthread_mutex_unlock(&g_cache_lock);
+}
+
+/* ============================================
+ * SOLVE DRIVER
+ * ============================================ */
+
+/* Default configuration used when the caller passes NULL */
+static const OptimizationConfig DEFAULT_CONFIG = {
+    .sleep_start_slot = 46,      /* 23:00 */
+    .sleep_end_slot = 12,        /* 06:00 */
+    .concept_peak_start = 16,    /* 08:00 */
+    .concept_peak_end = 24,      /* 12:00 */
+    .practice_peak_start = 32,   /* 16:00 */
+    .practice_peak_end = 40,     /* 20:00 */
+    .deep_work_min_slots = 3,    /* 90 min */
+    .micro_gap_max_slots = 1,    /* 30 min */
+    .enable_heuristics = true,
+    .horizon_weeks = 1,
+    .slot_minutes = 30
+};
+
+/* Geometry of the most recent solve on this thread (get_week_slots) */
+static THREAD_LOCAL SlotGrid g_active_grid = { SLOTS_PER_DAY, WEEK_SLOTS, (WEEK_SLOTS + 63) / 64 };
+
+/*
+ * Shared starting point for solves (see timeline_base_create): the config,
+ * its grid and a timeline with the sleep window blocked and the classes
+ * placed. Never written after creation, so any number of threads can
+ * solve on one base at once.
+ */
+struct TimelineBase {
+    OptimizationConfig config;
+    SlotGrid grid;
+    uint64_t key[2];           /* Cache key of the classes and config */
+    int forced;                /* Classes placed, counted by a solve's thresholds */
+    WeeklyTimeline timeline;   /* No tasks array; slots hold the class ids (stored after the base) */
+};
+
+/* Slots a solve's timeline needs: its grid's, or a default week's if the grid is unsupported */
+static int solve_slot_count(const OptimizationConfig* config, const TimelineBase* base) {
+    SlotGrid grid;
+    if (base) {
+        return base->grid.slot_count;
+    }
+    return grid_from_config(config ? config : &DEFAULT_CONFIG, &grid) ? grid.slot_count : WEEK_SLOTS;
+}
+
+/* Empty every slot of the grid and block the sleep window */
+static void timeline_reset(WeeklyTimeline* timeline, const OptimizationConfig* cfg, const SlotGrid* grid) {
+    for (int i = 0; i < grid->slot_count; i++) {
+        timeline->slots[i] = EMPTY_SLOT;
+    }
+    occ_clear_all(timeline->free_mask, grid->words);
+    occ_set_range(timeline->free_mask, 0, grid->slot_count);
+    
+    timeline->slot_count = grid->slot_count;
+    timeline->slots_per_day = grid->slots_per_day;
+    timeline->occ_words = grid->words;
+    timeline->optimization_status = 0;
+    timeline->error_code = 0;
+    timeline->total_gaps_filled = 0;
+    timeline->total_conflicts = 0;
+    timeline->solve_strategy = -1;
+    
+    /* Mark sleep slots as blocked */
+    build_sleep_mask(timeline->sleep_mask, cfg, grid);
+    for (int slot = occ_next_set(timeline->sleep_mask, 0, grid->words); slot >= 0;
+         slot = occ_next_set(timeline->sleep_mask, slot + 1, grid->words)) {
+        mark_slots(timeline, slot, 1, BLOCKED_SLOT);
+    }
+}
+
+/* Start a solve from a base: copy only the slots and mask words in use */
+static void timeline_from_base(WeeklyTimeline* timeline, const TimelineBase* base) {
+    const WeeklyTimeline* from = &base->timeline;
+    memcpy(timeline->slots, from->slots, sizeof(int) * (size_t)from->slot_count);
+    memcpy(timeline->free_mask, from->free_mask, sizeof(uint64_t) * (size_t)from->occ_words);
+    memcpy(timeline->sleep_mask, from->sleep_mask, sizeof(uint64_t) * (size_t)from->occ_words);
+    
+    timeline->slot_count = from->slot_count;
+    timeline->slots_per_day = from->slots_per_day;
+    timeline->occ_words = from->occ_words;
+    timeline->optimization_status = 0;
+    timeline->error_code = 0;
+    timeline->total_gaps_filled = 0;
+    timeline->total_conflicts = 0;
+    timeline->solve_strategy = -1;
+}
+
+/* Clear every assignment and force-place the locked tasks. Returns how many were placed */
+static int place_locked_tasks(WeeklyTimeline* timeline, TaskSet* set) {
+    int forced = 0;
+    for (int i = 0; i < set->count; i++) {
+        set->assigned[i] = -1;
+        if (is_force_placed(set, i, timeline->slot_count)) {
+            place_task(timeline, set, i, set->preferred[i]);
+            forced++;
+        }
+    }
+    return forced;
+}
+
+/*
+ * Solve a task set into caller-provided timeline storage. Search scratch
+ * comes from arena when one is given (and is rewound before returning),
+ * from malloc otherwise. Returns false if memory runs out. An unsupported
+ * horizon or granularity leaves every task unplaced, with status -1 and
+ * error_code ENGINE_ERROR_GRID, on an empty default-sized week. When the
+ * tasks want more than the free time and the feasibility check alone shows
+ * that more than half of them cannot be placed, the search is skipped: the
+ * tasks a priority-ordered check admits are placed greedily (then improved
+ * by local search if asked for), with status -1 and error_code
+ * ENGINE_ERROR_CAPACITY. With a base, its
+ * config replaces config and the solve starts from its timeline; the
+ * classes it placed count in both "more than half" tests, so the result
+ * matches solving classes and tasks together from scratch. Once the
+ * thread's control trips, status is -2 with its EngineError. A search
+ * budget that runs out only gives status -2 while tasks are left
+ * unplaced: a conflict-free incumbent is a success.
+ */
+static bool solve_task_set(WeeklyTimeline* timeline, TaskSet* set, const OptimizationConfig* config,
+                           const TimelineBase* base, const SolveOptions* options, Arena* arena) {
+    /* Use default config if none provided */
+    const OptimizationConfig* cfg = base ? &base->config : config ? config : &DEFAULT_CONFIG;
+    int count = set->count;
+    int whole = count + (base ? base->forced : 0);  /* Tasks a from-scratch solve would see */
+    SlotGrid grid;
+    bool grid_ok = true;
+    STAT_CLOCK(lap);
+    
+    if (base) {
+        grid = base->grid;
+        timeline_from_base(timeline, base);
+    } else {
+        grid_ok = grid_from_config(cfg, &grid);
+        if (!grid_ok) {
+            grid_from_config(&DEFAULT_CONFIG, &grid);
+        }
+        timeline_reset(timeline, cfg, &grid);
+    }
+    STAT_LAP(sleep_us, lap);
+    timeline->task_count = count;
+    g_active_grid = grid;
+    
+    if (!grid_ok) {
+        for (int i = 0; i < count; i++) {
+            set->assigned[i] = -1;
+        }
+        timeline->total_conflicts = count;
+        timeline->optimization_status = -1;
+        timeline->error_code = ENGINE_ERROR_GRID;
+        return true;
+    }
+    
+    /* Place locked/fixed tasks first */
+    int forced = place_locked_tasks(timeline, set);
+    STAT_LAP(locked_us, lap);
+    if (g_control) {
+        g_control->forced = forced;
+    }
+    
+    /* Hopelessly over-committed: every search would end at status -1, so
+     * the fewest-drops verdict decides, and the tasks dropped lowest
+     * priority first are left out of a greedy pass */
+    bool* dropped = NULL;
+    if (over_capacity(timeline, set) &&
+        feasibility_check(timeline, set, NULL, NULL, 0, NULL, false, arena) > whole / 2) {
+        dropped = (bool*)scratch_calloc(arena, (size_t)(count > 0 ? count : 1), sizeof(bool));
+        if (!dropped || feasibility_check(timeline, set, NULL, NULL, 0, dropped, true, arena) < 0) {
+            if (!arena) {
+                free(dropped);
+            }
+            return false;
+        }
+    }
+    STAT_LAP(search_us, lap);
+    
+    /* Score tables are shared between solves with the same config */
+    const ScoreTable* scores = acquire_score_table(cfg, &grid);
+    ScoreTable* own = NULL;
+    if (!scores) {
+        own = (ScoreTable*)scratch_alloc(arena, sizeof(ScoreTable));
+        if (!own) {
+            if (!arena) {
+                free(dropped);
+            }
+            return false;
+        }
+        build_score_table(own, cfg, &grid);
+        scores = own;
+    }
+    STAT_LAP(setup_us, lap);
+    
+    /* Run the requested search on remaining tasks */
+    bool complete = true;
+    if (dropped) {
+        greedy_solve(timeline, set, scores, dropped);
+    } else if (options && options->search_mode == SEARCH_BRANCH_AND_BOUND) {
+        complete = branch_and_bound_solve(timeline, set, scores, options, arena, NULL);
+    } else if (options && options->search_mode == SEARCH_PORTFOLIO) {
+        complete = portfolio_solve(timeline, set, scores, options, arena);
+    } else {
+        greedy_solve(timeline, set, scores, NULL);
+    }
+    if (options && (dropped || options->search_mode != SEARCH_PORTFOLIO) &&
+        (options->improve_iterations > 0 || options->improve_time_us > 0)) {
+        local_search_improve(timeline, set, scores, options, NULL, LS_SEED, arena);
+    }
+    STAT_LAP(search_us, lap);
+    
+    bool capped = dropped != NULL;
+    if (!arena) {
+        free(dropped);
+        free(own);
+    }
+    if (!own) {
+        release_score_table(scores);
+    }
+    
+    int trip = control_tripped();
+    if (trip) {
+        timeline->optimization_status = -2; /* Stopped by the caller: best found so far */
+        timeline->error_code = trip;
+    } else if (capped) {
+        timeline->optimization_status = -1;
+        timeline->error_code = ENGINE_ERROR_CAPACITY;
+    } else if (!complete && timeline->total_conflicts > 0) {
+        timeline->optimization_status = -2; /* Budget ran out: best found so far */
+    } else if (timeline->total_conflicts > 0) {
+        /* Some tasks could not be placed */
+        if (timeline->total_conflicts > whole / 2) {
+            timeline->optimization_status = -1; /* Unsolvable */
+        } else {
+            timeline->optimization_status = 0;  /* Partial success */
+        }
+    }
+    return true;
+}
+
+/*
+ * Solve tasks[0 .. count) into caller-provided timeline storage. The
+ * input is only read and never reordered; each task's slot is written to
+ * result[i].assigned_slot, where result may alias tasks or be NULL to keep
+ * only the slot grid. timeline->tasks is set to result. base may be NULL
+ * (see solve_task_set). A repeat of an earlier solve is answered from the
+ * result cache. Options with a deadline, cancel flag or progress callback
+ * install their control for the solve, unless the thread already runs
+ * under one (a batch); stopped solves are not cached.
+ * Returns false if memory for the task set runs out.
+ */
+static bool solve_timeline(WeeklyTimeline* timeline, const TimelineTask* tasks, TimelineTask* result,
+                           int count, const OptimizationConfig* config, const TimelineBase* base,
+                           const SolveOptions* options, Arena* arena) {
+    uint64_t key[2];
+    bool cached = result_cache_enabled();
+    SolveControl control;
+    SolveControl* outer = g_control;
+    if (!outer && control_wanted(options)) {
+        control_init(&control, options, count);
+        g_control = &control;
+    }
+    stats_begin();
+    STAT_CLOCK(lap);
+    if (cached) {
+        const OptimizationConfig* cfg = base ? &base->config : config ? config : &DEFAULT_CONFIG;
+        result_cache_key(tasks, count, cfg, options, base ? base->key : NULL, key);
+        if (result_cache_lookup(key, timeline, result, count)) {
+            SlotGrid grid = { timeline->slots_per_day, timeline->slot_count, timeline->occ_words };
+            g_active_grid = grid;
+            STAT_ADD(cache_hits, 1);
+            STAT_LAP(setup_us, lap);
+            stats_end(arena);
+            g_control = outer;
+            return true;
+        }
+        STAT_ADD(cache_misses, 1);
+    }
+    
+    TaskSet set;
+    if (!task_set_build(&set, tasks, count, count, arena)) {
+        stats_end(arena);
+        g_control = outer;
+        return false;
+    }
+    STAT_LAP(setup_us, lap);
+    
+    bool ok = solve_task_set(timeline, &set, config, base, options, arena);
+    if (ok) {
+        timeline->tasks = result;
+        if (result) {
+            task_set_write_back(&set, result);
+        }
+        /* A result cut short by the budget may improve on a rerun */
+        if (cached && !control_tripped() && timeline->optimization_status != -2) {
+            result_cache_store(key, timeline, &set);
+        }
+    }
+    
+    task_set_release(&set, arena);
+    stats_end(arena);
+    g_control = outer;
+    return ok;
+}
+
+/* ============================================
+ * BASE TIMELINES
+ * ============================================ */
+
+/*
+ * Build the shared base for a cohort: the sleep window of config blocked
+ * and classes placed, as a solve would force-place them (only locked tasks
+ * with a usable preferred slot are; others are ignored). Solves on the
+ * base copy its slots instead of rebuilding them, and callers leave the
+ * classes out of each user's tasks. Returns NULL for an unsupported grid
+ * or if memory runs out. Destroy only once no solve is using it.
+ */
+EXPORT TimelineBase* timeline_base_create(const TimelineTask* classes, int count,
+                                          const OptimizationConfig* config) {
+    const OptimizationConfig* cfg = config ? config : &DEFAULT_CONFIG;
+    SlotGrid grid;
+    if (count < 0 || (count > 0 && !classes) || !grid_from_config(cfg, &grid)) {
+        return NULL;
+    }
+    
+    TimelineBase* base = (TimelineBase*)malloc(sizeof(TimelineBase) + sizeof(int) * (size_t)grid.slot_count);
+    TaskSet set;
+    if (!base || !task_set_build(&set, classes, count, count, NULL)) {
+        free(base);
+        return NULL;
+    }
+    
+    timeline_bind(&base->timeline, (int*)(base + 1), grid.slot_count);
+    
+    base->config = *cfg;
+    base->grid = grid;
+    timeline_reset(&base->timeline, cfg, &grid);
+    base->forced = place_locked_tasks(&base->timeline, &set);
+    base->timeline.tasks = NULL;
+    base->timeline.task_count = 0;
+    result_cache_key(classes, count, cfg, NULL, NULL, base->key);
+    
+    task_set_release(&set, NULL);
+    return base;
+}
+
+EXPORT void timeline_base_destroy(TimelineBase* base) {
+    free(base);
+}
+
+/* ============================================
+ * BATCH THREAD POOL
+ * ============================================ */
+
+/* Shared, read-only description of one batch call */
+typedef struct {
+    const TimelineTask* tasks;
+    const int* offsets;
+    const OptimizationConfig* cfgs;
+    const TimelineBase* const* bases;  /* Per user, NULL = solve from cfgs */
+    const SolveOptions* options;       /* Every user's, or NULL for greedy */
+    const SolveControl* control;       /* The calling thread's, or NULL */
+    int done;                          /* Users solved so far */
+    WeeklyTimeline* out;
+    Arena** arenas;                    /* One per worker, reset per user */
+    int failed;                        /* Set if any user ran out of memory */
+} BatchJob;
+
+/* A user whose slot storage is too small: nothing placed, no slots */
+static void batch_storage_error(WeeklyTimeline* timeline, TimelineTask* result, int count) {
+    for (int i = 0; result && i < count; i++) {
+        result[i].assigned_slot = -1;
+    }
+    timeline->slot_count = 0;
+    timeline->slots_per_day = SLOTS_PER_DAY;
+    timeline->occ_words = 0;
+    timeline->task_count = count;
+    timeline->optimization_status = -1;
+    timeline->error_code = ENGINE_ERROR_STORAGE;
+    timeline->total_gaps_filled = 0;
+    timeline->total_conflicts = count;
+    timeline->solve_strategy = -1;
+}
+
+/* Pool job: solve user u out of the worker's own arena */
+static void batch_solve_user(void* raw, int u, int worker) {
+    BatchJob* job = (BatchJob*)raw;
+    int count = job->offsets[u + 1] - job->offsets[u];
+    const TimelineTask* src = job->tasks + job->offsets[u];
+    WeeklyTimeline* timeline = &job->out[u];
+    TimelineTask* result = timeline->tasks;
+    Arena* arena = job->arenas[worker];
+    
+    if (result && count > 0 && result != src) {
+        memcpy(result, src, sizeof(TimelineTask) * count);
+    }
+    
+    /* Worker 0 is the calling thread, whose control is already installed */
+    SolveControl copy;
+    if (worker != 0 && job->control) {
+        control_worker_copy(&copy, job->control);
+        g_control = &copy;
+    }
+    
+    const OptimizationConfig* cfg = job->cfgs ? &job->cfgs[u] : NULL;
+    const TimelineBase* base = job->bases ? job->bases[u] : NULL;
+    arena_reset(arena);
+    if (!timeline->slots || timeline->slot_capacity < solve_slot_count(cfg, base)) {
+        batch_storage_error(timeline, result, count);
+    } else if (!solve_timeline(timeline, src, result, count, cfg, base, job->options, arena)) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&job->done, 1, __ATOMIC_RELAXED);
+    if (worker != 0 && job->control) {
+        g_control = NULL;
+    } else {
+        control_poll(ENGINE_PHASE_BATCH, 0, 0);
+    }
+}
+
+/* ============================================
+ * INCREMENTAL TIMELINE HANDLE
+ * ============================================ */
+
+/*
+ * A handle keeps one solved timeline alive between edits, so inserting or
+ * removing a single task only repairs the region it touches instead of
+ * re-running sleep blocking, sorting and placement for everything.
+ */
+
+#define REPAIR_MAX_BLOCKERS 2      /* Tasks one insert may displace */
+#define REPAIR_MAX_ATTEMPTS 32     /* Candidate starts tried per insert */
+
+/*
+ * Open-addressing map from task id to set index (linear probing,
+ * backward-shift deletion, at most half full). With duplicate ids at
+ * open only the first task in priority order is indexed.
+ */
+typedef struct {
+    int* ids;
+    int* index;                    /* -1 = empty bucket */
+    int mask;                      /* Bucket count - 1 */
+} IdIndex;
+
+struct TimelineHandle {
+    WeeklyTimeline timeline;       /* timeline.tasks points at tasks below, its slots after the handle */
+    OptimizationConfig config;
+    TimelineTask* tasks;           /* Owned copies, in insertion order */
+    TaskSet set;                   /* The same tasks in priority order */
+    int capacity;
+    IdIndex by_id;                 /* Task id -> set index */
+    ScoreTable scores;             /* Built from config at open */
+};
+
+static unsigned id_bucket(const IdIndex* map, int id) {
+    return ((unsigned)id * 2654435761u) & (unsigned)map->mask;
+}
+
+static void id_index_release(IdIndex* map) {
+    free(map->ids);
+    free(map->index);
+    map->ids = NULL;
+    map->index = NULL;
+}
+
+/* Empty map with room for capacity ids */
+static bool id_index_init(IdIndex* map, int capacity) {
+    int buckets = 16;
+    while (buckets < 2 * capacity) {
+        buckets *= 2;
+    }
+    map->ids = (int*)malloc(sizeof(int) * buckets);
+    map->index = (int*)malloc(sizeof(int) * buckets);
+    map->mask = buckets - 1;
+    if (!map->ids || !map->index) {
+        id_index_release(map);
+        return false;
+    }
+    memset(map->index, -1, sizeof(int) * buckets);
+    return true;
+}
+
+static int id_index_get(const IdIndex* map, int id) {
+    for (unsigned b = id_bucket(map, id); map->index[b] >= 0; b = (b + 1) & map->mask) {
+        if (map->ids[b] == id) {
+            return map->index[b];
+        }
+    }
+    return -1;
+}
+
+/* Insert or overwrite */
+static void id_index_put(IdIndex* map, int id, int index) {
+    unsigned b = id_bucket(map, id);
+    while (map->index[b] >= 0 && map->ids[b] != id) {
+        b = (b + 1) & map->mask;
+    }
+    map->ids[b] = id;
+    map->index[b] = index;
+}
+
+static void id_index_remove(IdIndex* map, int id) {
+    unsigned b = id_bucket(map, id);
+    while (map->index[b] >= 0 && map->ids[b] != id) {
+        b = (b + 1) & map->mask;
+    }
+    if (map->index[b] < 0) {
+        return;
+    }
+    
+    /* Pull later entries of the probe run back over the hole */
+    unsigned hole = b;
+    for (unsigned next = (b + 1) & map->mask; map->index[next] >= 0; next = (next + 1) & map->mask) {
+        unsigned home = id_bucket(map, map->ids[next]);
+        if (((next - home) & map->mask) >= ((next - hole) & map->mask)) {
+            map->ids[hole] = map->ids[next];
+            map->index[hole] = map->index[next];
+            hole = next;
+        }
+    }
+    map->index[hole] = -1;
+}
+
+/* Index every task of set, keeping the first of duplicate ids */
+static void id_index_fill(IdIndex* map, const TaskSet* set) {
+    for (int i = 0; i < set->count; i++) {
+        if (id_index_get(map, set->id[i]) < 0) {
+            id_index_put(map, set->id[i], i);
+        }
+    }
+}
+
+/* Set index of a task id, or -1 */
+static int handle_find_task(TimelineHandle* h, int task_id) {
+    return id_index_get(&h->by_id, task_id);
+}
+
+/* Placed and free to move (not pinned by a lock) */
+static bool is_movable(const TimelineHandle* h, int i) {
+    return h->set.assigned[i] >= 0 && !is_force_placed(&h->set, i, h->timeline.slot_count);
+}
+
+/* Grow the task array, the set and the id index to hold capacity tasks */
+static bool handle_grow(TimelineHandle* h, int capacity) {
+    IdIndex by_id;
+    if (!id_index_init(&by_id, capacity)) {
+        return false;
+    }
+    
+    TimelineTask* grown = (TimelineTask*)realloc(h->tasks, sizeof(TimelineTask) * capacity);
+    if (!grown) {
+        id_index_release(&by_id);
+        return false;
+    }
+    h->tasks = grown;
+    h->timeline.tasks = grown;
+    
+    void* block = malloc(task_set_bytes(capacity));
+    if (!block) {
+        id_index_release(&by_id);
+        return false;
+    }
+    TaskSet set;
+    task_set_bind(&set, block, capacity);
+    set.count = h->set.count;
+    for (int i = 0; i < set.count; i++) {
+        task_set_copy_entry(&set, i, &h->set, i);
+    }
+    task_set_release(&h->set, NULL);
+    h->set = set;
+    h->capacity = capacity;
+    
+    id_index_fill(&by_id, &h->set);
+    id_index_release(&h->by_id);
+    h->by_id = by_id;
+    return true;
+}
+
+/*
+ * Edits place and lift tasks only through these two, which keep
+ * total_gaps_filled counting the placed tasks and publish the task's
+ * slot, so an edit costs nothing for the tasks it does not touch
+ */
+static void handle_place(TimelineHandle* h, int i, int slot) {
+    place_task(&h->timeline, &h->set, i, slot);
+    h->tasks[h->set.source[i]].assigned_slot = slot;
+    h->timeline.total_gaps_filled++;
+}
+
+static void handle_lift(TimelineHandle* h, int i) {
+    remove_task(&h->timeline, &h->set, i);
+    h->tasks[h->set.source[i]].assigned_slot = -1;
+    h->timeline.total_gaps_filled--;
+}
+
+/* Status after an edit; an error_code from the last solve goes once the status moves */
+static void handle_refresh_status(TimelineHandle* h) {
+    WeeklyTimeline* tl = &h->timeline;
+    int status_was = tl->optimization_status;
+    
+    tl->task_count = h->set.count;
+    tl->total_conflicts = tl->task_count - tl->total_gaps_filled;
+    tl->optimization_status = (tl->total_conflicts > tl->task_count / 2) ? -1 : 0;
+    if (tl->optimization_status != status_was) {
+        tl->error_code = 0;
+    }
+}
+
+/* Distinct tasks occupying [start, start + len); -1 if one is locked or too many */
+static int collect_blockers(TimelineHandle* h, int start, int len, int* out, int max_out) {
+    int n = 0;
+    
+    for (int slot = start; slot < start + len; slot++) {
+        int id = h->timeline.slots[slot];
+        if (id < 0) {           /* Empty or blocked */
+            continue;
+        }
+        
+        int idx = handle_find_task(h, id);
+        bool seen = false;
+        for (int k = 0; k < n; k++) {
+            seen = seen || out[k] == idx;
+        }
+        if (seen) {
+            continue;
+        }
+        if (idx < 0 || !is_movable(h, idx) || n == max_out) {
+            return -1;
+        }
+        out[n++] = idx;
+    }
+    return n;
+}
+
+/*
+ * Make room for task t by moving up to REPAIR_MAX_BLOCKERS unlocked
+ * tasks out of the way. Candidate starts are those where the task would
+ * fit if movable tasks were lifted, tried best score first. Each attempt
+ * is undone completely if any displaced task cannot be re-placed.
+ * Returns the slot used, or -1.
+ */
+static int handle_repair_insert(TimelineHandle* h, int t) {
+    WeeklyTimeline* tl = &h->timeline;
+    TaskSet* set = &h->set;
+    int duration = set->duration[t];
+    int words = tl->occ_words;
+    uint64_t avail[OCC_WORDS], held[OCC_WORDS], candidates[OCC_WORDS];
+    
+    if (duration <= 0) {
+        return -1;
+    }
+    
+    /* Slots that are free or held by a movable task */
+    occ_clear_all(held, words);
+    for (int i = 0; i < set->count; i++) {
+        if (i != t && is_movable(h, i)) {
+            occ_set_range(held, set->assigned[i], set->duration[i]);
+        }
+    }
+    task_available_mask(tl, set->category[t], avail);
+    for (int w = 0; w < words; w++) {
+        avail[w] |= held[w] & (set->category[t] == TASK_SLEEP ? ~0ULL : ~tl->sleep_mask[w]);
+    }
+    occ_run_starts(candidates, avail, duration, words);
+    occ_truncate(candidates, set->deadline[t] - duration + 1, words);
+    
+    for (int attempt = 0; attempt < REPAIR_MAX_ATTEMPTS; attempt++) {
+        /* Best remaining candidate by score, earliest on ties */
+        int score;
+        int start = best_scored_slot(candidates, set, t, &h->scores, &score);
+        if (start < 0) {
+            return -1;
+        }
+        occ_clear_bit(candidates, start);
+        
+        int blockers[REPAIR_MAX_BLOCKERS];
+        int old_slots[REPAIR_MAX_BLOCKERS];
+        int n = collect_blockers(h, start, duration, blockers, REPAIR_MAX_BLOCKERS);
+        if (n < 0) {
+            continue;
+        }
+        
+        /* Lift the blockers, drop the new task in, re-place the blockers */
+        for (int k = 0; k < n; k++) {
+            old_slots[k] = set->assigned[blockers[k]];
+            handle_lift(h, blockers[k]);
+        }
+        handle_place(h, t, start);
+        
+        int moved = 0;
+        while (moved < n) {
+            int slot = find_best_slot(tl, set, blockers[moved], &h->scores);
+            if (slot < 0) {
+                break;
+            }
+            handle_place(h, blockers[moved], slot);
+            moved++;
+        }
+        if (moved == n) {
+            return start;
+        }
+        
+        /* Undo this attempt */
+        for (int k = 0; k < moved; k++) {
+            handle_lift(h, blockers[k]);
+        }
+        handle_lift(h, t);
+        for (int k = 0; k < n; k++) {
+            handle_place(h, blockers[k], old_slots[k]);
+        }
+    }
+    
+    return -1;
+}
+
+/* Retry every unplaced task after space was freed, in priority order */
+static void handle_fill_conflicts(TimelineHandle* h) {
+    if (h->timeline.total_gaps_filled == h->set.count) {
+        return;                 /* Nothing is unplaced: skip the walk */
+    }
+    for (int i = 0; i < h->set.count; i++) {
+        if (h->set.assigned[i] >= 0) {
+            continue;
+        }
+        int slot = find_best_slot(&h->timeline, &h->set, i, &h->scores);
+        if (slot >= 0) {
+            handle_place(h, i, slot);
+        }
+    }
+}
+
+/* Force-place locked task t, displacing and re-placing unlocked occupants */
+static void handle_place_locked(TimelineHandle* h, int t) {
+    int start = h->set.preferred[t];
+    int blockers[MAX_SLOTS];
+    
+    /* Another locked task already holds part of the range: conflict */
+    int n = collect_blockers(h, start, h->set.duration[t], blockers, MAX_SLOTS);
+    if (n < 0) {
+        return;
+    }
+    for (int k = 0; k < n; k++) {
+        handle_lift(h, blockers[k]);
+    }
+    
+    handle_place(h, t, start);
+    handle_fill_conflicts(h);
+}
+
+/* Set position for a new task, after every entry that sorts before it */
+static int handle_insert_position(TimelineHandle* h, TaskKey key) {
+    const TaskSet* set = &h->set;
+    int lo = 0;
+    int hi = set->count;
+    
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        TaskKey cur = { set->locked[mid], set->priority[mid], set->deadline[mid], set->source[mid] };
+        if (compare_task_keys(&cur, &key) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/* ============================================
+ * WHAT-IF EVALUATION
+ * ============================================ */
+
+/*
+ * A candidate edit is evaluated against an open handle without writing
+ * to it: each evaluation copies the free bitmap and replays, on that
+ * copy, what timeline_remove_task and timeline_insert_task would do.
+ * While every task is placed that copy is enough. When some are not, the
+ * edit retries them in freed space (handle_fill_conflicts), so the
+ * evaluation also copies the slot owners and assigned slots to track
+ * where they go. The handle's slots, task set, id index and score table
+ * are only read, so any number of candidates can be evaluated on the
+ * pool at once.
+ */
+
+/* One evaluation: the handle's free bitmap with the candidate's edits applied */
+typedef struct {
+    const TimelineHandle* h;
+    int self;                      /* Set index of the task being replaced (-1 = insert) */
+    const int* slots;              /* Slot owners: the handle's, or own's copy */
+    const int* assigned;           /* Task starts: the handle's, or own's copy */
+    int* own;                      /* slot_count owners then count starts, if tasks are unplaced (else NULL) */
+    uint64_t free_mask[OCC_WORDS];
+    int score_delta;
+    int conflicts;
+    int moved;
+} WhatIf;
+
+/* Shared, read-only description of one what-if call */
+typedef struct {
+    const TimelineHandle* h;
+    const TimelineTask* candidates;
+    WhatIfResult* out;
+    EngineStats stats;             /* Counted by the workers, for the calling thread */
+    int failed;                    /* Set if an evaluation ran out of memory */
+} WhatIfJob;
+
+/* Free [start, start + len) on the copy; sleep slots a locked task covered stay blocked */
+static void what_if_lift(WhatIf* w, int start, int len) {
+    const WeeklyTimeline* tl = &w->h->timeline;
+    uint64_t range[OCC_WORDS];
+    
+    occ_clear_all(range, tl->occ_words);
+    occ_set_range(range, start, len);
+    for (int k = 0; k < tl->occ_words; k++) {
+        w->free_mask[k] |= range[k] & ~tl->sleep_mask[k];
+    }
+}
+
+/* is_movable against the copy */
+static bool what_if_movable(const WhatIf* w, int i) {
+    return w->assigned[i] >= 0 && !is_force_placed(&w->h->set, i, w->h->timeline.slot_count);
+}
+
+/* find_best_slot for entry i of set, against the copy; its score goes to *score */
+static int what_if_best_slot(const WhatIf* w, const TaskSet* set, int i, int* score) {
+    const WeeklyTimeline* tl = &w->h->timeline;
+    int preferred = set->preferred[i];
+    int duration = set->duration[i];
+    
+    if (preferred >= 0 && preferred + duration <= tl->slot_count &&
+        preferred + duration <= set->deadline[i] &&
+        occ_range_all_set(w->free_mask, preferred, duration) &&
+        (set->category[i] == TASK_SLEEP || !occ_range_any_set(tl->sleep_mask, preferred, duration))) {
+        *score = get_placement_score(preferred, set, i, &w->h->scores);
+        return preferred;
+    }
+    
+    uint64_t starts[OCC_WORDS];
+    mask_valid_starts(w->free_mask, tl->sleep_mask, tl->slot_count, tl->occ_words, set, i, starts);
+    return best_scored_slot(starts, set, i, &w->h->scores, score);
+}
+
+/*
+ * collect_blockers against the copy: distinct tasks of the handle holding
+ * [start, start + len), in slot order; -1 if one is pinned or too many
+ */
+static int what_if_blockers(const WhatIf* w, int start, int len, int* out, int max_out) {
+    const TimelineHandle* h = w->h;
+    int n = 0;
+    
+    for (int slot = start; slot < start + len; slot++) {
+        int id = w->slots[slot];
+        if (id < 0 || occ_test_bit(w->free_mask, slot, h->timeline.occ_words)) {
+            continue;           /* Empty, blocked or lifted */
+        }
+        
+        int idx = id_index_get(&h->by_id, id);
+        bool seen = idx == w->self && idx >= 0;
+        for (int k = 0; k < n; k++) {
+            seen = seen || out[k] == idx;
+        }
+        if (seen) {
+            continue;
+        }
+        if (idx < 0 || !what_if_movable(w, idx) || n == max_out) {
+            return -1;
+        }
+        out[n++] = idx;
+    }
+    return n;
+}
+
+/*
+ * Lift blockers[0 .. n), take [start, start + len) and re-place the
+ * blockers on the copy. Returns how many could not be re-placed.
+ */
+static int what_if_displace(WhatIf* w, int start, int len, const int* blockers, int n) {
+    const TaskSet* set = &w->h->set;
+    int lost = 0;
+    
+    for (int k = 0; k < n; k++) {
+        int b = blockers[k];
+        what_if_lift(w, w->assigned[b], set->duration[b]);
+        w->score_delta -= get_placement_score(w->assigned[b], set, b, &w->h->scores);
+    }
+    occ_clear_range(w->free_mask, start, len);
+    
+    for (int k = 0; k < n; k++) {
+        int score;
+        int slot = what_if_best_slot(w, set, blockers[k], &score);
+        if (slot < 0) {
+            lost++;
+            continue;
+        }
+        occ_clear_range(w->free_mask, slot, set->duration[blockers[k]]);
+        w->score_delta += score;
+        w->moved += set->assigned[blockers[k]] >= 0;   /* Not one the edit let in */
+    }
+    return lost;
+}
+
+/* Take task i of the handle off the copy (own must be set) */
+static void what_if_unplace(WhatIf* w, int i) {
+    const TaskSet* set = &w->h->set;
+    int start = w->assigned[i];
+    
+    what_if_lift(w, start, set->duration[i]);
+    for (int slot = start; slot < start + set->duration[i]; slot++) {
+        w->own[slot] = EMPTY_SLOT;
+    }
+    w->own[w->h->timeline.slot_count + i] = -1;
+}
+
+/* handle_fill_conflicts on the copy: retry the unplaced tasks in priority order */
+static void what_if_fill(WhatIf* w) {
+    const TaskSet* set = &w->h->set;
+    int* assigned = w->own + w->h->timeline.slot_count;
+    
+    for (int i = 0; i < set->count; i++) {
+        if (i == w->self || assigned[i] >= 0) {
+            continue;
+        }
+        int score;
+        int slot = what_if_best_slot(w, set, i, &score);
+        if (slot < 0) {
+            continue;
+        }
+        occ_clear_range(w->free_mask, slot, set->duration[i]);
+        for (int k = slot; k < slot + set->duration[i]; k++) {
+            w->own[k] = set->id[i];
+        }
+        assigned[i] = slot;
+        w->score_delta += score;
+        w->conflicts--;
+        w->moved += set->assigned[i] >= 0;     /* A displaced task, not one unplaced before */
+    }
+}
+
+/* handle_place_locked on the copy. Returns the slot, or -1 if a pinned task holds it */
+static int what_if_place_locked(WhatIf* w, const TaskSet* one, int* score) {
+    int start = one->preferred[0];
+    int blockers[MAX_SLOTS];
+    
+    int n = what_if_blockers(w, start, one->duration[0], blockers, MAX_SLOTS);
+    if (n < 0) {
+        return -1;
+    }
+    *score = get_placement_score(start, one, 0, &w->h->scores);
+    
+    /* Tasks unplaced before compete with the displaced ones for the space */
+    if (w->own) {
+        const TaskSet* set = &w->h->set;
+        for (int k = 0; k < n; k++) {
+            w->score_delta -= get_placement_score(w->assigned[blockers[k]], set, blockers[k], &w->h->scores);
+            w->conflicts++;
+            what_if_unplace(w, blockers[k]);
+        }
+        occ_clear_range(w->free_mask, start, one->duration[0]);
+        for (int slot = start; slot < start + one->duration[0]; slot++) {
+            w->own[slot] = one->id[0];
+        }
+        what_if_fill(w);
+        return start;
+    }
+    
+    /* Displaced tasks go back in priority order, as handle_fill_conflicts retries them */
+    for (int k = 1; k < n; k++) {
+        int b = blockers[k];
+        int j = k;
+        for (; j > 0 && blockers[j - 1] > b; j--) {
+            blockers[j] = blockers[j - 1];
+        }
+        blockers[j] = b;
+    }
+    w->conflicts += what_if_displace(w, start, one->duration[0], blockers, n);
+    return start;
+}
+
+/*
+ * handle_repair_insert on the copy: try the best-scored starts that up to
+ * REPAIR_MAX_BLOCKERS movable tasks hold, keeping the first whose
+ * blockers all fit elsewhere. Returns the slot, or -1.
+ */
+static int what_if_repair(WhatIf* w, const TaskSet* one, int* score) {
+    const TimelineHandle* h = w->h;
+    const WeeklyTimeline* tl = &h->timeline;
+    const TaskSet* set = &h->set;
+    int duration = one->duration[0];
+    int words = tl->occ_words;
+    bool sleep_ok = one->category[0] == TASK_SLEEP;
+    uint64_t held[OCC_WORDS], candidates[OCC_WORDS];
+    
+    if (duration <= 0) {
+        return -1;
+    }
+    
+    /* Slots that are free on the copy or held by a movable task */
+    occ_clear_all(held, words);
+    for (int i = 0; i < set->count; i++) {
+        if (i != w->self && what_if_movable(w, i)) {
+            occ_set_range(held, w->assigned[i], set->duration[i]);
+        }
+    }
+    for (int k = 0; k < words; k++) {
+        held[k] = (held[k] | w->free_mask[k]) & (sleep_ok ? ~0ULL : ~tl->sleep_mask[k]);
+    }
+    occ_run_starts(candidates, held, duration, words);
+    occ_truncate(candidates, one->deadline[0] - duration + 1, words);
+    
+    for (int attempt = 0; attempt < REPAIR_MAX_ATTEMPTS; attempt++) {
+        int start = best_scored_slot(candidates, one, 0, &h->scores, score);
+        if (start < 0) {
+            return -1;
+        }
+        occ_clear_bit(candidates, start);
+        
+        int blockers[REPAIR_MAX_BLOCKERS];
+        int n = what_if_blockers(w, start, duration, blockers, REPAIR_MAX_BLOCKERS);
+        if (n < 0) {
+            continue;
+        }
+        
+        /* Try on a second copy; an attempt that strands a blocker is dropped */
+        WhatIf attempt_w = *w;
+        if (what_if_displace(&attempt_w, start, duration, blockers, n) == 0) {
+            *w = attempt_w;
+            return start;
+        }
+    }
+    return -1;
+}
+
+/* Evaluate one candidate against the handle. Returns false if memory runs out */
+static bool what_if_evaluate(const TimelineHandle* h, const TimelineTask* candidate, WhatIfResult* out) {
+    const WeeklyTimeline* tl = &h->timeline;
+    const TaskSet* set = &h->set;
+    int block[TASK_SET_INT_FIELDS + 1];    /* One entry: task_set_bytes(1) */
+    TaskSet one;
+    WhatIf w;
+    
+    task_set_bind(&one, block, 1);
+    task_set_fill(&one, 0, candidate, 0);
+    one.count = 1;
+    
+    w.h = h;
+    w.self = id_index_get(&h->by_id, candidate->id);
+    w.slots = tl->slots;
+    w.assigned = set->assigned;
+    w.own = NULL;
+    w.score_delta = 0;
+    w.conflicts = 0;
+    w.moved = 0;
+    memcpy(w.free_mask, tl->free_mask, sizeof(uint64_t) * (size_t)tl->occ_words);
+    
+    /* Tasks other than the replaced one are unplaced: the edit may retry them */
+    int unplaced = tl->total_conflicts - (w.self >= 0 && set->assigned[w.self] < 0);
+    if (unplaced > 0) {
+        w.own = (int*)malloc(sizeof(int) * ((size_t)tl->slot_count + (size_t)set->count));
+        if (!w.own) {
+            return false;
+        }
+        memcpy(w.own, tl->slots, sizeof(int) * (size_t)tl->slot_count);
+        memcpy(w.own + tl->slot_count, set->assigned, sizeof(int) * (size_t)set->count);
+        w.slots = w.own;
+        w.assigned = w.own + tl->slot_count;
+    }
+    
+    /* Replacing a task: take the old version out first, and let the
+     * unplaced tasks retry in its space as timeline_remove_task does */
+    if (w.self >= 0 && set->assigned[w.self] >= 0) {
+        w.score_delta -= get_placement_score(set->assigned[w.self], set, w.self, &h->scores);
+        if (w.own) {
+            what_if_unplace(&w, w.self);
+            what_if_fill(&w);
+        } else {
+            what_if_lift(&w, set->assigned[w.self], set->duration[w.self]);
+        }
+    } else if (w.self >= 0) {
+        w.conflicts--;
+    }
+    
+    int score = 0;
+    int slot;
+    if (is_force_placed(&one, 0, tl->slot_count)) {
+        slot = what_if_place_locked(&w, &one, &score);
+    } else {
+        slot = what_if_best_slot(&w, &one, 0, &score);
+        if (slot < 0) {
+            slot = what_if_repair(&w, &one, &score);
+        }
+    }
+    if (slot >= 0) {
+        w.score_delta += score;
+    } else {
+        w.conflicts++;
+    }
+    
+    out->task_id = candidate->id;
+    out->best_slot = slot;
+    out->score_delta = w.score_delta;
+    out->conflicts = w.conflicts;
+    out->moved = w.moved;
+    free(w.own);
+    return true;
+}
+
+/* Pool job: evaluate candidate c */
+static void what_if_worker(void* raw, int c, int worker) {
+    WhatIfJob* job = (WhatIfJob*)raw;
+    STAT_SNAPSHOT(before);
+    (void)worker;
+    
+    if (!what_if_evaluate(job->h, &job->candidates[c], &job->out[c])) {
+        __atomic_store_n(&job->failed, 1, __ATOMIC_RELAXED);
+    }
+    STAT_HAND_OVER(&job->stats, before);
+}
+
+/* ============================================
+ * EXPORTED FUNCTIONS
+ * ============================================ */
+
+/*
+ * Solve a week. Each task's assigned_slot is filled in; the array keeps
+ * the caller's order (solving sorts a separate index, not the tasks).
+ */
+EXPORT WeeklyTimeline* optimize_timeline(TimelineTask* tasks, int count, OptimizationConfig* config) {
+    /* Allocate timeline */
+    WeeklyTimeline* timeline = timeline_alloc(NULL, 1, solve_slot_count(config, NULL));
+    if (!timeline) {
+        return NULL;
+    }
+    
+    if (!solve_timeline(timeline, tasks, tasks, count, config, NULL, NULL, NULL)) {
+        free(timeline);
+        return NULL;
+    }
+    return timeline;
+}
+
+/*
+ * optimize_timeline with search options. With SEARCH_BRANCH_AND_BOUND the
+ * greedy result seeds an exact search (MRV ordering, forward checking,
+ * bound on the objective). If time_limit_ms or node_limit runs out first,
+ * the timeline holds the best solution found so far, which is never worse
+ * than greedy; optimization_status is -2 only if that solution still
+ * leaves tasks unplaced. A conflict-free solution is status 0 either way,
+ * and a search that reaches the static bound counts as complete.
+ */
+EXPORT WeeklyTimeline* optimize_timeline_ex(TimelineTask* tasks, int count, OptimizationConfig* config,
+                                            const SolveOptions* options) {
+    WeeklyTimeline* timeline = timeline_alloc(NULL, 1, solve_slot_count(config, NULL));
+    if (!timeline) {
+        return NULL;
+    }
+    
+    if (!solve_timeline(timeline, tasks, tasks, count, config, NULL, options, NULL)) {
+        free(timeline);
+        return NULL;
+    }
+    return timeline;
+}
+
+/*
+ * Can these tasks fit? Runs only the capacity check of a solve (see
+ * FEASIBILITY CHECK), in O(n log n), so it can answer while the week is
+ * being edited. Ids of the fewest tasks to drop or move past their
+ * deadline go to drop_ids (up to max_drop; NULL for none). Returns the
+ * drop count (0 = passes), or -1 on invalid arguments, an unsupported
+ * grid or if memory runs out.
+ */
+EXPORT int check_feasibility(const TimelineTask* tasks, int count, const OptimizationConfig* config,
+                             FeasibilityReport* report, int* drop_ids, int max_drop) {
+    const OptimizationConfig* cfg = config ? config : &DEFAULT_CONFIG;
+    SlotGrid grid;
+    if (count < 0 || (count > 0 && !tasks) || !grid_from_config(cfg, &grid)) {
+        return -1;
+    }
+    
+    WeeklyTimeline* timeline = timeline_alloc(NULL, 1, grid.slot_count);
+    TaskSet set;
+    if (!timeline || !task_set_build(&set, tasks, count, count, NULL)) {
+        free(timeline);
+        return -1;
+    }
+    timeline_reset(timeline, cfg, &grid);
+    place_locked_tasks(timeline, &set);
+    
+    int drops = feasibility_check(timeline, &set, report, drop_ids, max_drop, NULL, false, NULL);
+    task_set_release(&set, NULL);
+    free(timeline);
+    return drops;
+}
+
+/* ============================================
+ * ENGINE CONTEXTS
+ * ============================================ */
+
+/*
+ * A context owns the result and scratch memory of every solve run through
+ * it: timelines, task copies, search stacks and gap buffers all come from
+ * its arena and stay valid until the next engine_context_reset. Nothing
+ * returned by a _ctx function is freed individually.
+ *
+ * A context is not thread-safe; use one per thread.
+ */
+EXPORT EngineContext* engine_context_create(size_t block_size) {
+    EngineContext* ctx = (EngineContext*)calloc(1, sizeof(EngineContext));
+    if (!ctx) {
+        return NULL;
+    }
+    
+    ctx->arena = arena_create(block_size);
+    if (!ctx->arena) {
+        free(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+/* Release everything handed out since the last reset (memory is reused) */
+EXPORT void engine_context_reset(EngineContext* ctx) {
+    if (ctx) {
+        arena_reset(ctx->arena);
+    }
+}
+
+EXPORT void engine_context_destroy(EngineContext* ctx) {
+    if (ctx) {
+        arena_destroy(ctx->arena);
+        free(ctx);
+    }
+}
+
+/* Current and high-water memory usage of the context */
+EXPORT void engine_context_stats(const EngineContext* ctx, ArenaStats* out) {
+    arena_get_stats(ctx ? ctx->arena : NULL, out);
+}
+
+/*
+ * optimize_timeline_ex with all memory taken from the context. The input
+ * tasks are copied, not modified; the returned timeline's tasks array
+ * holds the solved copies in input order. Returns NULL if the arena
+ * cannot grow.
+ */
+EXPORT WeeklyTimeline* optimize_timeline_ctx(EngineContext* ctx, const TimelineTask* tasks, int count,
+                                             const OptimizationConfig* config, const SolveOptions* options) {
+    if (!ctx || count < 0 || (count > 0 && !tasks)) {
+        return NULL;
+    }
+    
+    WeeklyTimeline* timeline = timeline_alloc(ctx->arena, 1, solve_slot_count(config, NULL));
+    TimelineTask* work = (TimelineTask*)arena_alloc(ctx->arena, sizeof(TimelineTask) * count);
+    if (!timeline || !work) {
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(work, tasks, sizeof(TimelineTask) * count);
+    }
+    
+    if (!solve_timeline(timeline, tasks, work, count, config, NULL, options, ctx->arena)) {
+        return NULL;
+    }
+    return timeline;
+}
+
+/*
+ * optimize_timeline_ctx on a base timeline: tasks are this solve's own
+ * tasks (not the base's classes) and the base's config is used. The
+ * returned timeline's slots include the classes; its tasks do not.
+ */
+EXPORT WeeklyTimeline* optimize_timeline_base_ctx(EngineContext* ctx, const TimelineBase* base,
+                                                  const TimelineTask* tasks, int count,
+                                                  const SolveOptions* options) {
+    if (!ctx || !base || count < 0 || (count > 0 && !tasks)) {
+        return NULL;
+    }
+    
+    WeeklyTimeline* timeline = timeline_alloc(ctx->arena, 1, solve_slot_count(NULL, base));
+    TimelineTask* work = (TimelineTask*)arena_alloc(ctx->arena, sizeof(TimelineTask) * count);
+    if (!timeline || !work) {
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(work, tasks, sizeof(TimelineTask) * count);
+    }
+    
+    if (!solve_timeline(timeline, tasks, work, count, NULL, base, options, ctx->arena)) {
+        return NULL;
+    }
+    return timeline;
+}
+
+/*
+ * Describe a solved timeline as flat arrays taken from the context, so
+ * the caller can wrap them without copying. input is the task array
+ * that was solved (unmodified, as with optimize_timeline_ctx) and
+ * defines "changed"; NULL compares against -1. The arrays stay valid
+ * until the context is reset. Returns 0, or -1 on invalid arguments or
+ * if the arena cannot grow.
+ */
+EXPORT int timeline_result_view(EngineContext* ctx, const WeeklyTimeline* timeline,
+                                const TimelineTask* input, ResultView* out) {
+    if (!ctx || !timeline || !out || (timeline->task_count > 0 && !timeline->tasks)) {
+        return -1;
+    }
+    
+    int n = timeline->task_count;
+    int* ids = (int*)arena_alloc(ctx->arena, sizeof(int) * 4 * (size_t)(n > 0 ? n : 1));
+    if (!ids) {
+        return -1;
+    }
+    int* assigned = ids + n;
+    int* conflicts = assigned + n;
+    int* changed = conflicts + n;
+    int conflict_count = 0;
+    int changed_count = 0;
+    
+    for (int i = 0; i < n; i++) {
+        const TimelineTask* t = &timeline->tasks[i];
+        int before = input ? input[i].assigned_slot : -1;
+        ids[i] = t->id;
+        assigned[i] = t->assigned_slot;
+        if (t->assigned_slot < 0) {
+            conflicts[conflict_count++] = t->id;
+        }
+        if (t->assigned_slot != before) {
+            changed[changed_count++] = i;
+        }
+    }
+    
+    out->slots = timeline->slots;
+    out->slot_count = timeline->slot_count;
+    out->task_ids = ids;
+    out->assigned = assigned;
+    out->task_count = n;
+    out->conflicts = conflicts;
+    out->conflict_count = conflict_count;
+    out->changed = changed;
+    out->changed_count = changed_count;
+    return 0;
+}
+
+/*
+ * Write a solved timeline as JSON into buf: success, status_code, slots
+ * (the first slot_count entries), tasks (every TimelineTask field, in
+ * the timeline's order), gaps_filled and conflicts, with the keys of the
+ * Python OptimizationResult.to_dict. Returns the document length; a
+ * result >= cap means buf was too small, and cap 0 only measures.
+ */
+EXPORT size_t timeline_to_json(const WeeklyTimeline* timeline, char* buf, size_t cap) {
+    JsonWriter w;
+    json_writer_to_memory(&w, buf, cap);
+    if (!timeline) {
+        json_raw(&w, "null", 4);
+        return json_writer_finish(&w);
+    }
+    
+    json_begin_object(&w);
+    json_key(&w, "success");
+    json_bool(&w, timeline->optimization_status == 0);
+    json_key(&w, "status_code");
+    json_int(&w, timeline->optimization_status);
+    
+    json_key(&w, "slots");
+    json_begin_array(&w);
+    for (int i = 0; i < timeline->slot_count; i++) {
+        json_int(&w, timeline->slots[i]);
+    }
+    json_end_array(&w);
+    
+    json_key(&w, "tasks");
+    json_begin_array(&w);
+    for (int i = 0; timeline->tasks && i < timeline->task_count; i++) {
+        const TimelineTask* t = &timeline->tasks[i];
+        json_begin_object(&w);
+        json_key(&w, "id");
+        json_int(&w, t->id);
+        json_key(&w, "duration_slots");
+        json_int(&w, t->duration_slots);
+        json_key(&w, "priority");
+        json_int(&w, t->priority);
+        json_key(&w, "category");
+        json_int(&w, t->category);
+        json_key(&w, "deadline_slot");
+        json_int(&w, t->deadline_slot);
+        json_key(&w, "is_locked");
+        json_bool(&w, t->is_locked);
+        json_key(&w, "title");
+        json_string(&w, t->title, sizeof(t->title));
+        json_key(&w, "subject");
+        json_string(&w, t->subject, sizeof(t->subject));
+        json_key(&w, "preferred_slot");
+        json_int(&w, t->preferred_slot);
+        json_key(&w, "assigned_slot");
+        json_int(&w, t->assigned_slot);
+        json_end_object(&w);
+    }
+    json_end_array(&w);
+    
+    json_key(&w, "gaps_filled");
+    json_int(&w, timeline->total_gaps_filled);
+    json_key(&w, "conflicts");
+    json_int(&w, timeline->total_conflicts);
+    json_key(&w, "strategy");
+    const char* strategy = get_strategy_name(timeline->solve_strategy);
+    if (strategy) {
+        json_string(&w, strategy, strlen(strategy));
+    } else {
+        json_raw(&w, "null", 4);
+    }
+    json_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+/*
+ * Solve many independent timelines in one call.
+ *
+ * User u owns tasks[offsets[u] .. offsets[u + 1]), so offsets has
+ * n_users + 1 entries. cfgs is either NULL (default config for everyone)
+ * or an array of n_users configs. Results go into the caller-provided
+ * out[0 .. n_users); nothing is allocated for the caller to free.
+ * out[u].slots must point to out[u].slot_capacity ints, at least
+ * get_solve_slots for the user's config or base; a user with less gets
+ * no slots and no placements, with status -1 and ENGINE_ERROR_STORAGE.
+ *
+ * The input tasks are not modified. If out[u].tasks is non-NULL on entry
+ * it must point to room for that user's task count, and receives copies
+ * of the user's tasks in input order with assigned_slot set; pointing it
+ * at the user's own input slice solves in place. Otherwise only the slot
+ * grid is produced and out[u].tasks is left NULL.
+ *
+ * Users are spread over the engine thread pool (see set_engine_threads).
+ * Every user is solved independently and deterministically, so the
+ * output does not depend on the thread count.
+ *
+ * Returns 0 on success, -1 on invalid arguments or allocation failure.
+ */
+EXPORT int optimize_timeline_batch(const TimelineTask* tasks, const int* offsets, int n_users,
+                                   const OptimizationConfig* cfgs, WeeklyTimeline* out) {
+    return optimize_timeline_batch_base(tasks, offsets, n_users, cfgs, NULL, out);
+}
+
+/*
+ * optimize_timeline_batch where bases (NULL, or one entry per user) lets
+ * users start from a shared base timeline: a user with a base is solved on
+ * it with its config, and cfgs[u] is ignored. A cohort passes its classes
+ * once, as the base, instead of inside every user's tasks.
+ */
+EXPORT int optimize_timeline_batch_base(const TimelineTask* tasks, const int* offsets, int n_users,
+                                        const OptimizationConfig* cfgs, const TimelineBase* const* bases,
+                                        WeeklyTimeline* out) {
+    return optimize_timeline_batch_ex(tasks, offsets, n_users, cfgs, bases, NULL, out);
+}
+
+/*
+ * optimize_timeline_batch_base with the same search options for every
+ * user (NULL = greedy). Their deadline, cancel flag and progress callback
+ * cover the whole batch: once it is stopped, users still being solved
+ * keep their best assignment so far, users not yet started get only
+ * their locked tasks, and both end with status -2. Progress reports
+ * count solved users (ENGINE_PHASE_BATCH).
+ */
+EXPORT int optimize_timeline_batch_ex(const TimelineTask* tasks, const int* offsets, int n_users,
+                                      const OptimizationConfig* cfgs, const TimelineBase* const* bases,
+                                      const SolveOptions* options, WeeklyTimeline* out) {
+    if (n_users < 0 || !offsets || (n_users > 0 && (!tasks || !out))) {
+        return -1;
+    }
+    
+    for (int u = 0; u < n_users; u++) {
+        if (offsets[u + 1] - offsets[u] < 0) {
+            return -1;
+        }
+    }
+    
+    pthread_mutex_lock(&g_pool_lock);
+    
+    ThreadPool* pool = (n_users > 1) ? acquire_pool() : NULL;
+    int workers = pool_thread_count(pool);
+    
+    /* One arena per worker for task sets and search scratch */
+    Arena** arenas = (Arena**)calloc(workers, sizeof(Arena*));
+    bool ok = arenas != NULL;
+    for (int w = 0; ok && w < workers; w++) {
+        arenas[w] = arena_create(0);
+        ok = arenas[w] != NULL;
+    }
+    
+    BatchJob job = {
+        .tasks = tasks,
+        .offsets = offsets,
+        .cfgs = cfgs,
+        .bases = bases,
+        .options = options,
+        .control = NULL,
+        .done = 0,
+        .out = out,
+        .arenas = arenas,
+        .failed = 0
+    };
+    
+    /* One control for the whole call, reporting solved users */
+    SolveControl control;
+    SolveControl* outer = g_control;
+    if (control_wanted(options)) {
+        control_init(&control, options, n_users);
+        control.batch_done = &job.done;
+        job.control = &control;
+        g_control = &control;
+    }
+    
+    if (ok && pool) {
+        pool_run(pool, n_users, batch_solve_user, &job);
+    } else if (ok) {
+        for (int u = 0; u < n_users; u++) {
+            batch_solve_user(&job, u, 0);
+        }
+    }
+    
+    pthread_mutex_unlock(&g_pool_lock);
+    g_control = outer;
+    
+    for (int w = 0; arenas && w < workers; w++) {
+        arena_destroy(arenas[w]);
+    }
+    free(arenas);
+    return (ok && !job.failed) ? 0 : -1;
+}
+
+/*
+ * Set the number of batch worker threads (including the calling thread).
+ * 0 means one per online CPU. Takes effect on the next batch call.
+ * Returns the thread count that will be used.
+ */
+EXPORT int set_engine_threads(int n_threads) {
+    pthread_mutex_lock(&g_pool_lock);
+    
+    g_thread_setting = n_threads > 0 ? n_threads : 0;
+    if (g_pool) {
+        pool_destroy(g_pool);
+        g_pool = NULL;
+    }
+    int effective = g_thread_setting > 0 ? g_thread_setting : pool_cpu_count();
+    
+    pthread_mutex_unlock(&g_pool_lock);
+    return effective;
+}
+
+EXPORT int get_engine_threads(void) {
+    pthread_mutex_lock(&g_pool_lock);
+    int effective = g_pool ? pool_thread_count(g_pool)
+                  : (g_thread_setting > 0 ? g_thread_setting : pool_cpu_count());
+    pthread_mutex_unlock(&g_pool_lock);
+    return effective;
+}
+
+/*
+ * Open a persistent timeline: the tasks are copied, fully solved once,
+ * and kept together with the occupancy bitmap until timeline_close.
+ * Returns NULL on allocation failure or an unsupported horizon or
+ * granularity in config.
+ */
+EXPORT TimelineHandle* timeline_open(const TimelineTask* tasks, int count,
+                                     const OptimizationConfig* config) {
+    SlotGrid grid;
+    if (count < 0 || (count > 0 && !tasks) ||
+        !grid_from_config(config ? config : &DEFAULT_CONFIG, &grid)) {
+        return NULL;
+    }
+    
+    TimelineHandle* h = (TimelineHandle*)calloc(1, sizeof(TimelineHandle) + sizeof(int) * (size_t)grid.slot_count);
+    if (!h) {
+        return NULL;
+    }
+    timeline_bind(&h->timeline, (int*)(h + 1), grid.slot_count);
+    
+    h->capacity = count > 16 ? count : 16;
+    h->tasks = (TimelineTask*)malloc(sizeof(TimelineTask) * h->capacity);
+    if (!h->tasks || !task_set_build(&h->set, tasks, count, h->capacity, NULL)) {
+        free(h->tasks);
+        free(h);
+        return NULL;
+    }
+    if (!id_index_init(&h->by_id, h->capacity)) {
+        task_set_release(&h->set, NULL);
+        free(h->tasks);
+        free(h);
+        return NULL;
+    }
+    id_index_fill(&h->by_id, &h->set);
+    if (count > 0) {
+        memcpy(h->tasks, tasks, sizeof(TimelineTask) * count);
+    }
+    h->config = config ? *config : DEFAULT_CONFIG;
+    build_score_table(&h->scores, &h->config, &grid);
+    
+    stats_begin();
+    bool solved = solve_task_set(&h->timeline, &h->set, &h->config, NULL, NULL, NULL);
+    stats_end(NULL);
+    if (!solved) {
+        id_index_release(&h->by_id);
+        task_set_release(&h->set, NULL);
+        free(h->tasks);
+        free(h);
+        return NULL;
+    }
+    h->timeline.tasks = h->tasks;
+    task_set_write_back(&h->set, h->tasks);
+    return h;
+}
+
+/*
+ * Add one task to an open timeline. The task goes to its best free slot
+ * if there is one; otherwise up to REPAIR_MAX_BLOCKERS unlocked tasks
+ * are moved to make room. Locked tasks with a preferred slot are forced
+ * there, moving unlocked occupants elsewhere.
+ *
+ * Returns the assigned slot, -1 if the task could not be placed (it is
+ * kept as a conflict), -2 if the id already exists, -3 if out of memory.
+ */
+EXPORT int timeline_insert_task(TimelineHandle* h, const TimelineTask* task) {
+    if (!h || !task) {
+        return -3;
+    }
+    if (handle_find_task(h, task->id) >= 0) {
+        return -2;
+    }
+    
+    TaskSet* set = &h->set;
+    int n = set->count;
+    if (n == h->capacity && !handle_grow(h, h->capacity * 2)) {
+        return -3;
+    }
+    
+    /* Append to the task array, insert into the set in priority order */
+    h->tasks[n] = *task;
+    h->tasks[n].assigned_slot = -1;
+    
+    int t = handle_insert_position(h, task_key(task, n));
+    task_set_move(set, t + 1, t, n - t);
+    for (int k = n; k > t; k--) {          /* Backwards, so duplicates stay put */
+        if (id_index_get(&h->by_id, set->id[k]) == k - 1) {
+            id_index_put(&h->by_id, set->id[k], k);
+        }
+    }
+    task_set_fill(set, t, task, n);
+    set->count++;
+    id_index_put(&h->by_id, task->id, t);
+    
+    stats_begin();
+    if (is_force_placed(set, t, h->timeline.slot_count)) {
+        handle_place_locked(h, t);
+    } else {
+        int slot = find_best_slot(&h->timeline, set, t, &h->scores);
+        if (slot >= 0) {
+            handle_place(h, t, slot);
+        } else {
+            handle_repair_insert(h, t);
+        }
+    }
+    
+    handle_refresh_status(h);
+    stats_end(NULL);
+    return set->assigned[t];
+}
+
+/*
+ * Remove a task by id. Its slots are freed and tasks that were
+ * previously unplaced get another chance at the space.
+ * Returns 0, or -1 if no task has that id.
+ */
+EXPORT int timeline_remove_task(TimelineHandle* h, int task_id) {
+    if (!h) {
+        return -1;
+    }
+    
+    int t = handle_find_task(h, task_id);
+    if (t < 0) {
+        return -1;
+    }
+    
+    WeeklyTimeline* tl = &h->timeline;
+    TaskSet* set = &h->set;
+    int start = set->assigned[t];
+    int source = set->source[t];
+    bool freed_space = start >= 0;
+    
+    if (freed_space) {
+        int duration = set->duration[t];
+        handle_lift(h, t);
+        
+        /* A locked task may have covered sleep; restore those slots */
+        for (int slot = start; slot < start + duration; slot++) {
+            if (occ_test_bit(tl->sleep_mask, slot, tl->occ_words)) {
+                mark_slots(tl, slot, 1, BLOCKED_SLOT);
+            }
+        }
+    }
+    
+    /* Close the gaps in the set and in the task array */
+    id_index_remove(&h->by_id, task_id);
+    set->count--;
+    task_set_move(set, t, t + 1, set->count - t);
+    for (int k = t; k < set->count; k++) {
+        if (set->id[k] == task_id && id_index_get(&h->by_id, task_id) < 0) {
+            id_index_put(&h->by_id, task_id, k);    /* Next duplicate */
+        } else if (id_index_get(&h->by_id, set->id[k]) == k + 1) {
+            id_index_put(&h->by_id, set->id[k], k);
+        }
+    }
+    for (int k = 0; k < set->count; k++) {
+        if (set->source[k] > source) {
+            set->source[k]--;
+        }
+    }
+    memmove(&h->tasks[source], &h->tasks[source + 1], sizeof(TimelineTask) * (set->count - source));
+    
+    if (freed_space) {
+        stats_begin();
+        handle_fill_conflicts(h);
+        stats_end(NULL);
+    }
+    handle_refresh_status(h);
+    return 0;
+}
+
+/*
+ * Evaluate candidate edits of an open timeline, each on its own, without
+ * changing it. A candidate whose id is in the timeline replaces that task,
+ * as timeline_remove_task then timeline_insert_task would; any other id
+ * is inserted. out[i] receives the slot candidates[i] would get and the
+ * change in placement score and conflicts, counting tasks moved or left
+ * unplaced to make room and unplaced tasks that the edit lets in.
+ * Candidates are spread over the engine thread pool; the handle must not
+ * be edited or closed during the call.
+ *
+ * Returns 0, -1 on invalid arguments, or -3 if memory runs out.
+ */
+EXPORT int timeline_what_if(const TimelineHandle* h, const TimelineTask* candidates, int count,
+                            WhatIfResult* out) {
+    if (!h || count < 0 || (count > 0 && (!candidates || !out))) {
+        return -1;
+    }
+    
+    WhatIfJob job = {
+        .h = h,
+        .candidates = candidates,
+        .out = out,
+        .stats = { 0 },
+        .failed = 0
+    };
+    
+    stats_begin();
+    pthread_mutex_lock(&g_pool_lock);
+    ThreadPool* pool = (count > 1) ? acquire_pool() : NULL;
+    if (pool) {
+        pool_run(pool, count, what_if_worker, &job);
+    } else {
+        for (int c = 0; c < count; c++) {
+            what_if_worker(&job, c, 0);
+        }
+    }
+    pthread_mutex_unlock(&g_pool_lock);
+    stats_add(&g_solve_stats, &job.stats);
+    stats_end(NULL);
+    return job.failed ? -3 : 0;
+}
+
+/* Current state of an open timeline (owned by the handle) */
+EXPORT const WeeklyTimeline* timeline_get(TimelineHandle* h) {
+    return h ? &h->timeline : NULL;
+}
+
+EXPORT void timeline_close(TimelineHandle* h) {
+    if (h) {
+        id_index_release(&h->by_id);
+        task_set_release(&h->set, NULL);
+        free(h->tasks);
+        free(h);
+    }
+}
+
+EXPORT void free_timeline_memory(WeeklyTimeline* timeline) {
+    if (timeline) {
+        /* Note: tasks array is owned by caller, don't free it */
+        free(timeline);
+    }
+}
+
+/*
+ * Violations found by validate_constraints_ex. Consecutive slots with the
+ * same problem merge into one range; count keeps going once out is full.
+ */
+typedef struct {
+    ConstraintViolation* out;
+    int max_out;
+    int count;
+    ConstraintViolation open;      /* Range still being extended (code 0 = none) */
+} ViolationList;
+
+static void violation_flush(ViolationList* list) {
+    if (list->open.code == 0) {
+        return;
+    }
+    if (list->count < list->max_out) {
+        list->out[list->count] = list->open;
+    }
+    list->count++;
+    list->open.code = 0;
+}
+
+static void violation_add(ViolationList* list, int code, int task_id, int start, int end, int other_id) {
+    ConstraintViolation* v = &list->open;
+    if (v->code == code && v->task_id == task_id && v->other_id == other_id && v->end_slot == start) {
+        v->end_slot = end;
+        return;
+    }
+    violation_flush(list);
+    ConstraintViolation next = { code, task_id, start, end, other_id };
+    list->open = next;
+}
+
+/* Does task t's assignment cover slot? */
+static bool task_covers(const TimelineTask* t, int slot) {
+    return t->assigned_slot >= 0 && slot >= t->assigned_slot && slot < t->assigned_slot + t->duration_slots;
+}
+
+/* Number of constraint violations in a solved timeline (see validate_constraints_ex) */
+EXPORT int validate_constraints(WeeklyTimeline* timeline) {
+    return validate_constraints_ex(timeline, NULL, 0);
+}
+
+/*
+ * Check a timeline against its tasks: one pass over each placed task's
+ * slots, then one over the slot array. Up to max_out violations go to out
+ * (NULL for none), in that order; slot values that are not task ids
+ * (a base's classes) are never violations. A timeline without a tasks
+ * array has nothing to check. Returns the number of violations, which
+ * may exceed max_out, or -1 on invalid arguments or if memory runs out.
+ */
+EXPORT int validate_constraints_ex(const WeeklyTimeline* timeline, ConstraintViolation* out, int max_out) {
+    if (!timeline || max_out < 0 || (max_out > 0 && !out) || !timeline_slots_valid(timeline)) {
+        return -1;
+    }
+    int n = timeline->task_count;
+    int slot_count = timeline->slot_count;
+    const TimelineTask* tasks = timeline->tasks;
+    const int* slots = timeline->slots;
+    if (n <= 0 || !tasks) {
+        return 0;
+    }
+    
+    IdIndex by_id;
+    int* owner = (int*)malloc(sizeof(int) * (size_t)(slot_count > 0 ? slot_count : 1));
+    if (!owner || !id_index_init(&by_id, n)) {
+        free(owner);
+        return -1;
+    }
+    for (int s = 0; s < slot_count; s++) {
+        owner[s] = -1;
+    }
+    for (int i = 0; i < n; i++) {
+        if (id_index_get(&by_id, tasks[i].id) < 0) {
+            id_index_put(&by_id, tasks[i].id, i);
+        }
+    }
+    
+    ViolationList list = { out, max_out, 0, { 0, 0, 0, 0, 0 } };
+    
+    /* Per task: lock, bounds, deadline, sleep window, then each slot it claims */
+    for (int i = 0; i < n; i++) {
+        const TimelineTask* t = &tasks[i];
+        int start = t->assigned_slot;
+        int end = start + t->duration_slots;
+        
+        if (t->is_locked && t->preferred_slot >= 0 &&
+            t->preferred_slot + t->duration_slots <= slot_count && start != t->preferred_slot) {
+            violation_add(&list, VIOLATION_LOCKED_MOVED, t->id, t->preferred_slot,
+                          t->preferred_slot + t->duration_slots, -1);
+        }
+        if (start < 0) {
+            continue;
+        }
+        if (end > slot_count) {
+            violation_add(&list, VIOLATION_OUT_OF_RANGE, t->id, start > slot_count ? start : slot_count,
+                          end, -1);
+        }
+        
+        /* A locked task at its preferred slot is input, not a solver decision */
+        bool pinned = t->is_locked && start == t->preferred_slot;
+        if (end > t->deadline_slot && !pinned) {
+            violation_add(&list, VIOLATION_DEADLINE, t->id, start > t->deadline_slot ? start : t->deadline_slot,
+                          end, -1);
+        }
+        int last = end < slot_count ? end : slot_count;
+        if (t->category != TASK_SLEEP && !pinned) {
+            for (int s = start; s < last; s++) {
+                if (occ_test_bit(timeline->sleep_mask, s, timeline->occ_words)) {
+                    violation_add(&list, VIOLATION_BLOCKED, t->id, s, s + 1, -1);
+                }
+            }
+        }
+        
+        for (int s = start; s < last; s++) {
+            if (owner[s] >= 0) {
+                violation_add(&list, VIOLATION_OVERLAP, t->id, s, s + 1, tasks[owner[s]].id);
+                continue;
+            }
+            owner[s] = i;
+            if (slots[s] == t->id) {
+                continue;
+            }
+            int j = slots[s] >= 0 ? id_index_get(&by_id, slots[s]) : -1;
+            if (j >= 0 && task_covers(&tasks[j], s)) {
+                violation_add(&list, VIOLATION_OVERLAP, t->id, s, s + 1, slots[s]);
+            } else {
+                violation_add(&list, VIOLATION_SLOT_MISMATCH, t->id, s, s + 1, slots[s]);
+            }
+        }
+    }
+    
+    /* Per slot: task ids left where their task is not assigned */
+    int seen_id = EMPTY_SLOT;
+    int seen = -1;
+    for (int s = 0; s < slot_count; s++) {
+        int id = slots[s];
+        if (id < 0 || (owner[s] >= 0 && tasks[owner[s]].id == id)) {
+            continue;
+        }
+        if (id != seen_id) {
+            seen_id = id;
+            seen = id_index_get(&by_id, id);
+        }
+        if (seen >= 0 && !task_covers(&tasks[seen], s)) {
+            violation_add(&list, VIOLATION_SLOT_MISMATCH, id, s, s + 1, id);
+        }
+    }
+    violation_flush(&list);
+    
+    id_index_release(&by_id);
+    free(owner);
+    return list.count;
+}
+
+/*
+ * Sum of get_placement_score over the placed tasks, the heuristic part
+ * of the search objective, computed straight from peak_bonus so that no
+ * score table is needed. 0 when heuristics are off or config is NULL.
+ */
+EXPORT int64_t timeline_placement_score(const WeeklyTimeline* timeline, const OptimizationConfig* config) {
+    if (!timeline || !config || !config->enable_heuristics || timeline->slots_per_day <= 0) {
+        return 0;
+    }
+    
+    int spd = timeline->slots_per_day;
+    int64_t total = 0;
+    for (int i = 0; i < timeline->task_count; i++) {
+        const TimelineTask* task = &timeline->tasks[i];
+        int slot = task->assigned_slot;
+        if (slot < 0) {
+            continue;
+        }
+        int category = task->category >= 0 && task->category < TASK_CATEGORY_COUNT ? task->category
+                                                                                : TASK_FIXED_CLASS;
+        int penalty = get_day_slot(slot, spd) > get_day_slot(task->deadline_slot, spd) ? 2 : 0;
+        total += peak_bonus(slot, category, config, spd) +
+                 2 * (get_day_index(task->deadline_slot, spd) - get_day_index(slot, spd)) - penalty;
+    }
+    return total;
+}
+
+/*
+ * Gaps are the maximal runs of free_mask, which every placement and
+ * removal keeps current, so a gap query reads the bitmap a word at a time
+ * in O(words + gaps) instead of walking slots[]. Runs end only where a
+ * slot is taken: with sleep disabled there are no blocked slots and a gap
+ * runs across midnight (its day_index is that of its start).
+ */
+typedef struct {
+    int start;
+    int len;
+} GapRun;
+
+/* Free runs of a timeline in slot order; runs needs room for (slot_count + 1) / 2 */
+static int collect_gap_runs(const WeeklyTimeline* timeline, GapRun* runs) {
+    int n = 0;
+    int words = timeline->occ_words;
+    int limit = timeline->slot_count;
+    for (int start = occ_next_set(timeline->free_mask, 0, words); start >= 0 && start < limit;) {
+        int end = occ_next_clear(timeline->free_mask, start, words);
+        end = end < limit ? end : limit;
+        GapRun run = { start, end - start };
+        runs[n++] = run;
+        start = occ_next_set(timeline->free_mask, end, words);
+    }
+    return n;
+}
+
+/* Best-fit order: shortest first, then earliest */
+static int compare_gap_runs(const void* a, const void* b) {
+    const GapRun* ra = (const GapRun*)a;
+    const GapRun* rb = (const GapRun*)b;
+    if (ra->len != rb->len) {
+        return ra->len < rb->len ? -1 : 1;
+    }
+    return (ra->start > rb->start) - (ra->start < rb->start);
+}
+
+/* fill_gaps order: higher priority, then longer, then input order */
+typedef struct {
+    int priority;
+    int duration;
+    int index;                     /* Into the caller's tasks */
+} FillKey;
+
+static int compare_fill_keys(const void* a, const void* b) {
+    const FillKey* ka = (const FillKey*)a;
+    const FillKey* kb = (const FillKey*)b;
+    
+    if (ka->priority != kb->priority) {
+        return ka->priority > kb->priority ? -1 : 1;
+    }
+    if (ka->duration != kb->duration) {
+        return ka->duration > kb->duration ? -1 : 1;
+    }
+    return (ka->index > kb->index) - (ka->index < kb->index);
+}
+
+static bool gap_timeline_valid(const WeeklyTimeline* timeline) {
+    return timeline && timeline_slots_valid(timeline) &&
+           timeline->occ_words >= (timeline->slot_count + 63) / 64 && timeline->occ_words <= OCC_WORDS;
+}
+
+/*
+ * Gaps of a timeline in slot order, classified by length in minutes.
+ * Up to max_gaps are written (gaps may be NULL when max_gaps is 0).
+ * Returns the number of gaps, which may exceed max_gaps.
+ */
+EXPORT int find_gaps(WeeklyTimeline* timeline, ScheduleGap* gaps, int max_gaps) {
+    if (!gap_timeline_valid(timeline) || (max_gaps > 0 && !gaps)) return 0;
+    STAT_CLOCK(lap);
+    
+    GapRun runs[(MAX_SLOTS + 1) / 2];
+    int n = collect_gap_runs(timeline, runs);
+    int spd = timeline->slots_per_day > 0 ? timeline->slots_per_day : SLOTS_PER_DAY;
+    int slot_minutes = MINUTES_PER_DAY / spd;
+    
+    for (int k = 0; k < n && k < max_gaps; k++) {
+        int minutes = runs[k].len * slot_minutes;
+        gaps[k].start_slot = runs[k].start;
+        gaps[k].end_slot = runs[k].start + runs[k].len;
+        gaps[k].duration_slots = runs[k].len;
+        gaps[k].day_index = get_day_index(runs[k].start, spd);
+        gaps[k].gap_type = minutes <= 30 ? 0 : (minutes <= 60 ? 1 : 2);  /* micro, standard, deep_work */
+    }
+    
+    stats_gap_scan(lap);
+    return n;
+}
+
+/*
+ * Best-fit small tasks (micro-gap items, revisions) into the free time of
+ * a solved timeline in one call. Tasks go in order of priority, then
+ * longest first, each at the start of the shortest gap that holds it
+ * before its deadline; is_locked and preferred_slot are not used. Slots
+ * and free_mask are updated and each task's assigned_slot is set (-1 if
+ * it did not fit); timeline->tasks and its counters are left alone.
+ * Returns the number of tasks placed, or -1 on invalid arguments or if
+ * memory runs out.
+ */
+EXPORT int fill_gaps(WeeklyTimeline* timeline, TimelineTask* tasks, int count) {
+    if (!gap_timeline_valid(timeline) || count < 0 || (count > 0 && !tasks)) {
+        return -1;
+    }
+    
+    GapRun runs[(MAX_SLOTS + 1) / 2];
+    FillKey* keys = (FillKey*)malloc(sizeof(FillKey) * (size_t)(count > 0 ? count : 1));
+    if (!keys) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        FillKey key = { tasks[i].priority, tasks[i].duration_slots, i };
+        keys[i] = key;
+        tasks[i].assigned_slot = -1;
+    }
+    qsort(keys, count, sizeof(FillKey), compare_fill_keys);
+    
+    int n = collect_gap_runs(timeline, runs);
+    qsort(runs, n, sizeof(GapRun), compare_gap_runs);
+    
+    int placed = 0;
+    for (int k = 0; k < count && n > 0; k++) {
+        TimelineTask* t = &tasks[keys[k].index];
+        int len = t->duration_slots;
+        if (len <= 0) {
+            continue;
+        }
+        
+        /* Shortest run that is long enough, then the first that ends in time */
+        int lo = 0;
+        int hi = n;
+        while (lo < hi) {
+            int mid = (lo + hi) / 2;
+            if (runs[mid].len < len) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        int r = lo;
+        while (r < n && runs[r].start + len > t->deadline_slot) {
+            r++;
+        }
+        if (r == n) {
+            continue;
+        }
+        
+        mark_slots(timeline, runs[r].start, len, t->id);
+        t->assigned_slot = runs[r].start;
+        placed++;
+        
+        /* The rest of the run stays a gap; shorter now, so it moves left */
+        GapRun rest = { runs[r].start + len, runs[r].len - len };
+        if (rest.len == 0) {
+            memmove(&runs[r], &runs[r + 1], sizeof(GapRun) * (size_t)(n - r - 1));
+            n--;
+            continue;
+        }
+        while (r > 0 && compare_gap_runs(&runs[r - 1], &rest) > 0) {
+            runs[r] = runs[r - 1];
+            r--;
+        }
+        runs[r] = rest;
+    }
+    
+    free(keys);
+    return placed;
+}
+
+/*
+ * find_gaps into a buffer from the context, sized for the worst case.
+ * Returns the gap count (0 with *out NULL if the arena cannot grow).
+ */
+EXPORT int find_gaps_ctx(EngineContext* ctx, WeeklyTimeline* timeline, ScheduleGap** out) {
+    if (!out) {
+        return 0;
+    }
+    
+    int max_gaps = timeline ? (timeline->slot_count + 1) / 2 : 0;
+    *out = ctx && max_gaps > 0 ? (ScheduleGap*)arena_alloc(ctx->arena, sizeof(ScheduleGap) * max_gaps) : NULL;
+    if (!*out) {
+        return 0;
+    }
+    return find_gaps(timeline, *out, max_gaps);
+}
+
+/* ============================================
+ * VERSION INFO
+ * ============================================ */
+
+EXPORT const char* get_engine_version(void) {
+    return "1.0.0";
+}
+
+/* Granularity of the calling thread's most recent solve (48 before any) */
+EXPORT int get_slots_per_day(void) {
+    return g_active_grid.slots_per_day;
+}
+
+/* Horizon length in slots of the calling thread's most recent solve */
+EXPORT int get_week_slots(void) {
+    return g_active_grid.slot_count;
+}
+
+EXPORT int get_max_slots(void) {
+    return MAX_SLOTS;
+}
+
+/* Slot storage a solve with config, or on base, needs (batch out[].slot_capacity) */
+EXPORT int get_solve_slots(const OptimizationConfig* config, const TimelineBase* base) {
+    return solve_slot_count(config, base);
+}
+
+/* Vector instruction set chosen at load time for slot scoring */
+EXPORT const char* get_engine_simd(void) {
+    return score_simd_name();
+}
+
+/* Name of a portfolio strategy (WeeklyTimeline.solve_strategy), or NULL */
+EXPORT const char* get_strategy_name(int strategy) {
+    return strategy >= 0 && strategy < PORTFOLIO_SIZE ? g_portfolio[strategy].name : NULL;
 }
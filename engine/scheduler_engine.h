@@ -0,0 +1,360 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * scheduler_engine.h - Public types and entry points of the timeline solver
+ *
+ * What the shared library exports, for C callers (the bench harness).
+ * backend/bridge.py mirrors the same structures with ctypes, so any
+ * layout change here has to be made there too.
+ */
+
+#ifndef SCHEDULER_ENGINE_H
+#define SCHEDULER_ENGINE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "arena.h"
+
+/* ============================================
+ * PLATFORM-SPECIFIC EXPORTS
+ * ============================================ */
+
+#ifdef _WIN32
+    #define EXPORT __declspec(dllexport)
+#else
+    #define EXPORT __attribute__((visibility("default")))
+#endif
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define MAX_TITLE_LEN 200
+#define MAX_SUBJECT_LEN 20
+#define SLOTS_PER_DAY 48       /* Default granularity: 30-minute slots */
+#define WEEK_SLOTS 336         /* Default horizon: 7 days * 48 slots */
+#define MINUTES_PER_DAY 1440
+#define MAX_HORIZON_WEEKS 4
+#define MAX_SLOTS_PER_DAY 96   /* 15-minute slots */
+#define MAX_SLOTS (MAX_HORIZON_WEEKS * 7 * MAX_SLOTS_PER_DAY)
+#define EMPTY_SLOT -1
+#define BLOCKED_SLOT -2        /* Sleep or other blocked time */
+#define OCC_WORDS ((MAX_SLOTS + 63) / 64)  /* 64-bit words per slot bitmap (largest grid) */
+#define TASK_CATEGORY_COUNT 10
+
+/* ============================================
+ * ENUMS
+ * ============================================ */
+
+typedef enum {
+    TASK_FIXED_CLASS = 0,      /* University lectures (immutable) */
+    TASK_STUDY_CONCEPT = 1,    /* Conceptual learning (morning priority) */
+    TASK_STUDY_PRACTICE = 2,   /* Practice problems (evening priority) */
+    TASK_MICRO_GAP = 3,        /* 15-30 min tasks */
+    TASK_SLEEP = 4,            /* Rest blocks */
+    TASK_BREAK = 5,            /* Break periods */
+    TASK_MEAL = 6,             /* Meal times */
+    TASK_REVISION = 7,         /* Spaced repetition */
+    TASK_ASSIGNMENT = 8,       /* Assignment work */
+    TASK_LAB_WORK = 9          /* Lab report work */
+} TaskCategory;
+
+typedef enum {
+    ENGINE_OK = 0,
+    ENGINE_ERROR_GRID = 1,         /* Unsupported horizon or slot granularity */
+    ENGINE_ERROR_CAPACITY = 2,     /* Over-committed: stopped before the search */
+    ENGINE_ERROR_CANCELLED = 3,    /* Cancel flag set or progress callback asked to stop */
+    ENGINE_ERROR_DEADLINE = 4,     /* SolveOptions deadline passed */
+    ENGINE_ERROR_STORAGE = 5       /* Batch out[].slot_capacity too small for the grid */
+} EngineError;
+
+typedef enum {
+    SEARCH_GREEDY = 0,             /* Single greedy pass */
+    SEARCH_BRANCH_AND_BOUND = 1,   /* Anytime branch-and-bound seeded by greedy */
+    SEARCH_PORTFOLIO = 2           /* Orders and searches raced on the engine threads */
+} SearchMode;
+
+typedef enum {
+    ENGINE_PHASE_GREEDY = 0,
+    ENGINE_PHASE_SEARCH = 1,       /* Branch and bound */
+    ENGINE_PHASE_LOCAL_SEARCH = 2,
+    ENGINE_PHASE_BATCH = 3         /* Whole batch call: work counts solved users */
+} EnginePhase;
+
+typedef enum {
+    VIOLATION_OVERLAP = 1,         /* Task's slots claimed by another task (other_id) */
+    VIOLATION_DEADLINE = 2,        /* Slots past deadline_slot */
+    VIOLATION_BLOCKED = 3,         /* Non-sleep task in the sleep window */
+    VIOLATION_LOCKED_MOVED = 4,    /* Locked task not at its preferred_slot */
+    VIOLATION_OUT_OF_RANGE = 5,    /* Slots past the end of the horizon */
+    VIOLATION_SLOT_MISMATCH = 6    /* slots[] disagrees with assigned_slot (other_id: what it holds) */
+} ViolationCode;
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+/* Task to be placed in timeline */
+typedef struct {
+    int id;
+    int duration_slots;        /* Duration in slots of the solve's granularity */
+    int priority;              /* 1-10, higher = more important */
+    int category;              /* TaskCategory enum value */
+    int deadline_slot;         /* Absolute slot index for deadline */
+    bool is_locked;            /* If true, cannot be moved */
+    char title[MAX_TITLE_LEN];
+    char subject[MAX_SUBJECT_LEN];
+    int preferred_slot;        /* Preferred placement (-1 for none) */
+    int assigned_slot;         /* Assigned slot after optimization */
+} TimelineTask;
+
+/* Optimization configuration (slot fields use the configured granularity) */
+typedef struct {
+    int sleep_start_slot;      /* Slot when sleep begins (22:00 = 44) */
+    int sleep_end_slot;        /* Slot when sleep ends (06:00 = 12) */
+    int concept_peak_start;    /* Morning peak start (08:00 = 16) */
+    int concept_peak_end;      /* Morning peak end (12:00 = 24) */
+    int practice_peak_start;   /* Evening peak start (16:00 = 32) */
+    int practice_peak_end;     /* Evening peak end (20:00 = 40) */
+    int deep_work_min_slots;   /* Min slots for deep work (3 = 90 min) */
+    int micro_gap_max_slots;   /* Max slots for micro-gaps (1 = 30 min) */
+    bool enable_heuristics;    /* Enable energy-based placement */
+    int horizon_weeks;         /* 1-MAX_HORIZON_WEEKS (0 = 1) */
+    int slot_minutes;          /* 15, 30 or 60 (0 = 30) */
+} OptimizationConfig;
+
+/* Where a solve is, passed to a SolveOptions progress callback */
+typedef struct {
+    int phase;                 /* EnginePhase */
+    int64_t elapsed_us;        /* Since the call started */
+    int64_t work;              /* Greedy tasks tried, search nodes, local-search moves or users */
+    int placed;                /* Tasks placed in the best assignment so far */
+    int task_count;            /* Tasks in the solve (users in a batch) */
+} EngineProgress;
+
+/* Runs on the calling thread; return nonzero to cancel the solve */
+typedef int (*EngineProgressFn)(const EngineProgress* progress, void* user);
+
+/* Per-solve search options (NULL = greedy only). Local search runs after
+ * the search when either improve_ field is set. A portfolio gives the
+ * search budget to each branch-and-bound worker and the improve_ budget
+ * (default: the time limit) to each local-search worker. deadline_us,
+ * cancel and progress cover the whole call, every phase included: a
+ * solve they stop returns its best assignment so far with status -2 */
+typedef struct {
+    int search_mode;           /* SearchMode enum value */
+    int time_limit_ms;         /* Search wall-clock budget (0 = unlimited) */
+    int64_t node_limit;        /* Max search nodes (0 = unlimited) */
+    int64_t improve_iterations; /* Local-search moves after the solve (0 = no limit) */
+    int64_t improve_time_us;    /* Local-search budget in microseconds (0 = no limit) */
+    int64_t deadline_us;       /* engine_clock_us() time to stop at (0 = none) */
+    const int32_t* cancel;     /* Stop once another thread sets it nonzero (NULL = none) */
+    EngineProgressFn progress; /* NULL = no reports */
+    void* progress_user;
+    int progress_interval_ms;  /* Min time between reports (0 = 100 ms) */
+} SolveOptions;
+
+/*
+ * Weekly timeline result. slots points at storage sized to the grid: the
+ * engine's own timelines carry it right after the struct, and a batch
+ * caller provides it with each out[] entry (see optimize_timeline_batch)
+ */
+typedef struct {
+    int* slots;                /* Task ID in each slot (-1 = empty), slot_count of them */
+    int slot_capacity;         /* Ints of storage behind slots */
+    int slot_count;            /* Slots in the horizon */
+    int slots_per_day;
+    int occ_words;             /* Words of each mask in use */
+    TimelineTask* tasks;
+    int task_count;
+    int optimization_status;   /* 0=success, -1=unsolvable, -2=timeout or cancelled */
+    int error_code;
+    int total_gaps_filled;
+    int total_conflicts;
+    uint64_t free_mask[OCC_WORDS];  /* Bit set = slot is EMPTY_SLOT */
+    uint64_t sleep_mask[OCC_WORDS]; /* Bit set = slot is in the sleep window */
+    int solve_strategy;        /* Portfolio strategy that won (-1 = not a portfolio solve) */
+} WeeklyTimeline;
+
+/* Memory owner for a series of solves (reset between requests) */
+typedef struct {
+    Arena* arena;
+} EngineContext;
+
+/* Gap in schedule */
+typedef struct {
+    int start_slot;
+    int end_slot;
+    int duration_slots;
+    int day_index;
+    int gap_type;              /* 0=micro, 1=standard, 2=deep_work */
+} ScheduleGap;
+
+/*
+ * Flat int arrays describing a solve result, in input order, for callers
+ * that wrap them directly (see timeline_result_view)
+ */
+typedef struct {
+    const int* slots;          /* The timeline's own slot grid */
+    int slot_count;
+    const int* task_ids;
+    const int* assigned;       /* assigned_slot of each task */
+    int task_count;
+    const int* conflicts;      /* Ids of tasks left unplaced */
+    int conflict_count;
+    const int* changed;        /* Input indices whose assigned_slot changed */
+    int changed_count;
+} ResultView;
+
+/*
+ * Capacity verdict of check_feasibility. Passing is necessary, not
+ * sufficient: fragmentation can still leave conflicts
+ */
+typedef struct {
+    int feasible;              /* 1 = every task passes the capacity check */
+    int demand_slots;          /* Slots wanted by the tasks left to place */
+    int capacity_slots;        /* Free slots outside sleep after locked tasks */
+    int shortfall_slots;       /* Most any deadline's demand exceeds its capacity by */
+    int first_overflow_slot;   /* Earliest deadline that overflows (-1 = none) */
+    int drop_count;            /* Fewest tasks to drop or move past their deadline */
+} FeasibilityReport;
+
+/* One problem found by validate_constraints_ex, over slots [start_slot, end_slot) */
+typedef struct {
+    int code;                  /* ViolationCode */
+    int task_id;
+    int start_slot;
+    int end_slot;
+    int other_id;              /* Task or slot value involved (-1 = none) */
+} ConstraintViolation;
+
+/*
+ * One candidate's outcome from timeline_what_if: what inserting it (a new
+ * id) or replacing the task with its id would do to the open timeline
+ */
+typedef struct {
+    int task_id;
+    int best_slot;             /* Start the candidate would get (-1 = it would be a conflict) */
+    int score_delta;           /* Change in timeline_placement_score */
+    int conflicts;             /* Change in total_conflicts (negative = a conflict resolved) */
+    int moved;                 /* Placed tasks moved elsewhere to make room */
+} WhatIfResult;
+
+/* Result cache counters (see engine_cache_stats) */
+typedef struct {
+    int64_t hits;
+    int64_t misses;
+    int64_t evictions;         /* Entries replaced to make room */
+    int entries;               /* Results held now */
+    int capacity;              /* 0 = cache off */
+} EngineCacheStats;
+
+/*
+ * Engine counters and phase timings (see get_engine_stats). Every field is
+ * an int64_t, so the engine can sum the struct field by field
+ */
+typedef struct {
+    int64_t solves;            /* Solves, timeline_open, incremental edits and what-if calls */
+    int64_t can_place_calls;   /* can_place_task checks */
+    int64_t slots_scanned;     /* Candidate start slots scored */
+    int64_t placements;
+    int64_t backtracks;        /* Branch-and-bound levels exhausted */
+    int64_t cache_hits;
+    int64_t cache_misses;
+    int64_t arena_bytes;       /* Context arena in use when the solve returned */
+    int64_t setup_us;          /* Cache lookup, task set and score tables */
+    int64_t sleep_us;          /* Blocking the sleep window (or copying a base) */
+    int64_t locked_us;         /* Force-placing locked tasks */
+    int64_t search_us;         /* Feasibility check, search and local search */
+    int64_t gap_scan_us;       /* find_gaps calls */
+} EngineStats;
+
+/* Immutable sleep window and classes shared by many solves (see timeline_base_create) */
+typedef struct TimelineBase TimelineBase;
+
+/* Persistent timeline for incremental edits (see timeline_open) */
+typedef struct TimelineHandle TimelineHandle;
+
+/* ============================================
+ * FUNCTION PROTOTYPES
+ * ============================================ */
+
+/* Solving (each function is documented at its definition). The plain
+ * versions return a malloc'ed timeline for free_timeline_memory */
+EXPORT WeeklyTimeline* optimize_timeline(TimelineTask* tasks, int count, OptimizationConfig* config);
+EXPORT WeeklyTimeline* optimize_timeline_ex(TimelineTask* tasks, int count, OptimizationConfig* config,
+                                            const SolveOptions* options);
+EXPORT void free_timeline_memory(WeeklyTimeline* timeline);
+EXPORT int check_feasibility(const TimelineTask* tasks, int count, const OptimizationConfig* config,
+                             FeasibilityReport* report, int* drop_ids, int max_drop);
+EXPORT int optimize_timeline_batch(const TimelineTask* tasks, const int* offsets, int n_users,
+                                   const OptimizationConfig* cfgs, WeeklyTimeline* out);
+EXPORT int optimize_timeline_batch_base(const TimelineTask* tasks, const int* offsets, int n_users,
+                                        const OptimizationConfig* cfgs, const TimelineBase* const* bases,
+                                        WeeklyTimeline* out);
+EXPORT int optimize_timeline_batch_ex(const TimelineTask* tasks, const int* offsets, int n_users,
+                                      const OptimizationConfig* cfgs, const TimelineBase* const* bases,
+                                      const SolveOptions* options, WeeklyTimeline* out);
+EXPORT int64_t engine_clock_us(void);
+EXPORT int set_engine_threads(int n_threads);
+EXPORT int get_engine_threads(void);
+
+/* Contexts: everything a _ctx call returns lives until the next reset */
+EXPORT EngineContext* engine_context_create(size_t block_size);
+EXPORT void engine_context_reset(EngineContext* ctx);
+EXPORT void engine_context_destroy(EngineContext* ctx);
+EXPORT void engine_context_stats(const EngineContext* ctx, ArenaStats* out);
+EXPORT WeeklyTimeline* optimize_timeline_ctx(EngineContext* ctx, const TimelineTask* tasks, int count,
+                                             const OptimizationConfig* config, const SolveOptions* options);
+EXPORT WeeklyTimeline* optimize_timeline_base_ctx(EngineContext* ctx, const TimelineBase* base,
+                                                  const TimelineTask* tasks, int count,
+                                                  const SolveOptions* options);
+EXPORT int timeline_result_view(EngineContext* ctx, const WeeklyTimeline* timeline,
+                                const TimelineTask* input, ResultView* out);
+EXPORT int find_gaps_ctx(EngineContext* ctx, WeeklyTimeline* timeline, ScheduleGap** out);
+
+/* Base timelines: one section's classes, built once and solved on by many */
+EXPORT TimelineBase* timeline_base_create(const TimelineTask* classes, int count,
+                                          const OptimizationConfig* config);
+EXPORT void timeline_base_destroy(TimelineBase* base);
+
+/* Result cache: repeat solves of the same tasks, config and options */
+EXPORT int engine_cache_configure(int capacity);
+EXPORT void engine_cache_invalidate(void);
+EXPORT void engine_cache_stats(EngineCacheStats* out);
+
+/* Incremental timelines */
+EXPORT TimelineHandle* timeline_open(const TimelineTask* tasks, int count,
+                                     const OptimizationConfig* config);
+EXPORT int timeline_insert_task(TimelineHandle* h, const TimelineTask* task);
+EXPORT int timeline_remove_task(TimelineHandle* h, int task_id);
+EXPORT const WeeklyTimeline* timeline_get(TimelineHandle* h);
+EXPORT int timeline_what_if(const TimelineHandle* h, const TimelineTask* candidates, int count,
+                            WhatIfResult* out);
+EXPORT void timeline_close(TimelineHandle* h);
+
+/* Results */
+EXPORT size_t timeline_to_json(const WeeklyTimeline* timeline, char* buf, size_t cap);
+EXPORT int validate_constraints(WeeklyTimeline* timeline);
+EXPORT int validate_constraints_ex(const WeeklyTimeline* timeline, ConstraintViolation* out, int max_out);
+/* Returns the total gap count, which can exceed max_gaps: only the first
+ * max_gaps are written, so loop up to the smaller of the two */
+EXPORT int find_gaps(WeeklyTimeline* timeline, ScheduleGap* gaps, int max_gaps);
+EXPORT int fill_gaps(WeeklyTimeline* timeline, TimelineTask* tasks, int count);
+EXPORT int64_t timeline_placement_score(const WeeklyTimeline* timeline, const OptimizationConfig* config);
+
+/* Instrumentation (compiled out with -DENGINE_NO_STATS) */
+EXPORT int get_engine_stats(EngineStats* last_solve, EngineStats* totals);
+EXPORT void reset_engine_stats(void);
+
+/* Version and geometry */
+EXPORT const char* get_engine_version(void);
+EXPORT int get_slots_per_day(void);
+EXPORT int get_week_slots(void);
+EXPORT int get_max_slots(void);
+EXPORT int get_solve_slots(const OptimizationConfig* config, const TimelineBase* base);
+EXPORT const char* get_engine_simd(void);
+EXPORT const char* get_strategy_name(int strategy);
+
+#endif /* SCHEDULER_ENGINE_H */
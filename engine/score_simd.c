@@ -0,0 +1,245 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * score_simd.c - Vectorized best-score reduction for slot placement
+ *
+ * Each variant walks the mask one 64-bit word at a time, skips empty
+ * words, and expands the word's bits into lane masks so that slots not
+ * in the mask contribute INT_MIN to a running lane-wise maximum. x86
+ * variants are compiled with per-function target attributes, so the
+ * library still runs on CPUs without AVX2 or AVX-512.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "score_simd.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__) && defined(__SSE2__)
+    #define SCORE_SIMD_X86 1
+    #include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    #define SCORE_SIMD_NEON 1
+    #include <arm_neon.h>
+#endif
+
+typedef int (*ScoreMaxFn)(const int* row, const int* day_slot, int deadline_slot,
+                          const uint64_t* mask, int words);
+
+/* ============================================
+ * PORTABLE C
+ * ============================================ */
+
+static int score_max_scalar(const int* row, const int* day_slot, int deadline_slot,
+                            const uint64_t* mask, int words) {
+    int best = INT_MIN;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = mask[w];
+        if (!bits) {
+            continue;
+        }
+        const int* r = row + (w << 6);
+        const int* d = day_slot + (w << 6);
+        for (int j = 0; j < 64; j++) {
+            int v = r[j] - (d[j] > deadline_slot ? 2 : 0);
+            v = ((bits >> j) & 1) ? v : INT_MIN;
+            best = v > best ? v : best;
+        }
+    }
+    return best;
+}
+
+/* ============================================
+ * X86: SSE2 / AVX2 / AVX-512
+ * ============================================ */
+
+#ifdef SCORE_SIMD_X86
+
+/* SSE2 has no signed 32-bit max or blend, so both are built from compares */
+static int score_max_sse2(const int* row, const int* day_slot, int deadline_slot,
+                          const uint64_t* mask, int words) {
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+    const __m128i empty = _mm_set1_epi32(INT_MIN);
+    const __m128i threshold = _mm_set1_epi32(deadline_slot);
+    const __m128i two = _mm_set1_epi32(2);
+    __m128i best = empty;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = mask[w];
+        if (!bits) {
+            continue;
+        }
+        for (int k = 0; k < 16; k++) {
+            int nibble = (int)((bits >> (k * 4)) & 0xF);
+            if (!nibble) {
+                continue;
+            }
+            int base = (w << 6) + k * 4;
+            __m128i sel = _mm_and_si128(_mm_set1_epi32(nibble), lane_bits);
+            __m128i in_mask = _mm_cmpeq_epi32(sel, lane_bits);
+
+            __m128i late = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(day_slot + base)), threshold);
+            __m128i v = _mm_sub_epi32(_mm_loadu_si128((const __m128i*)(row + base)),
+                                      _mm_and_si128(late, two));
+            v = _mm_or_si128(_mm_and_si128(in_mask, v), _mm_andnot_si128(in_mask, empty));
+
+            __m128i gt = _mm_cmpgt_epi32(v, best);
+            best = _mm_or_si128(_mm_and_si128(gt, v), _mm_andnot_si128(gt, best));
+        }
+    }
+
+    int lanes[4];
+    _mm_storeu_si128((__m128i*)lanes, best);
+    int result = lanes[0];
+    for (int i = 1; i < 4; i++) {
+        result = lanes[i] > result ? lanes[i] : result;
+    }
+    return result;
+}
+
+__attribute__((target("avx2")))
+static int score_max_avx2(const int* row, const int* day_slot, int deadline_slot,
+                          const uint64_t* mask, int words) {
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i empty = _mm256_set1_epi32(INT_MIN);
+    const __m256i threshold = _mm256_set1_epi32(deadline_slot);
+    const __m256i two = _mm256_set1_epi32(2);
+    __m256i best = empty;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = mask[w];
+        if (!bits) {
+            continue;
+        }
+        for (int k = 0; k < 8; k++) {
+            int byte = (int)((bits >> (k * 8)) & 0xFF);
+            if (!byte) {
+                continue;
+            }
+            int base = (w << 6) + k * 8;
+            __m256i sel = _mm256_and_si256(_mm256_set1_epi32(byte), lane_bits);
+            __m256i in_mask = _mm256_cmpeq_epi32(sel, lane_bits);
+
+            __m256i late = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(day_slot + base)), threshold);
+            __m256i v = _mm256_sub_epi32(_mm256_loadu_si256((const __m256i*)(row + base)),
+                                         _mm256_and_si256(late, two));
+            v = _mm256_blendv_epi8(empty, v, in_mask);
+            best = _mm256_max_epi32(best, v);
+        }
+    }
+
+    __m128i m = _mm_max_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(m);
+}
+
+/* AVX-512 masks lanes directly with the bits of the occupancy word */
+__attribute__((target("avx512f")))
+static int score_max_avx512(const int* row, const int* day_slot, int deadline_slot,
+                            const uint64_t* mask, int words) {
+    const __m512i threshold = _mm512_set1_epi32(deadline_slot);
+    const __m512i two = _mm512_set1_epi32(2);
+    __m512i best = _mm512_set1_epi32(INT_MIN);
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = mask[w];
+        if (!bits) {
+            continue;
+        }
+        for (int k = 0; k < 4; k++) {
+            __mmask16 in_mask = (__mmask16)((bits >> (k * 16)) & 0xFFFF);
+            if (!in_mask) {
+                continue;
+            }
+            int base = (w << 6) + k * 16;
+            __m512i r = _mm512_loadu_si512((const void*)(row + base));
+            __mmask16 late = _mm512_cmpgt_epi32_mask(_mm512_loadu_si512((const void*)(day_slot + base)),
+                                                     threshold);
+            __m512i v = _mm512_mask_sub_epi32(r, late, r, two);
+            best = _mm512_mask_max_epi32(best, in_mask, best, v);
+        }
+    }
+    return _mm512_reduce_max_epi32(best);
+}
+
+#endif /* SCORE_SIMD_X86 */
+
+/* ============================================
+ * AARCH64: NEON
+ * ============================================ */
+
+#ifdef SCORE_SIMD_NEON
+
+static int score_max_neon(const int* row, const int* day_slot, int deadline_slot,
+                          const uint64_t* mask, int words) {
+    static const uint32_t lane_bit_values[4] = { 1, 2, 4, 8 };
+    const uint32x4_t lane_bits = vld1q_u32(lane_bit_values);
+    const int32x4_t empty = vdupq_n_s32(INT_MIN);
+    const int32x4_t threshold = vdupq_n_s32(deadline_slot);
+    const int32x4_t two = vdupq_n_s32(2);
+    int32x4_t best = empty;
+
+    for (int w = 0; w < words; w++) {
+        uint64_t bits = mask[w];
+        if (!bits) {
+            continue;
+        }
+        for (int k = 0; k < 16; k++) {
+            uint32_t nibble = (uint32_t)((bits >> (k * 4)) & 0xF);
+            if (!nibble) {
+                continue;
+            }
+            int base = (w << 6) + k * 4;
+            uint32x4_t in_mask = vtstq_u32(vdupq_n_u32(nibble), lane_bits);
+
+            uint32x4_t late = vcgtq_s32(vld1q_s32(day_slot + base), threshold);
+            int32x4_t v = vsubq_s32(vld1q_s32(row + base),
+                                    vandq_s32(vreinterpretq_s32_u32(late), two));
+            v = vbslq_s32(in_mask, v, empty);
+            best = vmaxq_s32(best, v);
+        }
+    }
+    return vmaxvq_s32(best);
+}
+
+#endif /* SCORE_SIMD_NEON */
+
+/* ============================================
+ * RUNTIME DISPATCH
+ * ============================================ */
+
+static pthread_once_t g_kernel_once = PTHREAD_ONCE_INIT;
+static ScoreMaxFn g_kernel = score_max_scalar;
+static const char* g_kernel_name = "scalar";
+
+static void select_kernel(void) {
+#if defined(SCORE_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        g_kernel = score_max_avx512;
+        g_kernel_name = "avx512";
+    } else if (__builtin_cpu_supports("avx2")) {
+        g_kernel = score_max_avx2;
+        g_kernel_name = "avx2";
+    } else {
+        g_kernel = score_max_sse2;
+        g_kernel_name = "sse2";
+    }
+#elif defined(SCORE_SIMD_NEON)
+    g_kernel = score_max_neon;
+    g_kernel_name = "neon";
+#endif
+}
+
+int score_masked_max(const int* row, const int* day_slot, int deadline_slot,
+                     const uint64_t* mask, int words) {
+    pthread_once(&g_kernel_once, select_kernel);
+    return g_kernel(row, day_slot, deadline_slot, mask, words);
+}
+
+const char* score_simd_name(void) {
+    pthread_once(&g_kernel_once, select_kernel);
+    return g_kernel_name;
+}
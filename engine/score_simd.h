@@ -0,0 +1,27 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * score_simd.h - Vectorized best-score reduction for slot placement
+ *
+ * score_masked_max returns the maximum, over every set bit j of mask, of
+ *
+ *     row[j] - (day_slot[j] > deadline_slot ? 2 : 0)
+ *
+ * or INT_MIN when mask is empty. row and day_slot must hold words * 64
+ * entries. The implementation is picked once at runtime from the CPU
+ * (AVX-512, AVX2 or SSE2 on x86, NEON on AArch64, portable C otherwise);
+ * every variant returns the same value, so callers that resolve ties by
+ * scanning for the earliest slot reaching it get identical placements.
+ */
+
+#ifndef SCORE_SIMD_H
+#define SCORE_SIMD_H
+
+#include <stdint.h>
+
+int score_masked_max(const int* row, const int* day_slot, int deadline_slot,
+                     const uint64_t* mask, int words);
+
+/* Name of the selected implementation ("avx512", "avx2", "sse2", "neon", "scalar") */
+const char* score_simd_name(void);
+
+#endif /* SCORE_SIMD_H */
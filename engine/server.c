@@ -0,0 +1,1046 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * server.c - Request server over a Unix socket (--serve)
+ *
+ * One thread runs a poll loop over the listening socket and up to
+ * SERVER_MAX_CLIENTS non-blocking clients. Each client has an input
+ * buffer holding the bytes of lines not yet complete and an output
+ * buffer of replies not yet written. Requests are parsed in place in
+ * the input buffer and replies rendered straight into the output
+ * buffer, so a steady stream of requests allocates nothing.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "server.h"
+
+#ifdef _WIN32
+
+int serve_requests(const char* socket_path, DailySchedule* schedule, const char* schedule_file,
+                   PriorityQueue* pq, const char* lab_file) {
+    (void)socket_path; (void)schedule; (void)schedule_file; (void)pq; (void)lab_file;
+    fprintf(stderr, "Error: --serve needs Unix domain sockets\n");
+    return -1;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define REQUEST_MAX_FIELDS 16
+#define READS_PER_PASS 16              /* Reads from one client before others get a turn */
+#define REPLY_INITIAL_CAPACITY 4096
+#define EDIT_NOT_SAVED "edit may not have been saved; server stopping"
+#define SERVER_STOPPING "server is stopping"
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+/* One member of a request object; strings point into the line */
+typedef struct {
+    const char* key;
+    bool is_string;
+    const char* text;
+    long long number;          /* Numbers, and true / false as 1 / 0 */
+} Field;
+
+typedef struct {
+    Field fields[REQUEST_MAX_FIELDS];
+    int count;
+} Request;
+
+typedef enum {
+    REPLY_ERROR,
+    REPLY_OK,
+    REPLY_GAPS,
+    REPLY_SCHEDULE,
+    REPLY_QUEUE,               /* Listing limited by limit and before */
+    REPLY_CREATED              /* {"id": value} */
+} ReplyKind;
+
+typedef struct {
+    ReplyKind kind;
+    const char* error;
+    long long value;
+    int limit;                 /* Queue listings: -1 for all */
+    bool bounded;              /* Queue listings: only reports due before */
+    time_t before;
+    const Field* id;           /* Request id to echo, or NULL */
+    bool edit;                 /* Acknowledges a journaled edit: ok only once it is synced */
+} Reply;
+
+typedef struct {
+    int fd;
+    char* in;                  /* SERVER_LINE_MAX bytes */
+    size_t in_len;
+    char* out;
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    bool eof;                  /* Nothing more will be read */
+    bool broken;               /* Nothing more can be written */
+} Client;
+
+/* An edit reply rendered this pass, and what replaces it if the sync fails */
+typedef struct {
+    int client;                /* Index into Server.clients */
+    size_t start;              /* Reply bytes in the client's out buffer */
+    size_t len;
+    char* failure;             /* Rendered error reply (malloc) */
+    size_t failure_len;
+} PendingEdit;
+
+typedef struct {
+    DailySchedule* schedule;
+    const char* schedule_file;
+    PriorityQueue* pq;
+    const char* lab_file;
+    int listen_fd;
+    Client clients[SERVER_MAX_CLIENTS];
+    int client_count;
+    bool dirty;                /* Edits journaled in this pass, not yet synced */
+    PendingEdit* pending;      /* Their replies, in the order they were queued */
+    int pending_count;
+    int pending_cap;
+    bool stop;
+    bool lost;                 /* An edit could not be saved: take no more */
+} Server;
+
+static volatile sig_atomic_t g_signalled = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    g_signalled = 1;
+}
+
+/* ============================================
+ * REQUEST PARSING
+ * ============================================ */
+
+static char* skip_space(char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r') {
+        p++;
+    }
+    return p;
+}
+
+static bool parse_hex4(const char* p, unsigned* out) {
+    unsigned value = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') {
+            value |= (unsigned)(c - '0');
+        } else if (c >= 'a' && c <= 'f') {
+            value |= (unsigned)(c - 'a' + 10);
+        } else if (c >= 'A' && c <= 'F') {
+            value |= (unsigned)(c - 'A' + 10);
+        } else {
+            return false;
+        }
+    }
+    *out = value;
+    return true;
+}
+
+static char* put_utf8(char* dst, unsigned cp) {
+    if (cp < 0x80) {
+        *dst++ = (char)cp;
+    } else if (cp < 0x800) {
+        *dst++ = (char)(0xC0 | (cp >> 6));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        *dst++ = (char)(0xE0 | (cp >> 12));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    } else {
+        *dst++ = (char)(0xF0 | (cp >> 18));
+        *dst++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+        *dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+        *dst++ = (char)(0x80 | (cp & 0x3F));
+    }
+    return dst;
+}
+
+/*
+ * Unescape the string whose opening quote precedes p, in place (the
+ * result is never longer than its escaped form). Returns the position
+ * after the closing quote, or NULL if the string is malformed.
+ */
+static char* parse_string(char* p, const char** out) {
+    char* dst = p;
+    *out = p;
+    while (*p != '"') {
+        unsigned char c = (unsigned char)*p;
+        if (c < 0x20) {
+            return NULL;           /* Includes the end of the line */
+        }
+        if (c != '\\') {
+            *dst++ = *p++;
+            continue;
+        }
+        p++;
+        switch (*p++) {
+        case '"':  *dst++ = '"';  break;
+        case '\\': *dst++ = '\\'; break;
+        case '/':  *dst++ = '/';  break;
+        case 'b':  *dst++ = '\b'; break;
+        case 'f':  *dst++ = '\f'; break;
+        case 'n':  *dst++ = '\n'; break;
+        case 'r':  *dst++ = '\r'; break;
+        case 't':  *dst++ = '\t'; break;
+        case 'u': {
+            unsigned cp, low;
+            if (!parse_hex4(p, &cp)) {
+                return NULL;
+            }
+            p += 4;
+            if (cp >= 0xD800 && cp < 0xDC00 && p[0] == '\\' && p[1] == 'u' &&
+                parse_hex4(p + 2, &low) && low >= 0xDC00 && low < 0xE000) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                p += 6;
+            } else if (cp >= 0xD800 && cp < 0xE000) {
+                cp = 0xFFFD;       /* Unpaired surrogate */
+            }
+            dst = put_utf8(dst, cp);
+            break;
+        }
+        default:
+            return NULL;
+        }
+    }
+    *dst = '\0';
+    return p + 1;
+}
+
+/* Parse one flat object; returns NULL or what is wrong with the line */
+static const char* parse_request(char* line, Request* req) {
+    req->count = 0;
+    char* p = skip_space(line);
+    if (*p != '{') {
+        return "expected a JSON object";
+    }
+    p = skip_space(p + 1);
+
+    while (*p != '}') {
+        Field field = {0};
+        if (*p != '"' || !(p = parse_string(p + 1, &field.key))) {
+            return "expected a string key";
+        }
+        p = skip_space(p);
+        if (*p != ':') {
+            return "expected ':' after a key";
+        }
+        p = skip_space(p + 1);
+
+        bool present = true;
+        if (*p == '"') {
+            field.is_string = true;
+            if (!(p = parse_string(p + 1, &field.text))) {
+                return "malformed string";
+            }
+        } else if (*p == '-' || (*p >= '0' && *p <= '9')) {
+            char* end;
+            errno = 0;
+            field.number = strtoll(p, &end, 10);
+            if (end == p || errno == ERANGE || *end == '.' || *end == 'e' || *end == 'E') {
+                return "numbers must be integers";
+            }
+            p = end;
+        } else if (strncmp(p, "true", 4) == 0) {
+            field.number = 1;
+            p += 4;
+        } else if (strncmp(p, "false", 5) == 0) {
+            field.number = 0;
+            p += 5;
+        } else if (strncmp(p, "null", 4) == 0) {
+            present = false;       /* Same as leaving the member out */
+            p += 4;
+        } else {
+            return "values must be strings, integers or booleans";
+        }
+
+        if (present) {
+            if (req->count == REQUEST_MAX_FIELDS) {
+                return "too many members";
+            }
+            req->fields[req->count++] = field;
+        }
+
+        p = skip_space(p);
+        if (*p == ',') {
+            p = skip_space(p + 1);
+        } else if (*p != '}') {
+            return "expected ',' or '}'";
+        }
+    }
+
+    p = skip_space(p + 1);
+    return *p == '\0' ? NULL : "unexpected characters after the object";
+}
+
+static const Field* find_field(const Request* req, const char* key) {
+    for (int i = req->count - 1; i >= 0; i--) {
+        if (strcmp(req->fields[i].key, key) == 0) {
+            return &req->fields[i];
+        }
+    }
+    return NULL;
+}
+
+static const char* string_field(const Request* req, const char* key) {
+    const Field* f = find_field(req, key);
+    return f && f->is_string ? f->text : NULL;
+}
+
+static bool int_field(const Request* req, const char* key, long long* out) {
+    const Field* f = find_field(req, key);
+    if (!f || f->is_string) {
+        return false;
+    }
+    *out = f->number;
+    return true;
+}
+
+/* ============================================
+ * COMMANDS
+ * ============================================ */
+
+static void fail(Reply* reply, const char* error) {
+    reply->kind = REPLY_ERROR;
+    reply->error = error;
+}
+
+/*
+ * An edit is applied in memory but its journal record could not be
+ * written. It cannot be taken back, and the next compaction would save
+ * it anyway, so the server stops rather than take edits it cannot vouch
+ * for; the client learns the edit's fate from the files after a restart.
+ */
+static void lose_edit(Server* s, Reply* reply) {
+    fprintf(stderr, "Error: Failed to journal an edit, stopping\n");
+    fail(reply, EDIT_NOT_SAVED);
+    s->lost = true;
+    s->stop = true;
+}
+
+static void add_task(Server* s, const Request* req, Reply* reply) {
+    const char* title = string_field(req, "title");
+    const char* subject = string_field(req, "subject");
+    const char* start = string_field(req, "start");
+    long long duration, priority = 5;
+    int hour, minute;
+    char extra;
+
+    if (!title) {
+        fail(reply, "title is required");
+        return;
+    }
+    if (!start || sscanf(start, "%d:%d%c", &hour, &minute, &extra) != 2 ||
+        hour < 0 || hour > 23 || minute < 0 || minute > 59) {
+        fail(reply, "start must be \"HH:MM\"");
+        return;
+    }
+    if (!int_field(req, "duration", &duration) || duration < 1 || duration > 24 * 60) {
+        fail(reply, "duration must be 1-1440 minutes");
+        return;
+    }
+    if (find_field(req, "priority") && (!int_field(req, "priority", &priority) || priority < 1 || priority > 10)) {
+        fail(reply, "priority must be 1-10");
+        return;
+    }
+
+    Task task = {0};
+    snprintf(task.title, sizeof(task.title), "%s", title);
+    snprintf(task.subject, sizeof(task.subject), "%s", subject ? subject : "");
+    task.start_time.hour = hour;
+    task.start_time.minute = minute;
+    task.duration_mins = (int)duration;
+    task.end_time = minutes_to_time(time_to_minutes(task.start_time) + task.duration_mins);
+    task.priority = (int)priority;
+    task.is_deep_work = (task.duration_mins >= DEEP_WORK_MIN_MINUTES);
+
+    int id = schedule_add_task(s->schedule, task);
+    if (id < 0) {
+        fail(reply, "out of memory");
+        return;
+    }
+    s->dirty = true;
+    if (schedule_log_add(s->schedule, s->schedule_file) != 0) {
+        lose_edit(s, reply);
+        return;
+    }
+    reply->edit = true;
+    reply->kind = REPLY_CREATED;
+    reply->value = id;
+}
+
+static void remove_task(Server* s, const Request* req, Reply* reply) {
+    long long id;
+    if (!int_field(req, "task_id", &id) || id < INT_MIN || id > INT_MAX) {
+        fail(reply, "task_id is required");
+        return;
+    }
+    if (schedule_remove_task(s->schedule, (int)id) != 0) {
+        fail(reply, "no such task");
+        return;
+    }
+    s->dirty = true;
+    if (schedule_log_remove(s->schedule, s->schedule_file, (int)id) != 0) {
+        lose_edit(s, reply);
+        return;
+    }
+    reply->edit = true;
+    reply->kind = REPLY_OK;
+}
+
+/* deadline is "YYYY-MM-DD HH:MM" local time, as --add-lab reads it, or Unix seconds */
+static bool parse_deadline(const Field* deadline, time_t* out) {
+    if (!deadline->is_string) {
+        *out = (time_t)deadline->number;
+        return true;
+    }
+    return parse_local_time(deadline->text, out);
+}
+
+static bool lab_id_field(const Request* req, int* id) {
+    long long value;
+    if (!int_field(req, "lab_id", &value) || value < INT_MIN || value > INT_MAX) {
+        return false;
+    }
+    *id = (int)value;
+    return true;
+}
+
+static void add_lab(Server* s, const Request* req, Reply* reply) {
+    const char* title = string_field(req, "title");
+    const char* subject = string_field(req, "subject");
+    const Field* deadline = find_field(req, "deadline");
+    long long credits = 0;
+
+    if (!title) {
+        fail(reply, "title is required");
+        return;
+    }
+    if (find_field(req, "credits") && (!int_field(req, "credits", &credits) || credits < 0 || credits > INT_MAX)) {
+        fail(reply, "credits must be a non-negative integer");
+        return;
+    }
+
+    LabReport report = {0};
+    if (!deadline) {
+        fail(reply, "deadline is required");
+        return;
+    }
+    if (!parse_deadline(deadline, &report.deadline)) {
+        fail(reply, "deadline must be \"YYYY-MM-DD HH:MM\"");
+        return;
+    }
+    snprintf(report.title, sizeof(report.title), "%s", title);
+    snprintf(report.subject, sizeof(report.subject), "%s", subject ? subject : "");
+    report.credits = (int)credits;
+
+    int id = pq_insert(s->pq, report);
+    if (id < 0) {
+        fail(reply, "out of memory");
+        return;
+    }
+    s->dirty = true;
+    if (pq_log_insert(s->pq, s->lab_file, id) != 0) {
+        lose_edit(s, reply);
+        return;
+    }
+    reply->edit = true;
+    reply->kind = REPLY_CREATED;
+    reply->value = id;
+}
+
+static void remove_lab(Server* s, const Request* req, Reply* reply) {
+    int id;
+    if (!lab_id_field(req, &id)) {
+        fail(reply, "lab_id is required");
+        return;
+    }
+    if (pq_remove(s->pq, id, NULL) != 0) {
+        fail(reply, "no such lab report");
+        return;
+    }
+    s->dirty = true;
+    if (pq_log_remove(s->pq, s->lab_file, id) != 0) {
+        lose_edit(s, reply);
+        return;
+    }
+    reply->edit = true;
+    reply->kind = REPLY_OK;
+}
+
+/* Either or both of deadline and completed; validated before anything changes */
+static void update_lab(Server* s, const Request* req, Reply* reply) {
+    const Field* deadline = find_field(req, "deadline");
+    const Field* completed = find_field(req, "completed");
+    time_t when = 0;
+    int id;
+
+    if (!lab_id_field(req, &id)) {
+        fail(reply, "lab_id is required");
+        return;
+    }
+    if (!pq_find(s->pq, id)) {
+        fail(reply, "no such lab report");
+        return;
+    }
+    if (!deadline && !completed) {
+        fail(reply, "deadline or completed is required");
+        return;
+    }
+    if (deadline && !parse_deadline(deadline, &when)) {
+        fail(reply, "deadline must be \"YYYY-MM-DD HH:MM\"");
+        return;
+    }
+    if (completed && completed->is_string) {
+        fail(reply, "completed must be a boolean");
+        return;
+    }
+
+    if (deadline) {
+        pq_update_deadline(s->pq, id, when);
+    }
+    if (completed) {
+        pq_set_completed(s->pq, id, completed->number != 0);
+    }
+    s->dirty = true;
+    if (pq_log_update(s->pq, s->lab_file, id) != 0) {
+        lose_edit(s, reply);
+        return;
+    }
+    reply->edit = true;
+    reply->kind = REPLY_OK;
+}
+
+static void list_queue(const Request* req, Reply* reply) {
+    const Field* before = find_field(req, "before");
+    long long limit = -1;
+
+    if (find_field(req, "limit") && (!int_field(req, "limit", &limit) || limit < 0 || limit > INT_MAX)) {
+        fail(reply, "limit must be a non-negative integer");
+        return;
+    }
+    reply->bounded = before != NULL;
+    if (before && !parse_deadline(before, &reply->before)) {
+        fail(reply, "before must be \"YYYY-MM-DD HH:MM\"");
+        return;
+    }
+    reply->limit = (int)limit;
+    reply->kind = REPLY_QUEUE;
+}
+
+static void execute(Server* s, const Request* req, Reply* reply) {
+    const char* cmd = string_field(req, "cmd");
+    reply->id = find_field(req, "id");
+    reply->kind = REPLY_OK;
+
+    if (!cmd) {
+        fail(reply, "cmd is required");
+    } else if (strcmp(cmd, "analyze-gaps") == 0) {
+        analyze_gaps(s->schedule);
+        reply->kind = REPLY_GAPS;
+    } else if (strcmp(cmd, "list-schedule") == 0) {
+        reply->kind = REPLY_SCHEDULE;
+    } else if (strcmp(cmd, "list-queue") == 0) {
+        list_queue(req, reply);
+    } else if (strcmp(cmd, "add-task") == 0) {
+        add_task(s, req, reply);
+    } else if (strcmp(cmd, "remove-task") == 0) {
+        remove_task(s, req, reply);
+    } else if (strcmp(cmd, "add-lab") == 0) {
+        add_lab(s, req, reply);
+    } else if (strcmp(cmd, "remove-lab") == 0) {
+        remove_lab(s, req, reply);
+    } else if (strcmp(cmd, "update-lab") == 0) {
+        update_lab(s, req, reply);
+    } else if (strcmp(cmd, "shutdown") == 0) {
+        s->stop = true;
+    } else {
+        fail(reply, "unknown cmd");
+    }
+}
+
+/* ============================================
+ * REPLIES
+ * ============================================ */
+
+static void render_reply(JsonWriter* w, Server* s, const Reply* reply) {
+    json_begin_object(w);
+    if (reply->id) {
+        json_key(w, "id");
+        if (reply->id->is_string) {
+            json_string(w, reply->id->text, strlen(reply->id->text));
+        } else {
+            json_int(w, reply->id->number);
+        }
+    }
+    json_key(w, "ok");
+    json_bool(w, reply->kind != REPLY_ERROR);
+
+    switch (reply->kind) {
+    case REPLY_ERROR:
+        json_key(w, "error");
+        json_string(w, reply->error, strlen(reply->error));
+        break;
+    case REPLY_OK:
+        break;
+    case REPLY_GAPS:
+        json_key(w, "result");
+        write_gaps_json(w, s->schedule);
+        break;
+    case REPLY_SCHEDULE:
+        json_key(w, "result");
+        write_schedule_json(w, s->schedule);
+        break;
+    case REPLY_QUEUE:
+        json_key(w, "result");
+        write_queue_listing_json(w, s->pq, reply->limit, reply->bounded ? &reply->before : NULL);
+        break;
+    case REPLY_CREATED:
+        json_key(w, "result");
+        json_begin_object(w);
+        json_key(w, "id");
+        json_int(w, reply->value);
+        json_end_object(w);
+        break;
+    }
+    json_end_object(w);
+    json_raw(w, "\n", 1);
+}
+
+/* Render into the client's output buffer, growing it if the reply does not fit.
+ * Returns the bytes appended (0 if the buffer could not grow) */
+static size_t queue_reply(Server* s, Client* c, const Reply* reply) {
+    if (c->out_sent > 0) {
+        memmove(c->out, c->out + c->out_sent, c->out_len - c->out_sent);
+        c->out_len -= c->out_sent;
+        c->out_sent = 0;
+    }
+
+    for (;;) {
+        JsonWriter w;
+        size_t room = c->out_cap - c->out_len;
+        json_writer_to_memory(&w, c->out ? c->out + c->out_len : NULL, room);
+        render_reply(&w, s, reply);
+        size_t n = json_writer_finish(&w);
+        if (n < room) {
+            c->out_len += n;
+            return n;
+        }
+
+        size_t cap = c->out_cap ? c->out_cap : REPLY_INITIAL_CAPACITY;
+        while (cap - c->out_len <= n) {
+            cap *= 2;
+        }
+        char* grown = (char*)realloc(c->out, cap);
+        if (!grown) {
+            fprintf(stderr, "Error: Failed to grow reply buffer\n");
+            c->eof = true;
+            c->broken = true;
+            return 0;
+        }
+        c->out = grown;
+        c->out_cap = cap;
+    }
+}
+
+static bool sync_edits(Server* s);
+
+/* Keep the error reply that replaces an edit's ok reply if the pass's sync fails */
+static bool track_edit(Server* s, Client* c, const Reply* reply, size_t start, size_t len) {
+    if (s->pending_count == s->pending_cap) {
+        int cap = s->pending_cap ? s->pending_cap * 2 : 16;
+        PendingEdit* grown = (PendingEdit*)realloc(s->pending, sizeof(PendingEdit) * (size_t)cap);
+        if (!grown) {
+            return false;
+        }
+        s->pending = grown;
+        s->pending_cap = cap;
+    }
+
+    Reply failure = *reply;
+    fail(&failure, EDIT_NOT_SAVED);
+    JsonWriter w;
+    json_writer_to_memory(&w, NULL, 0);
+    render_reply(&w, s, &failure);
+    size_t n = json_writer_finish(&w);
+    char* text = (char*)malloc(n + 1);
+    if (!text) {
+        return false;
+    }
+    json_writer_to_memory(&w, text, n + 1);
+    render_reply(&w, s, &failure);
+    json_writer_finish(&w);
+
+    PendingEdit* p = &s->pending[s->pending_count++];
+    p->client = (int)(c - s->clients);
+    p->start = start;
+    p->len = len;
+    p->failure = text;
+    p->failure_len = n;
+    return true;
+}
+
+static void handle_line(Server* s, Client* c, char* line) {
+    if (*skip_space(line) == '\0') {
+        return;                    /* Blank lines are ignored */
+    }
+
+    Request req;
+    Reply reply = {0};
+    const char* error = parse_request(line, &req);
+    if (error) {
+        fail(&reply, error);
+    } else if (s->stop) {
+        reply.id = find_field(&req, "id");
+        fail(&reply, SERVER_STOPPING);
+    } else {
+        execute(s, &req, &reply);
+    }
+
+    size_t n = queue_reply(s, c, &reply);
+
+    /* No memory to track the edit: commit it now and answer with the outcome */
+    if (reply.edit && n > 0 && !track_edit(s, c, &reply, c->out_len - n, n) && !sync_edits(s)) {
+        c->out_len -= n;           /* Still the last reply in the buffer */
+        fail(&reply, EDIT_NOT_SAVED);
+        queue_reply(s, c, &reply);
+    }
+}
+
+/* ============================================
+ * CLIENTS
+ * ============================================ */
+
+static bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/* Handle every complete line; bytes before scan_from hold no newline */
+static void process_lines(Server* s, Client* c, size_t scan_from) {
+    size_t start = 0;
+    for (size_t i = scan_from; i < c->in_len && !c->broken; i++) {
+        if (c->in[i] == '\n') {
+            c->in[i] = '\0';
+            handle_line(s, c, c->in + start);
+            start = i + 1;
+        }
+    }
+    memmove(c->in, c->in + start, c->in_len - start);
+    c->in_len -= start;
+}
+
+static void client_read(Server* s, Client* c) {
+    for (int reads = 0; reads < READS_PER_PASS && !c->eof; reads++) {
+        if (c->in_len == SERVER_LINE_MAX) {
+            Reply reply = {0};
+            fail(&reply, "request line too long");
+            queue_reply(s, c, &reply);
+            c->in_len = 0;
+            c->eof = true;
+            return;
+        }
+
+        ssize_t n = read(c->fd, c->in + c->in_len, SERVER_LINE_MAX - c->in_len);
+        if (n > 0) {
+            size_t scan_from = c->in_len;
+            c->in_len += (size_t)n;
+            process_lines(s, c, scan_from);
+        } else if (n == 0) {
+            c->eof = true;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                c->eof = true;
+                c->broken = true;
+            }
+            return;
+        }
+    }
+}
+
+static void client_write(Client* c) {
+    while (c->out_sent < c->out_len && !c->broken) {
+        ssize_t n = write(c->fd, c->out + c->out_sent, c->out_len - c->out_sent);
+        if (n > 0) {
+            c->out_sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        } else {
+            c->broken = true;
+        }
+    }
+    c->out_len = 0;
+    c->out_sent = 0;
+}
+
+static void client_close(Client* c) {
+    close(c->fd);
+    free(c->in);
+    free(c->out);
+}
+
+static void accept_clients(Server* s) {
+    for (;;) {
+        int fd = accept(s->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;                /* EAGAIN, or an aborted connection */
+        }
+
+        Client* c = &s->clients[s->client_count];
+        char* in = s->client_count < SERVER_MAX_CLIENTS ? (char*)malloc(SERVER_LINE_MAX) : NULL;
+        if (!in || !set_nonblocking(fd)) {
+            fprintf(stderr, "Warning: Refusing connection (%d clients)\n", s->client_count);
+            free(in);
+            close(fd);
+            continue;
+        }
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->in = in;
+        s->client_count++;
+    }
+}
+
+/* Swap a pending edit's ok reply for its error reply */
+static void fail_pending(Server* s, const PendingEdit* p) {
+    Client* c = &s->clients[p->client];
+    size_t tail = c->out_len - (p->start + p->len);
+    size_t len = c->out_len - p->len + p->failure_len;
+
+    if (len > c->out_cap) {
+        char* grown = (char*)realloc(c->out, len);
+        if (!grown) {
+            c->eof = true;         /* Never send the ok */
+            c->broken = true;
+            return;
+        }
+        c->out = grown;
+        c->out_cap = len;
+    }
+    memmove(c->out + p->start + p->failure_len, c->out + p->start + p->len, tail);
+    memcpy(c->out + p->start, p->failure, p->failure_len);
+    c->out_len = len;
+}
+
+/*
+ * Group commit for everything journaled in this pass. If it fails, the
+ * pass's edit replies become errors (latest first, so earlier offsets
+ * stay valid) and the server stops: those edits stay applied in memory
+ * and may already be on disk, so they are reported as possibly unsaved,
+ * never as undone. Returns false if the sync failed.
+ */
+static bool sync_edits(Server* s) {
+    bool failed = false;
+    if (s->dirty) {
+        failed = schedule_sync(s->schedule, s->schedule_file) != 0;
+        failed |= pq_sync(s->pq, s->lab_file) != 0;
+        if (failed) {
+            fprintf(stderr, "Error: Edits since the last sync may not be durable, stopping\n");
+            s->lost = true;
+            s->stop = true;
+        }
+        s->dirty = false;
+    }
+
+    for (int i = s->pending_count - 1; i >= 0; i--) {
+        if (failed) {
+            fail_pending(s, &s->pending[i]);
+        }
+        free(s->pending[i].failure);
+    }
+    s->pending_count = 0;
+    return !failed;
+}
+
+/* ============================================
+ * SOCKET
+ * ============================================ */
+
+static int open_socket(const char* path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Error: Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    /* Replace a socket left by a server that is gone, never a live one or a file */
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Error: %s exists and is not a socket\n", path);
+            close(fd);
+            return -1;
+        }
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            fprintf(stderr, "Error: A server is already listening on %s\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+        close(fd);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+            perror("socket");
+            return -1;
+        }
+    }
+
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        chmod(path, S_IRUSR | S_IWUSR) != 0 ||
+        listen(fd, SERVER_MAX_CLIENTS) != 0 ||
+        !set_nonblocking(fd)) {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* ============================================
+ * SERVE LOOP
+ * ============================================ */
+
+/* Give pending replies up to a second to drain before the server exits */
+static void drain_replies(Server* s) {
+    for (int round = 0; round < 100; round++) {
+        bool pending = false;
+        for (int i = 0; i < s->client_count; i++) {
+            Client* c = &s->clients[i];
+            client_write(c);
+            pending = pending || (c->out_sent < c->out_len && !c->broken);
+        }
+        if (!pending) {
+            return;
+        }
+        poll(NULL, 0, 10);
+    }
+}
+
+int serve_requests(const char* socket_path, DailySchedule* schedule, const char* schedule_file,
+                   PriorityQueue* pq, const char* lab_file) {
+    Server s;
+    memset(&s, 0, sizeof(s));
+    s.schedule = schedule;
+    s.schedule_file = schedule_file;
+    s.pq = pq;
+    s.lab_file = lab_file;
+
+    s.listen_fd = open_socket(socket_path);
+    if (s.listen_fd < 0) {
+        return -1;
+    }
+
+    struct sigaction stop, ignore, old_int, old_term, old_pipe;
+    memset(&stop, 0, sizeof(stop));
+    memset(&ignore, 0, sizeof(ignore));
+    stop.sa_handler = on_signal;       /* No SA_RESTART: poll returns EINTR */
+    ignore.sa_handler = SIG_IGN;
+    sigemptyset(&stop.sa_mask);
+    sigemptyset(&ignore.sa_mask);
+    g_signalled = 0;
+    sigaction(SIGINT, &stop, &old_int);
+    sigaction(SIGTERM, &stop, &old_term);
+    sigaction(SIGPIPE, &ignore, &old_pipe);
+
+    printf("Serving on %s\n", socket_path);
+    fflush(stdout);
+
+    struct pollfd fds[SERVER_MAX_CLIENTS + 1];
+    while (!s.stop && !g_signalled) {
+        fds[0].fd = s.listen_fd;
+        fds[0].events = POLLIN;
+        for (int i = 0; i < s.client_count; i++) {
+            Client* c = &s.clients[i];
+            fds[i + 1].fd = c->fd;
+            fds[i + 1].events = (short)((c->eof ? 0 : POLLIN) | (c->out_len > c->out_sent ? POLLOUT : 0));
+            fds[i + 1].revents = 0;
+        }
+
+        if (poll(fds, (nfds_t)s.client_count + 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("poll");
+            break;
+        }
+
+        int polled = s.client_count;
+        for (int i = 0; i < polled && !s.stop; i++) {
+            if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                client_read(&s, &s.clients[i]);
+            }
+        }
+
+        /* Replies go out only once the edits they acknowledge are durable */
+        sync_edits(&s);
+        for (int i = 0; i < s.client_count; i++) {
+            client_write(&s.clients[i]);
+        }
+
+        for (int i = s.client_count - 1; i >= 0; i--) {
+            Client* c = &s.clients[i];
+            if (c->broken || (c->eof && c->out_sent == c->out_len)) {
+                client_close(c);
+                s.clients[i] = s.clients[--s.client_count];
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            accept_clients(&s);
+        }
+    }
+
+    sync_edits(&s);
+    drain_replies(&s);
+    for (int i = 0; i < s.client_count; i++) {
+        client_close(&s.clients[i]);
+    }
+    close(s.listen_fd);
+    unlink(socket_path);
+    free(s.pending);
+
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    sigaction(SIGPIPE, &old_pipe, NULL);
+    printf("Server stopped\n");
+    return s.lost ? -1 : 0;
+}
+
+#endif /* _WIN32 */
@@ -0,0 +1,60 @@
+/*
+ * Personal Engineering OS - Scheduler Engine
+ * server.h - Request server over a Unix socket (--serve)
+ *
+ * Keeps the schedule and lab queue loaded and answers newline-delimited
+ * JSON requests, one flat object per line:
+ *
+ *   {"id": 1, "cmd": "analyze-gaps"}
+ *   {"id": 2, "cmd": "list-schedule"}
+ *   {"id": 3, "cmd": "list-queue", "limit": 5,
+ *    "before": "YYYY-MM-DD HH:MM"}              both optional
+ *   {"id": 4, "cmd": "add-task", "title": "...", "subject": "...",
+ *    "start": "HH:MM", "duration": 90, "priority": 5}
+ *   {"id": 5, "cmd": "remove-task", "task_id": 3}
+ *   {"id": 6, "cmd": "add-lab", "title": "...", "subject": "...",
+ *    "credits": 3, "deadline": "YYYY-MM-DD HH:MM"}
+ *   {"id": 7, "cmd": "update-lab", "lab_id": 2, "deadline": "...",
+ *    "completed": true}                        either or both
+ *   {"id": 8, "cmd": "remove-lab", "lab_id": 2}
+ *   {"id": 9, "cmd": "shutdown"}
+ *
+ * Each request gets one line back, in order:
+ *
+ *   {"id": 1, "ok": true, "result": <document as the CLI's --json>}
+ *   {"id": 4, "ok": false, "error": "..."}
+ *
+ * "id" is optional and echoed back when it is a number or string.
+ * Clients may pipeline: every complete line read in one pass is
+ * answered, edits go to the journals with a single sync for the whole
+ * pass, and only then are the replies written, so an "ok" for an edit
+ * means it is durable. If an edit cannot be journaled or synced, its
+ * reply is an error saying it may not have been saved, later requests
+ * get "server is stopping", and the server exits.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "scheduler.h"
+
+/* ============================================
+ * CONSTANTS
+ * ============================================ */
+
+#define SOCKET_FILE "scheduler.sock"
+#define SERVER_MAX_CLIENTS 64
+#define SERVER_LINE_MAX 65536          /* Longest request line */
+
+/* ============================================
+ * FUNCTION PROTOTYPES
+ * ============================================ */
+
+/* Serve on socket_path until a shutdown request, SIGINT, SIGTERM or an
+ * edit that could not be saved. The schedule persists to schedule_file
+ * and the queue to lab_file. Returns 0, or -1 if the socket cannot be set
+ * up (or on platforms without Unix sockets) or an edit was not saved */
+int serve_requests(const char* socket_path, DailySchedule* schedule, const char* schedule_file,
+                   PriorityQueue* pq, const char* lab_file);
+
+#endif /* SERVER_H */
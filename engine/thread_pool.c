@@ -0,0 +1,288 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * thread_pool.c - Work-stealing thread pool for batch solves
+ *
+ * Each worker owns a deque holding a contiguous block of job indices.
+ * Owners pop from the bottom of their own deque; idle workers steal from
+ * the top of someone else's. Because every job is known when pool_run
+ * starts, a deque never grows, and its whole state fits in one 64-bit
+ * word (top << 32 | bottom) that is updated with a single CAS.
+ */
+
+#ifndef _WIN32
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif
+
+#include "thread_pool.h"
+
+/* ============================================
+ * STRUCTURES
+ * ============================================ */
+
+/* One deque per worker, padded to its own cache line */
+typedef struct {
+    uint64_t range;            /* top index << 32 | bottom index */
+    char pad[64 - sizeof(uint64_t)];
+} PoolDeque;
+
+typedef struct {
+    ThreadPool* pool;
+    int index;
+} PoolWorkerArg;
+
+struct ThreadPool {
+    int n_threads;             /* Workers including the calling thread */
+    pthread_t* threads;        /* n_threads - 1 background workers */
+    PoolWorkerArg* args;
+    PoolDeque* deques;
+
+    pthread_mutex_t run_lock;  /* Serializes pool_run callers */
+    pthread_mutex_t lock;      /* Guards the fields below */
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    unsigned long generation;  /* Bumped once per pool_run */
+    int busy;                  /* Background workers still in this run */
+    bool shutdown;
+
+    PoolJobFn fn;
+    void* ctx;
+};
+
+/* ============================================
+ * DEQUE OPERATIONS
+ * ============================================ */
+
+static inline uint64_t pack_range(uint32_t top, uint32_t bottom) {
+    return ((uint64_t)top << 32) | bottom;
+}
+
+static void deque_reset(PoolDeque* dq, int lo, int hi) {
+    __atomic_store_n(&dq->range, pack_range((uint32_t)lo, (uint32_t)hi), __ATOMIC_RELAXED);
+}
+
+/* Owner side: take the highest remaining index */
+static bool deque_pop(PoolDeque* dq, int* index) {
+    uint64_t cur = __atomic_load_n(&dq->range, __ATOMIC_ACQUIRE);
+    while (true) {
+        uint32_t top = (uint32_t)(cur >> 32);
+        uint32_t bottom = (uint32_t)cur;
+        if (top >= bottom) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&dq->range, &cur, pack_range(top, bottom - 1),
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *index = (int)(bottom - 1);
+            return true;
+        }
+    }
+}
+
+/* Thief side: take the lowest remaining index */
+static bool deque_steal(PoolDeque* dq, int* index) {
+    uint64_t cur = __atomic_load_n(&dq->range, __ATOMIC_ACQUIRE);
+    while (true) {
+        uint32_t top = (uint32_t)(cur >> 32);
+        uint32_t bottom = (uint32_t)cur;
+        if (top >= bottom) {
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&dq->range, &cur, pack_range(top + 1, bottom),
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *index = (int)top;
+            return true;
+        }
+    }
+}
+
+/* ============================================
+ * WORKERS
+ * ============================================ */
+
+/* Drain the worker's own deque, then steal until every deque is empty */
+static void pool_work(ThreadPool* pool, int self) {
+    int index;
+
+    while (deque_pop(&pool->deques[self], &index)) {
+        pool->fn(pool->ctx, index, self);
+    }
+
+    while (true) {
+        bool stole = false;
+        for (int k = 1; k < pool->n_threads; k++) {
+            int victim = (self + k) % pool->n_threads;
+            if (deque_steal(&pool->deques[victim], &index)) {
+                pool->fn(pool->ctx, index, self);
+                stole = true;
+                break;
+            }
+        }
+        if (!stole) {
+            return;
+        }
+    }
+}
+
+static void* pool_thread_main(void* raw) {
+    PoolWorkerArg* arg = (PoolWorkerArg*)raw;
+    ThreadPool* pool = arg->pool;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->wake, &pool->lock);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool_work(pool, arg->index);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/* ============================================
+ * PUBLIC API
+ * ============================================ */
+
+int pool_cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+ThreadPool* pool_create(int n_threads) {
+    if (n_threads < 1) {
+        n_threads = 1;
+    }
+
+    ThreadPool* pool = (ThreadPool*)calloc(1, sizeof(ThreadPool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->n_threads = n_threads;
+    pool->deques = (PoolDeque*)calloc(n_threads, sizeof(PoolDeque));
+    pool->threads = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+    pool->args = (PoolWorkerArg*)calloc(n_threads, sizeof(PoolWorkerArg));
+    if (!pool->deques || !pool->threads || !pool->args) {
+        free(pool->deques);
+        free(pool->threads);
+        free(pool->args);
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    /* Start background workers; fall back to fewer if creation fails */
+    for (int i = 1; i < n_threads; i++) {
+        pool->args[i].pool = pool;
+        pool->args[i].index = i;
+        if (pthread_create(&pool->threads[i], NULL, pool_thread_main, &pool->args[i]) != 0) {
+            pool->n_threads = i;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+void pool_destroy(ThreadPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 1; i < pool->n_threads; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+
+    free(pool->deques);
+    free(pool->threads);
+    free(pool->args);
+    free(pool);
+}
+
+int pool_thread_count(const ThreadPool* pool) {
+    return pool ? pool->n_threads : 1;
+}
+
+void pool_run(ThreadPool* pool, int n_jobs, PoolJobFn fn, void* ctx) {
+    if (n_jobs <= 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    /* Not worth waking anyone for a single job */
+    if (pool->n_threads == 1 || n_jobs == 1) {
+        for (int i = 0; i < n_jobs; i++) {
+            fn(ctx, i, 0);
+        }
+        pthread_mutex_unlock(&pool->run_lock);
+        return;
+    }
+
+    /* Split jobs into contiguous blocks, one per worker */
+    for (int w = 0; w < pool->n_threads; w++) {
+        int lo = (int)((int64_t)n_jobs * w / pool->n_threads);
+        int hi = (int)((int64_t)n_jobs * (w + 1) / pool->n_threads);
+        deque_reset(&pool->deques[w], lo, hi);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->busy = pool->n_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+}
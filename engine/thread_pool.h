@@ -0,0 +1,30 @@
+/*
+ * AI Engineering Study Assistant - Scheduler Engine
+ * thread_pool.h - Work-stealing thread pool for batch solves
+ *
+ * A fixed set of worker threads runs "index jobs": pool_run(pool, n, fn, ctx)
+ * calls fn(ctx, i, worker) exactly once for every i in [0, n) and returns
+ * when all calls have finished. The calling thread takes part as worker 0.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+/* Job callback: index is the job number, worker is in [0, thread count) */
+typedef void (*PoolJobFn)(void* ctx, int index, int worker);
+
+typedef struct ThreadPool ThreadPool;
+
+/* Create a pool with n_threads workers in total (including the caller) */
+ThreadPool* pool_create(int n_threads);
+void pool_destroy(ThreadPool* pool);
+
+int pool_thread_count(const ThreadPool* pool);
+
+/* Run n_jobs jobs and block until all are done. Calls are serialized. */
+void pool_run(ThreadPool* pool, int n_jobs, PoolJobFn fn, void* ctx);
+
+/* Number of online CPUs (at least 1) */
+int pool_cpu_count(void);
+
+#endif /* THREAD_POOL_H */